@@ -2,52 +2,243 @@
 
 #include "byte_stream.hh"
 #include "eventloop.hh"
+#include "exception.hh"
+#include "mapped_file.hh"
 
+#include <array>
+#include <cerrno>
+#include <fcntl.h>
 #include <iostream>
+#include <memory>
+#include <optional>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/stat.h>
 #include <unistd.h>
 
 using namespace std;
 
-void bidirectional_stream_copy( Socket& socket, string_view peer_name )
+namespace {
+
+constexpr size_t buffer_size = 1048576;
+
+// The copy rules below are written against a "channel": a bounded buffer that
+// is filled from one fd and drained into another. StreamChannel buffers in a
+// user-space ByteStream; SpliceChannel keeps the bytes in the kernel.
+
+class StreamChannel
 {
-  constexpr size_t buffer_size = 1048576;
+public:
+  explicit StreamChannel( ByteStream::Storage storage ) : stream_( buffer_size, storage ) {}
 
-  EventLoop eventloop {};
-  FileDescriptor input { STDIN_FILENO };
-  FileDescriptor output { STDOUT_FILENO };
-  ByteStream outbound { buffer_size };
-  ByteStream inbound { buffer_size };
+  ByteStream& stream() { return stream_; }
+
+  void fill( FileDescriptor& source )
+  {
+    read_into( source, stream_.writer() );
+    if ( source.eof() ) {
+      stream_.writer().close();
+    }
+  }
+  void drain( FileDescriptor& sink ) { drain_to( stream_.reader(), sink ); }
+
+  bool can_fill() const
+  {
+    return stream_.writer().available_capacity() > 0 and not stream_.writer().is_closed();
+  }
+  uint64_t bytes_buffered() const { return stream_.reader().bytes_buffered(); }
+  bool is_finished() const { return stream_.reader().is_finished(); }
+  void close() { stream_.writer().close(); }
+  bool has_error() const { return stream_.has_error(); }
+  void set_error() { stream_.set_error(); }
+
+private:
+  ByteStream stream_;
+};
+
+#ifdef __linux__
+// Moves bytes fd -> pipe -> fd with splice(2), so they never enter user space.
+// The pipe is grown toward the same 1 MiB budget as the ByteStream path. If the
+// kernel turns splice down for either fd (EINVAL, ENOSYS), the channel falls back
+// to a StreamChannel for good, taking along whatever the pipe already holds.
+class SpliceChannel
+{
+public:
+  SpliceChannel() : SpliceChannel( make_pipe() ) {}
+
+  void fill( FileDescriptor& source )
+  {
+    if ( fallback_ ) {
+      fallback_->fill( source );
+      return;
+    }
+    const ssize_t moved = splice( source.fd_num(),
+                                  nullptr,
+                                  write_end_.fd_num(),
+                                  nullptr,
+                                  capacity_ - buffered_,
+                                  SPLICE_F_MOVE | SPLICE_F_NONBLOCK );
+    source.register_read();
+    if ( moved > 0 ) {
+      buffered_ += moved;
+    } else if ( moved == 0 ) {
+      closed_ = true; // EOF on the source
+    } else if ( errno == EAGAIN ) {
+      // Either the source has nothing yet, or the pipe is out of slots: its capacity is
+      // counted in page-sized slots, so many small splices can fill it early. Only the
+      // latter waits for a drain rather than for the source.
+      pipe_full_ = not writable( write_end_ );
+    } else if ( errno == EINVAL or errno == ENOSYS ) {
+      fall_back();
+      fallback_->fill( source );
+    } else {
+      throw unix_error { "splice" };
+    }
+  }
+
+  void drain( FileDescriptor& sink )
+  {
+    if ( fallback_ ) {
+      fallback_->drain( sink );
+      return;
+    }
+    const ssize_t moved
+      = splice( read_end_.fd_num(), nullptr, sink.fd_num(), nullptr, buffered_, SPLICE_F_MOVE | SPLICE_F_NONBLOCK );
+    sink.register_write();
+    if ( moved > 0 ) {
+      buffered_ -= moved;
+      pipe_full_ = false;
+    } else if ( moved < 0 and ( errno == EINVAL or errno == ENOSYS ) ) {
+      fall_back();
+      fallback_->drain( sink );
+    } else if ( moved < 0 and errno != EAGAIN ) {
+      throw unix_error { "splice" };
+    }
+  }
+
+  bool can_fill() const
+  {
+    return fallback_ ? fallback_->can_fill() : not closed_ and not pipe_full_ and buffered_ < capacity_;
+  }
+  uint64_t bytes_buffered() const { return fallback_ ? fallback_->bytes_buffered() : buffered_; }
+  bool is_finished() const { return fallback_ ? fallback_->is_finished() : closed_ and buffered_ == 0; }
+  void close()
+  {
+    closed_ = true;
+    if ( fallback_ ) {
+      fallback_->close();
+    }
+  }
+  bool has_error() const { return error_; }
+  void set_error()
+  {
+    error_ = true;
+    if ( fallback_ ) {
+      fallback_->set_error();
+    }
+  }
+
+private:
+  static bool writable( const FileDescriptor& fd )
+  {
+    pollfd pfd { fd.fd_num(), POLLOUT, 0 };
+    return CheckSystemCall( "poll", ::poll( &pfd, 1, 0 ) ) > 0;
+  }
+
+  // Switch to the ByteStream path, moving the bytes already in the pipe into it first.
+  void fall_back()
+  {
+    fallback_.emplace( ByteStream::Storage::MirroredRing );
+    Writer& writer = fallback_->stream().writer();
+    while ( buffered_ > 0 ) {
+      const uint64_t moved = read_into( read_end_, writer );
+      if ( moved == 0 ) {
+        throw runtime_error( "SpliceChannel: pipe held fewer bytes than expected" );
+      }
+      buffered_ -= moved;
+    }
+    if ( closed_ ) {
+      writer.close();
+    }
+    if ( error_ ) {
+      fallback_->set_error();
+    }
+  }
+
+  static array<int, 2> make_pipe()
+  {
+    array<int, 2> fds {};
+    CheckSystemCall( "pipe2", pipe2( fds.data(), O_NONBLOCK | O_CLOEXEC ) );
+    return fds;
+  }
+
+  explicit SpliceChannel( array<int, 2> fds )
+    : read_end_( fds[0] )
+    , write_end_( fds[1] )
+    , capacity_( grow_pipe( fds[1] ) )
+  {}
+
+  // Best effort: unprivileged processes are capped by fs.pipe-max-size (1 MiB by default).
+  static uint64_t grow_pipe( int fd )
+  {
+    fcntl( fd, F_SETPIPE_SZ, buffer_size );
+    return CheckSystemCall( "fcntl(F_GETPIPE_SZ)", fcntl( fd, F_GETPIPE_SZ ) );
+  }
+
+  FileDescriptor read_end_;
+  FileDescriptor write_end_;
+  uint64_t capacity_;
+  uint64_t buffered_ {};
+  bool pipe_full_ {};
+  bool closed_ {};
+  bool error_ {};
+  optional<StreamChannel> fallback_ {};
+};
+
+// splice(2) needs kernel support on both ends: pipes and sockets work, as do
+// regular files (except O_APPEND ones as a destination). Terminals do not.
+bool splice_supported( const FileDescriptor& fd, bool as_sink )
+{
+  struct stat st {};
+  if ( fstat( fd.fd_num(), &st ) < 0 ) {
+    return false;
+  }
+  if ( S_ISFIFO( st.st_mode ) or S_ISSOCK( st.st_mode ) ) {
+    return true;
+  }
+  return S_ISREG( st.st_mode ) and not( as_sink and ( fcntl( fd.fd_num(), F_GETFL ) & O_APPEND ) );
+}
+#endif
+
+// rules 1-4: stdin -> outbound -> socket, socket -> inbound -> stdout
+// (rule 1 is left to the caller when the outbound bytes come from elsewhere)
+template<class Channel>
+void copy_until_finished( EventLoop& eventloop,
+                          Socket& socket,
+                          string_view peer_name,
+                          FileDescriptor* input,
+                          FileDescriptor& output,
+                          Channel& outbound,
+                          Channel& inbound )
+{
   bool outbound_shutdown { false };
   bool inbound_shutdown { false };
 
-  socket.set_blocking( false );
-  input.set_blocking( false );
-  output.set_blocking( false );
-
   // rule 1: read from stdin into outbound byte stream
-  eventloop.add_rule(
-    "read from stdin into outbound byte stream",
-    input,
-    Direction::In,
-    [&] {
-      string data;
-      data.resize( outbound.writer().available_capacity() );
-      input.read( data );
-      outbound.writer().push( move( data ) );
-      if ( input.eof() ) {
-        outbound.writer().close();
-      }
-    },
-    [&] {
-      return !outbound.has_error() and !inbound.has_error() and ( outbound.writer().available_capacity() > 0 )
-             and !outbound.writer().is_closed();
-    },
-    [&] { outbound.writer().close(); },
-    [&] {
-      cerr << "DEBUG: Outbound stream had error from source.\n";
-      outbound.set_error();
-      inbound.set_error();
-    } );
+  if ( input ) {
+    eventloop.add_rule(
+      "read from stdin into outbound byte stream",
+      *input,
+      Direction::In,
+      [&] { outbound.fill( *input ); },
+      [&] { return !outbound.has_error() and !inbound.has_error() and outbound.can_fill(); },
+      [&] { outbound.close(); },
+      [&] {
+        cerr << "DEBUG: Outbound stream had error from source.\n";
+        outbound.set_error();
+        inbound.set_error();
+      } );
+  }
 
   // rule 2: read from outbound byte stream into socket
   eventloop.add_rule(
@@ -55,19 +246,17 @@ void bidirectional_stream_copy( Socket& socket, string_view peer_name )
     socket,
     Direction::Out,
     [&] {
-      if ( outbound.reader().bytes_buffered() ) {
-        outbound.reader().pop( socket.write( outbound.reader().peek() ) );
+      if ( outbound.bytes_buffered() ) {
+        outbound.drain( socket );
       }
-      if ( outbound.reader().is_finished() ) {
+      if ( outbound.is_finished() ) {
         socket.shutdown( SHUT_WR );
         outbound_shutdown = true;
         cerr << "DEBUG: Outbound stream to " << peer_name << " finished.\n";
       }
     },
-    [&] {
-      return outbound.reader().bytes_buffered() or ( outbound.reader().is_finished() and not outbound_shutdown );
-    },
-    [&] { outbound.writer().close(); },
+    [&] { return outbound.bytes_buffered() or ( outbound.is_finished() and not outbound_shutdown ); },
+    [&] { outbound.close(); },
     [&] {
       cerr << "DEBUG: Outbound stream had error from destination.\n";
       outbound.set_error();
@@ -79,20 +268,9 @@ void bidirectional_stream_copy( Socket& socket, string_view peer_name )
     "read from socket into inbound byte stream",
     socket,
     Direction::In,
-    [&] {
-      string data;
-      data.resize( inbound.writer().available_capacity() );
-      socket.read( data );
-      inbound.writer().push( move( data ) );
-      if ( socket.eof() ) {
-        inbound.writer().close();
-      }
-    },
-    [&] {
-      return !inbound.has_error() and !outbound.has_error() and ( inbound.writer().available_capacity() > 0 )
-             and !inbound.writer().is_closed();
-    },
-    [&] { inbound.writer().close(); },
+    [&] { inbound.fill( socket ); },
+    [&] { return !inbound.has_error() and !outbound.has_error() and inbound.can_fill(); },
+    [&] { inbound.close(); },
     [&] {
       cerr << "DEBUG: Inbound stream had error from source.\n";
       outbound.set_error();
@@ -105,20 +283,18 @@ void bidirectional_stream_copy( Socket& socket, string_view peer_name )
     output,
     Direction::Out,
     [&] {
-      if ( inbound.reader().bytes_buffered() ) {
-        inbound.reader().pop( output.write( inbound.reader().peek() ) );
+      if ( inbound.bytes_buffered() ) {
+        inbound.drain( output );
       }
-      if ( inbound.reader().is_finished() ) {
+      if ( inbound.is_finished() ) {
         output.close();
         inbound_shutdown = true;
         cerr << "DEBUG: Inbound stream from " << peer_name << " finished"
              << ( inbound.has_error() ? " uncleanly.\n" : ".\n" );
       }
     },
-    [&] {
-      return inbound.reader().bytes_buffered() or ( inbound.reader().is_finished() and not inbound_shutdown );
-    },
-    [&] { inbound.writer().close(); },
+    [&] { return inbound.bytes_buffered() or ( inbound.is_finished() and not inbound_shutdown ); },
+    [&] { inbound.close(); },
     [&] {
       cerr << "DEBUG: Inbound stream had error from destination.\n";
       outbound.set_error();
@@ -132,3 +308,69 @@ void bidirectional_stream_copy( Socket& socket, string_view peer_name )
     }
   }
 }
+
+} // namespace
+
+void bidirectional_stream_copy( Socket& socket, string_view peer_name, const string& input_file )
+{
+  EventLoop eventloop {};
+  FileDescriptor input { STDIN_FILENO };
+  FileDescriptor output { STDOUT_FILENO };
+
+  socket.set_blocking( false );
+  input.set_blocking( false );
+  output.set_blocking( false );
+
+  const bool from_file = not input_file.empty();
+
+#ifdef __linux__
+  // Both ends are kernel fds: move the bytes with splice(2) and skip user space entirely.
+  if ( not from_file and splice_supported( input, false ) and splice_supported( output, true )
+       and splice_supported( socket, false ) ) {
+    SpliceChannel outbound;
+    SpliceChannel inbound;
+    copy_until_finished( eventloop, socket, peer_name, &input, output, outbound, inbound );
+    return;
+  }
+#endif
+
+  // Mirrored rings let read_into() land kernel reads directly in stream storage. A mapped input
+  // file is instead borrowed slice by slice, which needs the segmented representation.
+  StreamChannel outbound { from_file ? ByteStream::Storage::Segmented : ByteStream::Storage::MirroredRing };
+  StreamChannel inbound { ByteStream::Storage::MirroredRing };
+
+  if ( not from_file ) {
+    copy_until_finished( eventloop, socket, peer_name, &input, output, outbound, inbound );
+    return;
+  }
+
+  // rule 1 (file mode): lend successive slices of the mapped file to the outbound byte stream
+  const shared_ptr<const MappedFile> file = make_shared<MappedFile>( input_file );
+  Writer& writer = outbound.stream().writer();
+  eventloop.add_rule(
+    "push mapped file into outbound byte stream",
+    [&, file] {
+      writer.push( SharedSlice { file, file->view().substr( writer.bytes_pushed() ) } );
+      if ( writer.bytes_pushed() == file->view().size() ) {
+        writer.close();
+      }
+    },
+    [&] { return !outbound.has_error() and !inbound.has_error() and outbound.can_fill(); } );
+
+  copy_until_finished( eventloop, socket, peer_name, nullptr, output, outbound, inbound );
+}
+
+void inbound_stream_copy( Socket& socket, string_view peer_name )
+{
+  EventLoop eventloop {};
+  FileDescriptor output { STDOUT_FILENO };
+
+  socket.set_blocking( false );
+  output.set_blocking( false );
+
+  StreamChannel outbound { ByteStream::Storage::Segmented };
+  StreamChannel inbound { ByteStream::Storage::MirroredRing };
+  outbound.close();
+
+  copy_until_finished( eventloop, socket, peer_name, nullptr, output, outbound, inbound );
+}
@@ -2,5 +2,16 @@
 
 #include "socket.hh"
 
+#include <string>
+
 //! Copy socket input/output to stdin/stdout until finished
-void bidirectional_stream_copy( Socket& socket, std::string_view peer_name );
+//! \param[in] input_file if non-empty, send this file instead of reading stdin. The outbound
+//!                       stream borrows slices of a read-only mapping, so the first copy of
+//!                       each byte is the write(2) into `socket`. For a kernel TCPSocket that
+//!                       is the only one; a TCPMinnowSocket should use send_file() and
+//!                       inbound_stream_copy() instead, to skip its owner-to-TCP-thread hop.
+void bidirectional_stream_copy( Socket& socket, std::string_view peer_name, const std::string& input_file = {} );
+
+//! Copy socket input to stdout, shutting down the socket's outbound direction at once
+//! because its bytes come from elsewhere (e.g. TCPMinnowSocket::send_file())
+void inbound_stream_copy( Socket& socket, std::string_view peer_name );
@@ -68,10 +68,33 @@ private:
   struct Sender : public NetworkInterface::OutputPort
   {
     pair<FileDescriptor, FileDescriptor> sockets { make_socket_pair() };
+    optional<vector<EthernetFrame>> batch {}; // frames held for one sendmmsg(2) while batching
 
     void transmit( const NetworkInterface& n [[maybe_unused]], const EthernetFrame& x ) override
     {
-      sockets.first.write( serialize( x ) );
+      if ( batch ) {
+        batch->push_back( clone( x ) );
+      } else {
+        sockets.first.write( serialize( x ) );
+      }
+    }
+
+    void send_batch()
+    {
+      vector<vector<Ref<string>>> wire;
+      vector<vector<string_view>> datagrams;
+      wire.reserve( batch->size() );
+      datagrams.reserve( batch->size() );
+      for ( const EthernetFrame& frame : *batch ) {
+        auto& views = datagrams.emplace_back();
+        for ( const auto& buf : wire.emplace_back( serialize( frame ) ) ) {
+          views.emplace_back( buf.get() );
+        }
+      }
+      if ( not datagrams.empty() ) {
+        sockets.first.write_datagrams( datagrams );
+      }
+      batch.reset();
     }
   };
 
@@ -108,6 +131,14 @@ public:
     return unwrap_tcp_in_ip( move( dgram ) );
   }
   void write( const TCPMessage& msg ) { _interface.send_datagram( wrap_tcp_in_ip( msg ), _next_hop ); }
+  void write_batch( span<const TCPMessage> msgs )
+  {
+    sender_->batch.emplace();
+    for ( const TCPMessage& msg : msgs ) {
+      write( msg );
+    }
+    sender_->send_batch();
+  }
   void tick( const size_t ms_since_last_tick ) { _interface.tick( ms_since_last_tick ); }
   NetworkInterface& interface() { return _interface; }
 
@@ -156,7 +187,11 @@ public:
 };
 
 // NOLINTBEGIN(*-cognitive-complexity)
-void program_body( bool is_client, const string& bounce_host, const string& bounce_port, const bool debug )
+void program_body( bool is_client,
+                   const string& bounce_host,
+                   const string& bounce_port,
+                   const bool debug,
+                   const string& input_file )
 {
   class FramesOut : public NetworkInterface::OutputPort
   {
@@ -290,6 +325,10 @@ void program_body( bool is_client, const string& bounce_host, const string& boun
   } );
 
   try {
+    if ( not input_file.empty() ) {
+      sock.send_file( make_shared<MappedFile>( input_file ) );
+    }
+
     if ( is_client ) {
       sock.connect( Address { "172.16.0.100", 1234 } );
     } else {
@@ -297,7 +336,11 @@ void program_body( bool is_client, const string& bounce_host, const string& boun
       sock.listen_and_accept();
     }
 
-    bidirectional_stream_copy( sock, "172.16.0.100" );
+    if ( input_file.empty() ) {
+      bidirectional_stream_copy( sock, "172.16.0.100" );
+    } else {
+      inbound_stream_copy( sock, "172.16.0.100" );
+    }
     sock.wait_until_closed();
   } catch ( const exception& e ) {
     cerr << "Exception: " << e.what() << "\n";
@@ -312,8 +355,9 @@ void program_body( bool is_client, const string& bounce_host, const string& boun
 
 void print_usage( const string& argv0 )
 {
-  cerr << "Usage: " << argv0 << " client HOST PORT [debug]\n";
-  cerr << "or     " << argv0 << " server HOST PORT [debug]\n";
+  cerr << "Usage: " << argv0 << " client HOST PORT [debug] [--file PATH]\n";
+  cerr << "or     " << argv0 << " server HOST PORT [debug] [--file PATH]\n";
+  cerr << "\n  --file PATH sends PATH (memory-mapped) instead of stdin.\n";
 }
 
 int main( int argc, char* argv[] )
@@ -329,7 +373,7 @@ int main( int argc, char* argv[] )
       abort(); // For sticklers: don't try to access argv[0] if argc <= 0.
     }
 
-    if ( argc != 4 and argc != 5 ) {
+    if ( argc < 4 ) {
       print_usage( args[0] );
       return EXIT_FAILURE;
     }
@@ -339,7 +383,20 @@ int main( int argc, char* argv[] )
       return EXIT_FAILURE;
     }
 
-    program_body( args[1] == "client"s, args[2], args[3], argc == 5 );
+    bool debug = false;
+    string input_file;
+    for ( size_t i = 4; i < args.size(); ++i ) {
+      if ( args[i] == "debug"s ) {
+        debug = true;
+      } else if ( args[i] == "--file"s and i + 1 < args.size() ) {
+        input_file = args[++i];
+      } else {
+        print_usage( args[0] );
+        return EXIT_FAILURE;
+      }
+    }
+
+    program_body( args[1] == "client"s, args[2], args[3], debug, input_file );
   } catch ( const exception& e ) {
     cerr << e.what() << "\n";
     return EXIT_FAILURE;
@@ -7,9 +7,11 @@
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <memory>
 #include <random>
 #include <span>
 #include <string>
+#include <string_view>
 #include <tuple>
 
 using namespace std;
@@ -33,6 +35,13 @@ void show_usage( const char* argv0, const char* msg )
        << "   -w <winsz>      Use a window of <winsz> bytes                   " << TCPConfig::MAX_PAYLOAD_SIZE
        << "\n\n"
 
+       << "   -m <mss>        Send segments of up to <mss> payload bytes      " << TCPConfig::MAX_PAYLOAD_SIZE
+       << "\n\n"
+
+       << "   -c <cc>         Congestion control: newreno, cubic, bbr, none   newreno\n\n"
+
+       << "   -s              Hold out-of-order bytes as segment slices       (bitmap)\n\n"
+
        << "   -t <tmout>      Set rt_timeout to tmout                         " << TCPConfig::TIMEOUT_DFLT << "\n\n"
 
        << "   -d <tundev>     Connect to tun <tundev>                         " << TUN_DFLT << "\n\n"
@@ -40,6 +49,8 @@ void show_usage( const char* argv0, const char* msg )
        << "   -Lu <loss>      Set uplink loss to <rate> (float in 0..1)       (no loss)\n"
        << "   -Ld <loss>      Set downlink loss to <rate> (float in 0..1)     (no loss)\n\n"
 
+       << "   --file <path>   Send <path> (memory-mapped) instead of stdin    (stdin)\n\n"
+
        << "   -h              Show this message.\n\n";
 
   if ( msg != nullptr ) {
@@ -56,13 +67,14 @@ void check_argc( const span<char*>& args, size_t curr, const char* err )
   }
 }
 
-tuple<TCPConfig, FdAdapterConfig, bool, const char*> get_config( const span<char*>& args )
+tuple<TCPConfig, FdAdapterConfig, bool, const char*, string> get_config( const span<char*>& args )
 {
   TCPConfig c_fsm {};
   c_fsm.isn = Wrap32 { random_device()() };
 
   FdAdapterConfig c_filt {};
   const char* tundev = nullptr;
+  string input_file;
 
   size_t curr = 1;
   bool listen = false;
@@ -91,6 +103,37 @@ tuple<TCPConfig, FdAdapterConfig, bool, const char*> get_config( const span<char
       c_fsm.recv_capacity = strtol( args[curr + 1], nullptr, 0 );
       curr += 2;
 
+    } else if ( strncmp( "-m", args[curr], 3 ) == 0 ) {
+      check_argc( args, curr, "ERROR: -m requires one argument." );
+      const long mss = strtol( args[curr + 1], nullptr, 0 );
+      if ( mss <= 0 ) {
+        show_usage( args[0], "ERROR: -m requires a positive number of bytes." );
+        exit( 1 );
+      }
+      c_fsm.mss = mss;
+      curr += 2;
+
+    } else if ( strncmp( "-c", args[curr], 3 ) == 0 ) {
+      check_argc( args, curr, "ERROR: -c requires one argument." );
+      const string_view name = args[curr + 1];
+      if ( name == "newreno" ) {
+        c_fsm.congestion_control = CongestionControlAlgorithm::NewReno;
+      } else if ( name == "cubic" ) {
+        c_fsm.congestion_control = CongestionControlAlgorithm::Cubic;
+      } else if ( name == "bbr" ) {
+        c_fsm.congestion_control = CongestionControlAlgorithm::Bbr;
+      } else if ( name == "none" ) {
+        c_fsm.congestion_control = CongestionControlAlgorithm::None;
+      } else {
+        show_usage( args[0], "ERROR: -c requires newreno, cubic, bbr or none." );
+        exit( 1 );
+      }
+      curr += 2;
+
+    } else if ( strncmp( "-s", args[curr], 3 ) == 0 ) {
+      c_fsm.reassembler_tracking = Reassembler::Tracking::Slices;
+      curr += 1;
+
     } else if ( strncmp( "-t", args[curr], 3 ) == 0 ) {
       check_argc( args, curr, "ERROR: -t requires one argument." );
       c_fsm.rt_timeout = strtol( args[curr + 1], nullptr, 0 );
@@ -117,6 +160,11 @@ tuple<TCPConfig, FdAdapterConfig, bool, const char*> get_config( const span<char
         = static_cast<LossRateDnT>( static_cast<float>( numeric_limits<LossRateDnT>::max() ) * lossrate );
       curr += 2;
 
+    } else if ( strncmp( "--file", args[curr], 7 ) == 0 ) {
+      check_argc( args, curr, "ERROR: --file requires one argument." );
+      input_file = args[curr + 1];
+      curr += 2;
+
     } else if ( strncmp( "-h", args[curr], 3 ) == 0 ) {
       show_usage( args[0], nullptr );
       exit( 0 );
@@ -139,7 +187,7 @@ tuple<TCPConfig, FdAdapterConfig, bool, const char*> get_config( const span<char
     c_filt.source = { source_address, source_port };
   }
 
-  return make_tuple( c_fsm, c_filt, listen, tundev );
+  return make_tuple( c_fsm, c_filt, listen, tundev, input_file );
 }
 } // namespace
 
@@ -157,17 +205,25 @@ int main( int argc, char** argv )
       return EXIT_FAILURE;
     }
 
-    auto [c_fsm, c_filt, listen, tun_dev_name] = get_config( args );
+    auto [c_fsm, c_filt, listen, tun_dev_name, input_file] = get_config( args );
     LossyTCPOverIPv4MinnowSocket tcp_socket( LossyFdAdapter<TCPOverIPv4OverTunFdAdapter>(
       TCPOverIPv4OverTunFdAdapter( TunFD( tun_dev_name == nullptr ? TUN_DFLT : tun_dev_name ) ) ) );
 
+    if ( not input_file.empty() ) {
+      tcp_socket.send_file( make_shared<MappedFile>( input_file ) );
+    }
+
     if ( listen ) {
       tcp_socket.listen_and_accept( c_fsm, c_filt );
     } else {
       tcp_socket.connect( c_fsm, c_filt );
     }
 
-    bidirectional_stream_copy( tcp_socket, tcp_socket.peer_address().to_string() );
+    if ( input_file.empty() ) {
+      bidirectional_stream_copy( tcp_socket, tcp_socket.peer_address().to_string() );
+    } else {
+      inbound_stream_copy( tcp_socket, tcp_socket.peer_address().to_string() );
+    }
     tcp_socket.wait_until_closed();
   } catch ( const exception& e ) {
     cerr << "Exception: " << e.what() << "\n";
@@ -4,12 +4,15 @@
 #include <cstring>
 #include <iostream>
 #include <span>
+#include <string>
+#include <vector>
 
 using namespace std;
 
 void show_usage( const char* argv0 )
 {
-  cerr << "Usage: " << argv0 << " [-l] <host> <port>\n\n"
+  cerr << "Usage: " << argv0 << " [--file <path>] [-l] <host> <port>\n\n"
+       << "  --file sends <path> (memory-mapped) instead of stdin.\n"
        << "  -l specifies listen mode; <host>:<port> is the listening address.\n";
 }
 
@@ -22,19 +25,35 @@ int main( int argc, char** argv )
 
     auto args = span( argv, argc );
 
+    string input_file;
     bool server_mode = false;
-    // NOLINTNEXTLINE(bugprone-assignment-*)
-    if ( argc < 3 || ( ( server_mode = ( strncmp( "-l", args[1], 3 ) == 0 ) ) && argc < 4 ) ) {
-      show_usage( args[0] );
+    vector<const char*> positional; // <host> <port>
+    for ( size_t i = 1; i < args.size(); ++i ) {
+      if ( strncmp( "--file", args[i], 7 ) == 0 ) {
+        if ( i + 1 == args.size() ) {
+          show_usage( argv[0] );
+          return EXIT_FAILURE;
+        }
+        input_file = args[++i];
+      } else if ( strncmp( "-l", args[i], 3 ) == 0 ) {
+        server_mode = true;
+      } else {
+        positional.push_back( args[i] );
+      }
+    }
+    if ( positional.size() != 2 ) {
+      show_usage( argv[0] );
       return EXIT_FAILURE;
     }
+    const char* host = positional[0];
+    const char* port = positional[1];
 
     // in client mode, connect; in server mode, accept exactly one connection
     auto socket = [&] {
       if ( server_mode ) {
         TCPSocket listening_socket;                    // create a TCP socket
         listening_socket.set_reuseaddr();              // reuse the server's address as soon as the program quits
-        listening_socket.bind( { args[2], args[3] } ); // bind to specified address
+        listening_socket.bind( { host, port } );       // bind to specified address
         listening_socket.listen();                     // mark the socket as listening for incoming connections
         cerr << "DEBUG: Listening for incoming connection...\n";
         TCPSocket connected_socket = listening_socket.accept();
@@ -42,14 +61,14 @@ int main( int argc, char** argv )
         return connected_socket;
       }
       TCPSocket connecting_socket;
-      const Address peer { args[1], args[2] };
+      const Address peer { host, port };
       cerr << "DEBUG: Connecting to " << peer.to_string() << "... ";
       connecting_socket.connect( peer );
       cerr << "DEBUG: Successfully connected to " << connecting_socket.peer_address().to_string() << ".\n";
       return connecting_socket;
     }();
 
-    bidirectional_stream_copy( socket, socket.peer_address().to_string() );
+    bidirectional_stream_copy( socket, socket.peer_address().to_string(), input_file );
   } catch ( const exception& e ) {
     cerr << "Exception: " << e.what() << "\n";
     return EXIT_FAILURE;
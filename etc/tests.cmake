@@ -23,6 +23,12 @@ ttest(byte_stream_one_write)
 ttest(byte_stream_two_writes)
 ttest(byte_stream_many_writes)
 ttest(byte_stream_stress_test)
+ttest(byte_stream_ring)
+ttest(byte_stream_reserve)
+ttest(byte_stream_spans)
+ttest(byte_stream_shared)
+ttest(byte_stream_spsc)
+ttest(byte_stream_watermarks)
 
 ttest(reassembler_single)
 ttest(reassembler_cap)
@@ -32,6 +38,13 @@ ttest(reassembler_holes)
 ttest(reassembler_overlapping)
 ttest(reassembler_win)
 
+# The same tests again, with the Reassembler holding pending bytes as slices of the inserted strings
+foreach (name reassembler_single reassembler_cap reassembler_seq reassembler_dup
+         reassembler_holes reassembler_overlapping reassembler_win recv_reorder recv_reorder_more recv_sack)
+  add_test(NAME ${name}_slices COMMAND "${name}_sanitized")
+  set_tests_properties(${name}_slices PROPERTIES FIXTURES_REQUIRED compile ENVIRONMENT REASSEMBLER_TRACKING=slices)
+endforeach ()
+
 ttest(wrapping_integers_cmp)
 ttest(wrapping_integers_wrap)
 ttest(wrapping_integers_unwrap)
@@ -45,6 +58,7 @@ ttest(recv_reorder)
 ttest(recv_reorder_more)
 ttest(recv_close)
 ttest(recv_special)
+ttest(recv_sack)
 
 ttest(send_connect)
 ttest(send_transmit)
@@ -53,6 +67,13 @@ ttest(send_ack)
 ttest(send_close)
 ttest(send_retx)
 ttest(send_extra)
+ttest(send_congestion)
+ttest(send_rto)
+ttest(send_recovery)
+ttest(send_sack)
+ttest(send_pacing)
+ttest(send_buffer)
+ttest(send_mss)
 
 ttest(net_interface)
 
@@ -93,4 +114,7 @@ set_property(TEST ${compile_name_opt} PROPERTY TIMEOUT 0)
 set_tests_properties(${compile_name_opt} PROPERTIES FIXTURES_SETUP compile_opt)
 
 stest(byte_stream_speed_test)
+stest(byte_stream_benchmark)
 stest(reassembler_speed_test)
+stest(wrapping_integers_benchmark)
+stest(congestion_control_benchmark)
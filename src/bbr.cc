@@ -0,0 +1,231 @@
+#include "bbr.hh"
+
+#include <algorithm>
+
+using namespace std;
+
+Bbr::Bbr( uint64_t mss ) : mss_( mss ), initial_cwnd_( initial_window( mss ) ), cwnd_( initial_cwnd_ ) {}
+
+optional<uint64_t> Bbr::min_rtt_ms() const
+{
+  return min_rtt_ms_ == NO_RTT ? nullopt : optional { min_rtt_ms_ };
+}
+
+uint64_t Bbr::bdp() const
+{
+  if ( btl_bw_ == 0 or min_rtt_ms_ == NO_RTT ) {
+    return initial_cwnd_;
+  }
+  return btl_bw_ * min_rtt_ms_ / 1000;
+}
+
+uint64_t Bbr::target_cwnd( double gain ) const
+{
+  return max( static_cast<uint64_t>( gain * static_cast<double>( bdp() ) ), min_cwnd() );
+}
+
+optional<uint64_t> Bbr::pacing_rate() const
+{
+  if ( btl_bw_ == 0 ) {
+    return nullopt;
+  }
+  return static_cast<uint64_t>( pacing_gain_ * static_cast<double>( btl_bw_ ) );
+}
+
+void Bbr::on_ack( const AckSample& ack )
+{
+  // Leaving timeout recovery once everything in flight at the time is acknowledged.
+  if ( in_recovery_ and ack.ackno >= recovery_end_ ) {
+    in_recovery_ = false;
+    cwnd_ = max( cwnd_, prior_cwnd_ );
+  }
+  last_ackno_ = ack.ackno;
+
+  update_round( ack );
+  update_bandwidth( ack );
+  update_cycle_phase( ack );
+  check_full_pipe( ack );
+  check_drain( ack );
+  update_min_rtt( ack );
+  check_probe_rtt( ack );
+  set_cwnd( ack );
+}
+
+void Bbr::update_round( const AckSample& ack )
+{
+  round_start_ = false;
+  if ( ack.rate.has_value() and ack.rate->prior_delivered >= next_round_delivered_ ) {
+    next_round_delivered_ = ack.delivered;
+    ++round_count_;
+    round_start_ = true;
+  }
+}
+
+void Bbr::update_bandwidth( const AckSample& ack )
+{
+  if ( not ack.rate.has_value() ) {
+    return;
+  }
+  // An app-limited sample only says the path can do at least this much.
+  const uint64_t rate = ack.rate->rate();
+  if ( rate == 0 or ( ack.rate->app_limited and rate < btl_bw_ ) ) {
+    return;
+  }
+
+  RoundMax& slot = bw_samples_.at( round_count_ % BTL_BW_FILTER_ROUNDS );
+  if ( slot.round != round_count_ ) {
+    slot = { .round = round_count_, .rate = 0 };
+  }
+  slot.rate = max( slot.rate, rate );
+
+  btl_bw_ = 0;
+  for ( const RoundMax& sample : bw_samples_ ) {
+    if ( sample.round + BTL_BW_FILTER_ROUNDS > round_count_ ) {
+      btl_bw_ = max( btl_bw_, sample.rate );
+    }
+  }
+}
+
+void Bbr::update_cycle_phase( const AckSample& ack )
+{
+  if ( mode_ != Mode::ProbeBandwidth ) {
+    return;
+  }
+
+  const uint64_t prior_in_flight = ack.bytes_in_flight + ack.bytes_acked;
+  const bool full_length = ack.now_ms - cycle_stamp_ms_ > ( min_rtt_ms_ == NO_RTT ? 0 : min_rtt_ms_ );
+  bool next = full_length;
+  if ( pacing_gain_ > 1 ) {
+    // Probe until the extra data is actually in the pipe (or causes loss).
+    next = full_length and ( lost_this_cycle_ or prior_in_flight >= target_cwnd( pacing_gain_ ) );
+  } else if ( pacing_gain_ < 1 ) {
+    // Drain the probe's queue, or stop early once it's gone.
+    next = full_length or prior_in_flight <= target_cwnd( 1 );
+  }
+
+  if ( next ) {
+    cycle_index_ = ( cycle_index_ + 1 ) % PACING_GAIN_CYCLE.size();
+    cycle_stamp_ms_ = ack.now_ms;
+    pacing_gain_ = PACING_GAIN_CYCLE.at( cycle_index_ );
+    lost_this_cycle_ = false;
+  }
+}
+
+void Bbr::check_full_pipe( const AckSample& ack )
+{
+  if ( filled_pipe_ or not round_start_ or not ack.rate.has_value() or ack.rate->app_limited ) {
+    return;
+  }
+  if ( btl_bw_ * 4 >= full_bw_ * 5 ) { // still growing by 25% a round
+    full_bw_ = btl_bw_;
+    full_bw_count_ = 0;
+    return;
+  }
+  if ( ++full_bw_count_ >= FULL_BW_ROUNDS ) {
+    filled_pipe_ = true;
+  }
+}
+
+void Bbr::check_drain( const AckSample& ack )
+{
+  if ( mode_ == Mode::Startup and filled_pipe_ ) {
+    mode_ = Mode::Drain;
+    pacing_gain_ = DRAIN_GAIN;
+    cwnd_gain_ = HIGH_GAIN;
+  }
+  if ( mode_ == Mode::Drain and ack.bytes_in_flight <= target_cwnd( 1 ) ) {
+    enter_probe_bandwidth( ack.now_ms );
+  }
+}
+
+void Bbr::enter_probe_bandwidth( uint64_t now_ms )
+{
+  mode_ = Mode::ProbeBandwidth;
+  cwnd_gain_ = CWND_GAIN;
+  // Start in the last cruising phase, so the first probe comes one min RTT from now.
+  cycle_index_ = PACING_GAIN_CYCLE.size() - 1;
+  pacing_gain_ = PACING_GAIN_CYCLE.at( cycle_index_ );
+  cycle_stamp_ms_ = now_ms;
+}
+
+void Bbr::update_min_rtt( const AckSample& ack )
+{
+  min_rtt_expired_ = min_rtt_ms_ != NO_RTT and ack.now_ms > min_rtt_stamp_ms_ + MIN_RTT_FILTER_MS;
+  if ( ack.rtt_ms.has_value() and ( *ack.rtt_ms <= min_rtt_ms_ or min_rtt_expired_ ) ) {
+    min_rtt_ms_ = *ack.rtt_ms;
+    min_rtt_stamp_ms_ = ack.now_ms;
+  }
+}
+
+void Bbr::check_probe_rtt( const AckSample& ack )
+{
+  if ( mode_ != Mode::ProbeRtt and min_rtt_expired_ ) {
+    mode_ = Mode::ProbeRtt;
+    pacing_gain_ = 1;
+    prior_cwnd_ = cwnd_;
+    probe_rtt_done_ms_ = 0;
+  }
+  if ( mode_ != Mode::ProbeRtt ) {
+    return;
+  }
+
+  // Hold the minimum window for PROBE_RTT_MS and at least one round once in flight drains to it.
+  if ( probe_rtt_done_ms_ == 0 and ack.bytes_in_flight <= min_cwnd() ) {
+    probe_rtt_done_ms_ = ack.now_ms + PROBE_RTT_MS;
+    probe_rtt_round_done_ = false;
+    next_round_delivered_ = ack.delivered;
+  } else if ( probe_rtt_done_ms_ != 0 ) {
+    probe_rtt_round_done_ = probe_rtt_round_done_ or round_start_;
+    if ( probe_rtt_round_done_ and ack.now_ms > probe_rtt_done_ms_ ) {
+      exit_probe_rtt( ack.now_ms );
+    }
+  }
+}
+
+void Bbr::exit_probe_rtt( uint64_t now_ms )
+{
+  min_rtt_stamp_ms_ = now_ms;
+  cwnd_ = max( cwnd_, prior_cwnd_ );
+  if ( filled_pipe_ ) {
+    enter_probe_bandwidth( now_ms );
+  } else {
+    mode_ = Mode::Startup;
+    pacing_gain_ = HIGH_GAIN;
+    cwnd_gain_ = HIGH_GAIN;
+  }
+}
+
+void Bbr::set_cwnd( const AckSample& ack )
+{
+  if ( mode_ == Mode::ProbeRtt ) {
+    cwnd_ = min( cwnd_, min_cwnd() );
+    return;
+  }
+
+  const uint64_t target = target_cwnd( cwnd_gain_ );
+  if ( filled_pipe_ or in_recovery_ ) {
+    cwnd_ = min( cwnd_ + ack.bytes_acked, target );
+  } else if ( cwnd_ < target or ack.delivered < initial_cwnd_ ) {
+    cwnd_ += ack.bytes_acked;
+  }
+  cwnd_ = max( cwnd_, min_cwnd() );
+}
+
+void Bbr::on_loss( uint64_t /* now_ms */, uint64_t /* bytes_in_flight */ )
+{
+  // Loss isn't the model's congestion signal; it only ends a bandwidth probe early.
+  lost_this_cycle_ = true;
+}
+
+void Bbr::on_rto( uint64_t /* now_ms */, uint64_t bytes_in_flight )
+{
+  // Restart from one segment and grow by what is delivered (packet conservation) until
+  // everything in flight now is acknowledged; then resume where the model was.
+  if ( not in_recovery_ ) {
+    prior_cwnd_ = cwnd_;
+    recovery_end_ = last_ackno_ + bytes_in_flight;
+    in_recovery_ = true;
+  }
+  lost_this_cycle_ = true;
+  cwnd_ = mss_;
+}
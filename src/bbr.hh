@@ -0,0 +1,110 @@
+#pragma once
+
+#include "congestion_control.hh"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+// A model-based controller in the style of BBR (v1). Rather than reacting to loss, it estimates
+// the path's bottleneck bandwidth (windowed max of delivery-rate samples over 10 rounds) and
+// round-trip propagation delay (windowed min RTT over 10 s). It paces at a gain times the
+// bandwidth and caps what is in flight at twice their product, so queues stay short.
+//   Startup:        pace at 2/ln 2 of the estimate until it stops growing 25% a round, three times.
+//   Drain:          pace at the inverse gain until in flight is down to one BDP.
+//   ProbeBandwidth: cycle the pacing gain through 1.25, 0.75, then 1 for six rounds.
+//   ProbeRtt:       every 10 s without a new min RTT, shrink to 4 segments for 200 ms and a round.
+class Bbr : public CongestionControl
+{
+public:
+  enum class Mode : uint8_t
+  {
+    Startup,
+    Drain,
+    ProbeBandwidth,
+    ProbeRtt,
+  };
+
+  explicit Bbr( uint64_t mss );
+
+  void on_ack( const AckSample& ack ) override;
+  void on_loss( uint64_t now_ms, uint64_t bytes_in_flight ) override;
+  void on_rto( uint64_t now_ms, uint64_t bytes_in_flight ) override;
+  uint64_t cwnd() const override { return cwnd_; }
+  std::optional<uint64_t> pacing_rate() const override;
+  void set_mss( uint64_t mss ) override { *this = Bbr( mss ); }
+  std::string_view name() const override { return "bbr"; }
+
+  Mode mode() const { return mode_; }
+  uint64_t bottleneck_bandwidth() const { return btl_bw_; } // bytes per second; 0 before any sample
+  std::optional<uint64_t> min_rtt_ms() const;
+  uint64_t bdp() const; // estimated bandwidth-delay product, in bytes
+
+private:
+  static constexpr double HIGH_GAIN = 2.885; // 2/ln 2: doubles the sending rate each round
+  static constexpr double DRAIN_GAIN = 1 / HIGH_GAIN;
+  static constexpr double CWND_GAIN = 2;
+  static constexpr std::array<double, 8> PACING_GAIN_CYCLE { 1.25, 0.75, 1, 1, 1, 1, 1, 1 };
+  static constexpr uint64_t BTL_BW_FILTER_ROUNDS = 10;
+  static constexpr uint64_t MIN_RTT_FILTER_MS = 10'000;
+  static constexpr uint64_t PROBE_RTT_MS = 200;
+  static constexpr uint64_t MIN_CWND_SEGMENTS = 4;
+  static constexpr uint64_t FULL_BW_ROUNDS = 3;
+  static constexpr uint64_t NO_RTT = UINT64_MAX;
+
+  uint64_t mss_;
+  uint64_t initial_cwnd_;
+  uint64_t cwnd_;
+  Mode mode_ { Mode::Startup };
+  double pacing_gain_ { HIGH_GAIN };
+  double cwnd_gain_ { HIGH_GAIN };
+
+  // Round counting: a round ends when a segment sent after it began is acknowledged.
+  uint64_t round_count_ {};
+  uint64_t next_round_delivered_ {};
+  bool round_start_ {};
+
+  // Bottleneck bandwidth: the largest sample of each of the last BTL_BW_FILTER_ROUNDS rounds.
+  struct RoundMax
+  {
+    uint64_t round;
+    uint64_t rate;
+  };
+  std::array<RoundMax, BTL_BW_FILTER_ROUNDS> bw_samples_ {};
+  uint64_t btl_bw_ {};
+
+  uint64_t min_rtt_ms_ { NO_RTT };
+  uint64_t min_rtt_stamp_ms_ {};
+  bool min_rtt_expired_ {};
+
+  bool filled_pipe_ {};
+  uint64_t full_bw_ {};
+  uint64_t full_bw_count_ {};
+
+  size_t cycle_index_ {};
+  uint64_t cycle_stamp_ms_ {};
+  bool lost_this_cycle_ {};
+
+  uint64_t probe_rtt_done_ms_ {}; // 0 until in flight has drained to the minimum window
+  bool probe_rtt_round_done_ {};
+  uint64_t prior_cwnd_ {}; // restored after ProbeRtt or timeout recovery
+
+  uint64_t last_ackno_ {};
+  uint64_t recovery_end_ {}; // timeout recovery ends when this seqno is acknowledged
+  bool in_recovery_ {};
+
+  void update_round( const AckSample& ack );
+  void update_bandwidth( const AckSample& ack );
+  void update_min_rtt( const AckSample& ack );
+  void update_cycle_phase( const AckSample& ack );
+  void check_full_pipe( const AckSample& ack );
+  void check_drain( const AckSample& ack );
+  void check_probe_rtt( const AckSample& ack );
+  void set_cwnd( const AckSample& ack );
+
+  void enter_probe_bandwidth( uint64_t now_ms );
+  void exit_probe_rtt( uint64_t now_ms );
+  uint64_t target_cwnd( double gain ) const;
+  uint64_t min_cwnd() const { return MIN_CWND_SEGMENTS * mss_; }
+};
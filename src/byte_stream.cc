@@ -1,7 +1,67 @@
 #include "byte_stream.hh"
 
+#include <cstring>
+#include <stdexcept>
+
 using namespace std;
 
+ByteStream::ByteStream( uint64_t capacity, Storage storage )
+  : capacity_( capacity ), storage_( storage ), high_watermark_( capacity )
+{
+  if ( storage_ == Storage::MirroredRing ) {
+    ring_ = MirroredRing { capacity_ };
+  }
+}
+
+void ByteStream::set_error()
+{
+  const Readiness before = watched_readiness();
+  error_ = true;
+  notify_if_changed( before );
+}
+
+void ByteStream::set_watermarks( uint64_t low, uint64_t high )
+{
+  if ( low == 0 or low > high or high > capacity_ ) {
+    throw invalid_argument( "ByteStream::set_watermarks: need 0 < low <= high <= capacity" );
+  }
+  const Readiness before = watched_readiness();
+  low_watermark_ = low;
+  high_watermark_ = high;
+  notify_if_changed( before );
+}
+
+void ByteStream::on_readable_change( function<void( bool )> callback )
+{
+  hooks_.readable = move( callback );
+}
+
+void ByteStream::on_writable_change( function<void( bool )> callback )
+{
+  hooks_.writable = move( callback );
+}
+
+ByteStream::Readiness ByteStream::readiness() const
+{
+  const uint64_t buffered = bytes_pushed_ - bytes_popped_;
+  return { buffered >= low_watermark_ or closed_ or error_,
+           buffered < high_watermark_ and not closed_ and not error_ };
+}
+
+void ByteStream::notify_if_changed( Readiness before )
+{
+  if ( hooks_.empty() ) {
+    return;
+  }
+  const Readiness now = readiness();
+  if ( hooks_.readable and now.readable != before.readable ) {
+    hooks_.readable( now.readable );
+  }
+  if ( hooks_.writable and now.writable != before.writable ) {
+    hooks_.writable( now.writable );
+  }
+}
+
 void Writer::push( string data )
 {
   const uint64_t avail = available_capacity();
@@ -11,13 +71,86 @@ void Writer::push( string data )
   if ( data.size() > avail ) {
     data.resize( avail );
   }
+  const Readiness before = watched_readiness();
+  reserved_ = 0;
+  if ( storage_ == Storage::MirroredRing ) {
+    copy_into_ring( data );
+  } else {
+    bytes_pushed_ += data.size();
+    segments_.emplace_back( move( data ) );
+  }
+  notify_if_changed( before );
+}
+
+void Writer::push( SharedSlice slice )
+{
+  const uint64_t avail = available_capacity();
+  if ( slice.bytes.empty() or avail == 0 ) {
+    return;
+  }
+  slice.bytes = slice.bytes.substr( 0, avail );
+  const Readiness before = watched_readiness();
+  reserved_ = 0;
+  if ( storage_ == Storage::MirroredRing ) {
+    copy_into_ring( slice.bytes );
+  } else {
+    bytes_pushed_ += slice.bytes.size();
+    segments_.emplace_back( move( slice ) );
+  }
+  notify_if_changed( before );
+}
+
+void Writer::copy_into_ring( string_view data )
+{
+  // The mirror makes [bytes_pushed_, bytes_pushed_ + avail) contiguous, so one memcpy suffices.
+  memcpy( ring_.at( bytes_pushed_ ), data.data(), data.size() );
   bytes_pushed_ += data.size();
-  segments_.emplace_back( move( data ) );
+}
+
+span<char> Writer::reserve( uint64_t len )
+{
+  reserved_ = min( len, available_capacity() );
+  if ( reserved_ == 0 ) {
+    return {};
+  }
+  if ( storage_ == Storage::MirroredRing ) {
+    return { ring_.at( bytes_pushed_ ), reserved_ };
+  }
+  // Reuse the staging buffer once no segment still borrows it; a fresh one is left uninitialized,
+  // since the caller overwrites whatever it commits.
+  if ( staging_.use_count() != 1 or staging_size_ < reserved_ ) {
+    staging_ = make_shared_for_overwrite<char[]>( reserved_ );
+    staging_size_ = reserved_;
+  }
+  return { staging_.get(), reserved_ };
+}
+
+void Writer::commit( uint64_t len )
+{
+  len = min( len, reserved_ );
+  reserved_ = 0;
+  if ( len == 0 ) {
+    return;
+  }
+  const Readiness before = watched_readiness();
+  bytes_pushed_ += len;
+  if ( storage_ == Storage::Segmented ) {
+    if ( len * 2 >= staging_size_ ) {
+      // Mostly filled: the segment borrows the staging buffer, which reserve() takes back once it is popped.
+      segments_.emplace_back( SharedSlice { staging_, { staging_.get(), len } } );
+    } else {
+      // Copying out a short commit keeps a large buffer from being pinned by a few bytes.
+      segments_.emplace_back( in_place_type<string>, staging_.get(), len );
+    }
+  }
+  notify_if_changed( before );
 }
 
 void Writer::close()
 {
+  const Readiness before = watched_readiness();
   closed_ = true;
+  notify_if_changed( before );
 }
 
 bool Writer::is_closed() const
@@ -25,6 +158,11 @@ bool Writer::is_closed() const
   return closed_;
 }
 
+bool Writer::is_writable() const
+{
+  return readiness().writable;
+}
+
 uint64_t Writer::available_capacity() const
 {
   return capacity_ - ( bytes_pushed_ - bytes_popped_ );
@@ -37,19 +175,99 @@ uint64_t Writer::bytes_pushed() const
 
 string_view Reader::peek() const
 {
+  if ( storage_ == Storage::MirroredRing ) {
+    if ( bytes_pushed_ == bytes_popped_ ) {
+      return {};
+    }
+    return { ring_.at( bytes_popped_ ), bytes_pushed_ - bytes_popped_ };
+  }
   if ( segments_.empty() ) {
     return {};
   }
-  return string_view { segments_.front() }.substr( skip_in_front_ );
+  return view_of( segments_.front() ).substr( skip_in_front_ );
+}
+
+SharedSlice Reader::peek_borrowed() const
+{
+  if ( storage_ == Storage::MirroredRing or segments_.empty() ) {
+    return {};
+  }
+  const auto* borrowed = get_if<SharedSlice>( &segments_.front() );
+  if ( borrowed == nullptr or not borrowed->owner ) {
+    return {};
+  }
+  return { borrowed->owner, borrowed->bytes.substr( skip_in_front_ ) };
+}
+
+vector<string_view> Reader::peek_spans( size_t max_iov ) const
+{
+  vector<string_view> spans;
+  if ( bytes_pushed_ == bytes_popped_ or max_iov == 0 ) {
+    return spans;
+  }
+  if ( storage_ == Storage::MirroredRing ) {
+    spans.push_back( peek() );
+    return spans;
+  }
+
+  spans.reserve( min( max_iov, segments_.size() ) );
+  uint64_t skip = skip_in_front_;
+  for ( const Segment& segment : segments_ ) {
+    if ( spans.size() == max_iov ) {
+      break;
+    }
+    spans.emplace_back( view_of( segment ).substr( skip ) );
+    skip = 0;
+  }
+  return spans;
 }
 
 void Reader::pop( uint64_t len )
 {
   len = min( len, bytes_pushed_ - bytes_popped_ );
+  if ( len == 0 ) {
+    return;
+  }
+  const Readiness before = watched_readiness();
+  bytes_popped_ += len;
+  if ( storage_ == Storage::Segmented ) { // a ring's read position is derived from bytes_popped_
+    pop_segments( len );
+  }
+  notify_if_changed( before );
+}
+
+uint64_t Reader::pop_into( span<char> out )
+{
+  const uint64_t len = min<uint64_t>( out.size(), bytes_pushed_ - bytes_popped_ );
+  if ( len == 0 ) {
+    return 0;
+  }
+  const Readiness before = watched_readiness();
+  if ( storage_ == Storage::MirroredRing ) {
+    memcpy( out.data(), ring_.at( bytes_popped_ ), len );
+  } else {
+    for ( uint64_t copied = 0; copied < len; ) {
+      const string_view front = view_of( segments_.front() ).substr( skip_in_front_ );
+      const uint64_t chunk = min<uint64_t>( front.size(), len - copied );
+      memcpy( out.data() + copied, front.data(), chunk );
+      copied += chunk;
+      if ( chunk == front.size() ) {
+        segments_.pop_front();
+        skip_in_front_ = 0;
+      } else {
+        skip_in_front_ += chunk;
+      }
+    }
+  }
   bytes_popped_ += len;
+  notify_if_changed( before );
+  return len;
+}
 
+void Reader::pop_segments( uint64_t len )
+{
   while ( len > 0 ) {
-    const uint64_t front_remaining = segments_.front().size() - skip_in_front_;
+    const uint64_t front_remaining = view_of( segments_.front() ).size() - skip_in_front_;
     if ( len >= front_remaining ) {
       segments_.pop_front();
       skip_in_front_ = 0;
@@ -66,6 +284,11 @@ bool Reader::is_finished() const
   return closed_ and bytes_pushed_ == bytes_popped_;
 }
 
+bool Reader::is_readable() const
+{
+  return readiness().readable;
+}
+
 uint64_t Reader::bytes_buffered() const
 {
   return bytes_pushed_ - bytes_popped_;
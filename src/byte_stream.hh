@@ -1,10 +1,19 @@
 #pragma once
 
+#include "mirrored_ring.hh"
+#include "shared_slice.hh"
+
 #include <cstdint>
 #include <deque>
+#include <functional>
+#include <memory>
+#include <span>
 #include <string>
 #include <string_view>
+#include <variant>
+#include <vector>
 
+class FileDescriptor;
 class Reader;
 class Writer;
 
@@ -14,47 +23,159 @@ class Writer;
 class ByteStream
 {
 public:
-  explicit ByteStream( uint64_t capacity ) : capacity_( capacity ) {}
+  // Where buffered bytes live.
+  //   Segmented:    a chain of the pushed buffers; push() adopts the caller's string
+  //                 or borrows its SharedSlice.
+  //   MirroredRing: one double-mapped ring sized once at construction; push() copies
+  //                 into it, and peek() always returns every buffered byte.
+  enum class Storage : uint8_t
+  {
+    Segmented,
+    MirroredRing,
+  };
+
+  explicit ByteStream( uint64_t capacity, Storage storage = Storage::Segmented );
 
   Reader& reader();
   const Reader& reader() const;
   Writer& writer();
   const Writer& writer() const;
 
-  void set_error() { error_ = true; }
+  void set_error();
   bool has_error() const { return error_; }
 
+  Storage storage() const { return storage_; }
+
+  // Readiness watermarks: the Reader is readable while bytes_buffered() >= low (or once the
+  // stream is closed or has an error), and the Writer is writable while bytes_buffered() < high
+  // and the stream is open and error-free. The defaults, (1, capacity), match the usual
+  // `bytes_buffered() > 0` and `available_capacity() > 0` event-loop interests. Throws
+  // std::invalid_argument unless 0 < low <= high <= capacity.
+  void set_watermarks( uint64_t low, uint64_t high );
+
+  // Called with the new state only when readability or writability flips, e.g. to arm and
+  // disarm an EpollEventLoop rule. Callbacks must not modify the stream; copies of the
+  // stream start without them.
+  void on_readable_change( std::function<void( bool )> callback );
+  void on_writable_change( std::function<void( bool )> callback );
+
 protected:
+  struct Readiness
+  {
+    bool readable;
+    bool writable;
+  };
+  Readiness readiness() const;
+  Readiness watched_readiness() const { return hooks_.empty() ? Readiness {} : readiness(); }
+  void notify_if_changed( Readiness before ); // fire the callbacks for whatever flipped since `before`
+
+  // The readiness callbacks, which belong to whoever watches this particular stream.
+  struct ReadinessHooks
+  {
+    std::function<void( bool )> readable {};
+    std::function<void( bool )> writable {};
+
+    bool empty() const { return not readable and not writable; }
+
+    ReadinessHooks() = default;
+    ReadinessHooks( const ReadinessHooks& /* other */ ) : readable(), writable() {}
+    ReadinessHooks& operator=( const ReadinessHooks& /* other */ )
+    {
+      readable = nullptr;
+      writable = nullptr;
+      return *this;
+    }
+    ReadinessHooks( ReadinessHooks&& other ) = default;
+    ReadinessHooks& operator=( ReadinessHooks&& other ) = default;
+    ~ReadinessHooks() = default;
+  };
+
+  using Segment = std::variant<std::string, SharedSlice>; // owned or borrowed
+  static std::string_view view_of( const Segment& segment )
+  {
+    const auto* owned = std::get_if<std::string>( &segment );
+    return owned ? std::string_view { *owned } : std::get<SharedSlice>( segment ).bytes;
+  }
+
   uint64_t capacity_;
-  std::deque<std::string> segments_ {}; // chain of pushed buffers; front is the next byte to read
-  uint64_t skip_in_front_ {};           // bytes already popped from segments_.front()
+  Storage storage_;
+  MirroredRing ring_ {};               // Storage::MirroredRing only
+  std::deque<Segment> segments_ {};    // Storage::Segmented: chain of pushed buffers, front is next to read
+  uint64_t skip_in_front_ {};          // Storage::Segmented: bytes already popped from segments_.front()
+  std::shared_ptr<char[]> staging_ {}; // Storage::Segmented: backing for reserve()
+  uint64_t staging_size_ {};           // Storage::Segmented: length of staging_
+  uint64_t reserved_ {};               // length of the outstanding reserve() region
   uint64_t bytes_pushed_ {};
   uint64_t bytes_popped_ {};
   bool error_ {};
   bool closed_ {};
+  uint64_t low_watermark_ { 1 };
+  uint64_t high_watermark_; // defaults to capacity_
+  ReadinessHooks hooks_ {};
 };
 
 class Writer : public ByteStream
 {
 public:
-  void push( std::string data ); // Push data, truncated to available_capacity().
-  void close();                  // Signal end of stream; nothing more will be written.
+  void push( std::string data );  // Push data, truncated to available_capacity().
+  void push( SharedSlice slice ); // Same, but a segmented stream references the bytes instead of copying.
+  void close();                   // Signal end of stream; nothing more will be written.
+
+  // Two-phase write for producers that fill memory themselves (e.g. read(2)):
+  // reserve() hands out up to `len` writable bytes, bounded by available_capacity(),
+  // and commit() publishes the first `len` of them. The region is invalidated by
+  // commit(), push(), or another reserve(). With a mirrored ring the region is the
+  // stream storage itself. A segmented stream stages it in a reusable buffer: a commit of
+  // at least half of it becomes a segment that borrows the buffer, and a smaller one is copied.
+  std::span<char> reserve( uint64_t len );
+  void commit( uint64_t len );
 
   bool is_closed() const;
+  bool is_writable() const; // see ByteStream::set_watermarks()
   uint64_t available_capacity() const;
   uint64_t bytes_pushed() const;
+
+private:
+  void copy_into_ring( std::string_view data );
 };
 
 class Reader : public ByteStream
 {
 public:
-  std::string_view peek() const; // Peek at the next contiguous run of buffered bytes.
+  std::string_view peek() const; // Peek at the next contiguous run of buffered bytes (all of them for a ring).
   void pop( uint64_t len );      // Discard up to `len` buffered bytes from the front.
 
+  // Like peek(), but only when a segmented stream borrowed that run from a SharedSlice with an
+  // owner: the result shares the owner, so the bytes outlive pop(). Otherwise an empty slice.
+  SharedSlice peek_borrowed() const;
+
+  // Copy up to out.size() bytes from the front into `out` and pop them, crossing
+  // segment boundaries in a single pass. Returns the number of bytes copied.
+  uint64_t pop_into( std::span<char> out );
+
+  // Every buffered byte as at most `max_iov` contiguous runs, in stream order
+  // (one run for a ring, one per segment otherwise) -- ready for writev(2).
+  std::vector<std::string_view> peek_spans( size_t max_iov ) const;
+
   bool is_finished() const;        // Closed and fully drained?
+  bool is_readable() const;        // See ByteStream::set_watermarks().
   uint64_t bytes_buffered() const; // Bytes pushed but not yet popped.
   uint64_t bytes_popped() const;
+
+private:
+  void pop_segments( uint64_t len );
 };
 
 // Peek-and-pop up to `max_len` bytes from `reader` into `out`.
 void read( Reader& reader, uint64_t max_len, std::string& out );
+
+// Pop up to out.size() bytes from `reader` into caller-owned memory; returns the bytes copied.
+uint64_t read_into( Reader& reader, std::span<char> out );
+
+// One read(2) from `fd` straight into `writer`'s reserved region, bounded by its
+// available capacity. Returns the number of bytes committed (0 on EOF or EAGAIN).
+uint64_t read_into( FileDescriptor& fd, Writer& writer );
+
+// One writev(2) of everything buffered in `reader` to `fd`; pops exactly the
+// bytes the kernel accepted and returns that count.
+uint64_t drain_to( Reader& reader, FileDescriptor& fd );
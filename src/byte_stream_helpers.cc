@@ -1,5 +1,8 @@
 #include "byte_stream.hh"
+#include "file_descriptor.hh"
 
+#include <algorithm>
+#include <climits>
 #include <stdexcept>
 
 using namespace std;
@@ -7,6 +10,7 @@ using namespace std;
 void read( Reader& reader, uint64_t max_len, string& out )
 {
   out.clear();
+  out.reserve( min( max_len, reader.bytes_buffered() ) ); // one allocation, and no zero-fill before the copy
 
   while ( reader.bytes_buffered() and out.size() < max_len ) {
     auto view = reader.peek();
@@ -19,6 +23,32 @@ void read( Reader& reader, uint64_t max_len, string& out )
   }
 }
 
+uint64_t read_into( Reader& reader, span<char> out )
+{
+  return reader.pop_into( out );
+}
+
+uint64_t read_into( FileDescriptor& fd, Writer& writer )
+{
+  const span<char> region = writer.reserve( writer.available_capacity() );
+  if ( region.empty() ) {
+    return 0;
+  }
+  const size_t bytes_read = fd.read( region );
+  writer.commit( bytes_read );
+  return bytes_read;
+}
+
+uint64_t drain_to( Reader& reader, FileDescriptor& fd )
+{
+  if ( reader.bytes_buffered() == 0 ) {
+    return 0;
+  }
+  const size_t bytes_written = fd.write( reader.peek_spans( IOV_MAX ) );
+  reader.pop( bytes_written );
+  return bytes_written;
+}
+
 // Reader and Writer are zero-byte views over ByteStream — the static_asserts
 // catch anyone accidentally adding state to a derived class instead of the base.
 
@@ -0,0 +1,71 @@
+#include "congestion_control.hh"
+#include "bbr.hh"
+#include "cubic.hh"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+unique_ptr<CongestionControl> CongestionControl::make( CongestionControlAlgorithm algorithm, uint64_t mss )
+{
+  switch ( algorithm ) {
+    case CongestionControlAlgorithm::None:
+      return make_unique<NoCongestionControl>();
+    case CongestionControlAlgorithm::NewReno:
+      return make_unique<NewReno>( mss );
+    case CongestionControlAlgorithm::Cubic:
+      return make_unique<Cubic>( mss );
+    case CongestionControlAlgorithm::Bbr:
+      return make_unique<Bbr>( mss );
+  }
+  throw runtime_error( "unknown congestion control algorithm" );
+}
+
+uint64_t CongestionControl::initial_window( uint64_t mss )
+{
+  return min( 10 * mss, max( 2 * mss, uint64_t { 14600 } ) );
+}
+
+NewReno::NewReno( uint64_t mss ) : mss_( mss ), cwnd_( initial_window( mss ) ) {}
+
+void NewReno::on_ack( const AckSample& ack )
+{
+  after_rto_ = false;
+  if ( ack.in_recovery ) {
+    return;
+  }
+
+  if ( in_slow_start() ) {
+    cwnd_ += min( ack.bytes_acked, mss_ );
+    return;
+  }
+
+  // Congestion avoidance: one MSS per window's worth of acknowledged bytes.
+  bytes_acked_ += ack.bytes_acked;
+  if ( bytes_acked_ >= cwnd_ ) {
+    bytes_acked_ -= cwnd_;
+    cwnd_ += mss_;
+  }
+}
+
+void NewReno::on_loss( uint64_t /* now_ms */, uint64_t bytes_in_flight )
+{
+  reduce_ssthresh( bytes_in_flight );
+  cwnd_ = ssthresh_;
+}
+
+void NewReno::on_rto( uint64_t /* now_ms */, uint64_t bytes_in_flight )
+{
+  if ( not after_rto_ ) {
+    reduce_ssthresh( bytes_in_flight );
+    after_rto_ = true;
+  }
+  cwnd_ = mss_; // the loss window
+}
+
+void NewReno::reduce_ssthresh( uint64_t bytes_in_flight )
+{
+  ssthresh_ = max( bytes_in_flight / 2, 2 * mss_ );
+  bytes_acked_ = 0;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "tcp_tuning.hh"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+
+// A delivery-rate sample (draft-cheng-iccrg-delivery-rate-estimation), taken from the most
+// recently sent segment an ACK covers: the bytes delivered between that segment's transmission
+// and its acknowledgment, over the longer of the send and ACK intervals they spanned.
+struct RateSample
+{
+  uint64_t delivered {};       // bytes delivered over the interval
+  uint64_t interval_ms {};     // max(send interval, ACK interval)
+  uint64_t prior_delivered {}; // the sender's delivered count when the segment was sent
+  bool app_limited {};         // the sender ran out of data meanwhile, so the rate is a lower bound
+
+  // Bytes per second, or 0 if the interval was too short to measure.
+  uint64_t rate() const { return interval_ms == 0 ? 0 : delivered * 1000 / interval_ms; }
+};
+
+// What the sender knows when an ACK moves the left edge of its window forward.
+struct AckSample
+{
+  uint64_t now_ms {};                // the sender's clock: total ms passed to tick()
+  uint64_t ackno {};                 // absolute seqno acknowledged; ackno + bytes_in_flight is the next to send
+  uint64_t bytes_acked {};           // sequence numbers newly acknowledged by this ACK
+  uint64_t bytes_in_flight {};       // sequence numbers still outstanding after it
+  std::optional<uint64_t> rtt_ms {}; // RTT of the newest segment acknowledged; none if any was retransmitted
+  uint64_t delivered {};             // total sequence numbers delivered over the connection
+  std::optional<RateSample> rate {}; // absent if every segment acknowledged had been retransmitted
+  bool in_recovery {};               // sent during fast recovery, when the window should not grow
+};
+
+// The policy side of TCPSender: how much may be in flight, and how fast to send it.
+// TCPSender reports ACKs and losses; it never sends past min(cwnd(), receiver window).
+class CongestionControl
+{
+public:
+  virtual ~CongestionControl() = default;
+
+  // New data was acknowledged.
+  virtual void on_ack( const AckSample& ack ) = 0;
+
+  // Loss detected without a timeout (duplicate ACKs, or a hole reported by SACK).
+  virtual void on_loss( uint64_t now_ms, uint64_t bytes_in_flight ) = 0;
+
+  // The retransmission timer expired with data outstanding.
+  virtual void on_rto( uint64_t now_ms, uint64_t bytes_in_flight ) = 0;
+
+  // Congestion window, in sequence numbers.
+  virtual uint64_t cwnd() const = 0;
+
+  // Rate to pace transmissions at, in bytes per second; nullopt sends whatever the window allows.
+  virtual std::optional<uint64_t> pacing_rate() const { return std::nullopt; }
+
+  // Segments carry up to `mss` payload bytes from now on. TCPSender calls this only before
+  // anything is acknowledged, when the handshake settles the MSS, so a controller may start over.
+  virtual void set_mss( uint64_t /* mss */ ) {}
+
+  virtual std::string_view name() const = 0;
+
+  // Construct the controller `algorithm` for segments of up to `mss` payload bytes.
+  static std::unique_ptr<CongestionControl> make( CongestionControlAlgorithm algorithm, uint64_t mss );
+
+protected:
+  // RFC 6928: IW = min(10*MSS, max(2*MSS, 14600)).
+  static uint64_t initial_window( uint64_t mss );
+};
+
+// Flow control only: the window is whatever the receiver advertises.
+class NoCongestionControl : public CongestionControl
+{
+public:
+  void on_ack( const AckSample& /* ack */ ) override {}
+  void on_loss( uint64_t /* now_ms */, uint64_t /* bytes_in_flight */ ) override {}
+  void on_rto( uint64_t /* now_ms */, uint64_t /* bytes_in_flight */ ) override {}
+  uint64_t cwnd() const override { return UINT64_MAX; }
+  std::string_view name() const override { return "none"; }
+};
+
+// Slow start, congestion avoidance and multiplicative decrease (RFC 5681), starting from
+// the RFC 6928 initial window. Slow start counts acknowledged bytes (RFC 3465, L = 1 MSS).
+class NewReno : public CongestionControl
+{
+public:
+  explicit NewReno( uint64_t mss );
+
+  void on_ack( const AckSample& ack ) override;
+  void on_loss( uint64_t now_ms, uint64_t bytes_in_flight ) override;
+  void on_rto( uint64_t now_ms, uint64_t bytes_in_flight ) override;
+  uint64_t cwnd() const override { return cwnd_; }
+  void set_mss( uint64_t mss ) override { *this = NewReno( mss ); }
+  std::string_view name() const override { return "newreno"; }
+
+  uint64_t ssthresh() const { return ssthresh_; }
+  bool in_slow_start() const { return cwnd_ < ssthresh_; }
+
+private:
+  uint64_t mss_;
+  uint64_t cwnd_;
+  uint64_t ssthresh_ { UINT64_MAX };
+  uint64_t bytes_acked_ {}; // acknowledged during congestion avoidance, toward the next MSS of growth
+  bool after_rto_ {};       // a timeout already cut ssthresh; further backoffs leave it alone
+
+  void reduce_ssthresh( uint64_t bytes_in_flight );
+};
@@ -0,0 +1,155 @@
+#include "cubic.hh"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+Cubic::Cubic( uint64_t mss ) : mss_( mss ), cwnd_( static_cast<double>( initial_window( mss ) ) ) {}
+
+void Cubic::on_ack( const AckSample& ack )
+{
+  after_rto_ = false;
+  if ( ack.rtt_ms.has_value() ) {
+    srtt_ms_ = srtt_ms_ == 0 ? *ack.rtt_ms : ( 7 * srtt_ms_ + *ack.rtt_ms ) / 8;
+  }
+  if ( ack.in_recovery ) {
+    return;
+  }
+
+  if ( phase_ == Phase::CongestionAvoidance ) {
+    congestion_avoidance( ack );
+  } else {
+    slow_start( ack );
+  }
+}
+
+void Cubic::slow_start( const AckSample& ack )
+{
+  if ( hystart_ ) {
+    hystart( ack );
+    if ( phase_ == Phase::CongestionAvoidance ) {
+      return;
+    }
+  }
+
+  double growth = static_cast<double>( min( ack.bytes_acked, ( hystart_ ? L : 1 ) * mss_ ) );
+  if ( phase_ == Phase::ConservativeSlowStart ) {
+    growth /= CSS_GROWTH_DIVISOR;
+  }
+  cwnd_ += growth;
+  if ( cwnd_ >= static_cast<double>( ssthresh_ ) ) {
+    phase_ = Phase::CongestionAvoidance;
+  }
+}
+
+void Cubic::hystart( const AckSample& ack )
+{
+  if ( ack.ackno >= window_end_ ) {
+    if ( phase_ == Phase::ConservativeSlowStart and ++css_rounds_ >= CSS_ROUNDS ) {
+      ssthresh_ = cwnd();
+      phase_ = Phase::CongestionAvoidance;
+      hystart_ = false;
+      return;
+    }
+    last_round_min_rtt_ = current_round_min_rtt_;
+    current_round_min_rtt_ = NO_RTT;
+    rtt_sample_count_ = 0;
+    window_end_ = ack.ackno + ack.bytes_in_flight;
+  }
+
+  if ( not ack.rtt_ms.has_value() ) {
+    return;
+  }
+  current_round_min_rtt_ = min( current_round_min_rtt_, *ack.rtt_ms );
+  ++rtt_sample_count_;
+  if ( rtt_sample_count_ < N_RTT_SAMPLE or last_round_min_rtt_ == NO_RTT ) {
+    return;
+  }
+
+  if ( phase_ == Phase::SlowStart ) {
+    const uint64_t thresh = clamp( last_round_min_rtt_ / MIN_RTT_DIVISOR, MIN_RTT_THRESH, MAX_RTT_THRESH );
+    if ( current_round_min_rtt_ >= last_round_min_rtt_ + thresh ) {
+      css_baseline_min_rtt_ = current_round_min_rtt_;
+      css_rounds_ = 0;
+      phase_ = Phase::ConservativeSlowStart;
+    }
+  } else if ( current_round_min_rtt_ < css_baseline_min_rtt_ ) {
+    // The RTT came back down: the rise was noise, not a queue.
+    css_baseline_min_rtt_ = NO_RTT;
+    phase_ = Phase::SlowStart;
+  }
+}
+
+void Cubic::congestion_avoidance( const AckSample& ack )
+{
+  if ( not in_epoch_ ) {
+    start_epoch( ack.now_ms );
+  }
+
+  const double acked = static_cast<double>( ack.bytes_acked );
+  const double t = static_cast<double>( ack.now_ms - epoch_start_ms_ ) / 1000;
+  const double rtt = static_cast<double>( srtt_ms_ ) / 1000;
+
+  // Reno-friendly estimate (RFC 9438 §4.3): ALPHA segments per window, or one once past the old window.
+  const double alpha = w_est_ >= cwnd_prior_ ? 1.0 : ALPHA;
+  w_est_ += alpha * static_cast<double>( mss_ ) * acked / cwnd_;
+
+  if ( w_cubic( t ) < w_est_ ) {
+    cwnd_ = max( cwnd_, w_est_ );
+    return;
+  }
+
+  // Concave or convex region: close (target - cwnd) over one window's worth of ACKs.
+  const double target = clamp( w_cubic( t + rtt ), cwnd_, 1.5 * cwnd_ );
+  cwnd_ += ( target - cwnd_ ) * acked / cwnd_;
+}
+
+void Cubic::start_epoch( uint64_t now_ms )
+{
+  in_epoch_ = true;
+  epoch_start_ms_ = now_ms;
+  w_est_ = cwnd_;
+  if ( w_max_ <= cwnd_ ) {
+    w_max_ = cwnd_; // no loss to recover toward: start on the convex side
+    k_ = 0;
+  } else {
+    k_ = cbrt( ( w_max_ - cwnd_ ) / static_cast<double>( mss_ ) / C );
+  }
+}
+
+double Cubic::w_cubic( double t_seconds ) const
+{
+  const double d = t_seconds - k_;
+  return C * d * d * d * static_cast<double>( mss_ ) + w_max_;
+}
+
+void Cubic::reduce( uint64_t bytes_in_flight )
+{
+  // A receiver-limited sender's cwnd may be far above what was actually in flight.
+  const double window = min( cwnd_, static_cast<double>( bytes_in_flight ) );
+
+  // Fast convergence: a flow whose window keeps shrinking releases bandwidth to newer flows.
+  w_max_ = window < w_max_ ? window * ( 1 + BETA ) / 2 : window;
+  cwnd_prior_ = window;
+  ssthresh_ = max( static_cast<uint64_t>( llround( window * BETA ) ), 2 * mss_ );
+  in_epoch_ = false;
+  hystart_ = false;
+}
+
+void Cubic::on_loss( uint64_t /* now_ms */, uint64_t bytes_in_flight )
+{
+  reduce( bytes_in_flight );
+  cwnd_ = static_cast<double>( ssthresh_ );
+  phase_ = Phase::CongestionAvoidance;
+}
+
+void Cubic::on_rto( uint64_t /* now_ms */, uint64_t bytes_in_flight )
+{
+  if ( not after_rto_ ) {
+    reduce( bytes_in_flight );
+    after_rto_ = true;
+  }
+  cwnd_ = static_cast<double>( mss_ );
+  phase_ = Phase::SlowStart;
+}
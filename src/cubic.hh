@@ -0,0 +1,81 @@
+#pragma once
+
+#include "congestion_control.hh"
+
+#include <cstdint>
+#include <string_view>
+
+// CUBIC (RFC 9438). After a loss the window follows W(t) = C*(t-K)^3 + W_max, a function of the
+// time since the loss rather than of the RTT, so long-RTT flows regrow as fast as short ones.
+// Where standard TCP would be faster (small BDP), the window follows an AIMD estimate of it instead.
+// The initial slow start ends with HyStart++ (RFC 9406): once a round's minimum RTT rises above
+// the previous round's, growth slows to a quarter for a few rounds before congestion avoidance.
+class Cubic : public CongestionControl
+{
+public:
+  enum class Phase : uint8_t
+  {
+    SlowStart,
+    ConservativeSlowStart, // HyStart++ saw the RTT rise; growing at 1/CSS_GROWTH_DIVISOR the rate
+    CongestionAvoidance,
+  };
+
+  explicit Cubic( uint64_t mss );
+
+  void on_ack( const AckSample& ack ) override;
+  void on_loss( uint64_t now_ms, uint64_t bytes_in_flight ) override;
+  void on_rto( uint64_t now_ms, uint64_t bytes_in_flight ) override;
+  uint64_t cwnd() const override { return static_cast<uint64_t>( cwnd_ ); }
+  void set_mss( uint64_t mss ) override { *this = Cubic( mss ); }
+  std::string_view name() const override { return "cubic"; }
+
+  uint64_t ssthresh() const { return ssthresh_; }
+  Phase phase() const { return phase_; }
+  double w_max() const { return w_max_; }
+
+private:
+  static constexpr double C = 0.4;    // segments / s^3
+  static constexpr double BETA = 0.7; // multiplicative decrease factor
+  static constexpr double ALPHA = 3 * ( 1 - BETA ) / ( 1 + BETA ); // AIMD increase matching Reno's rate
+
+  // HyStart++ parameters (RFC 9406 §4.3), with RTTs in ms.
+  static constexpr uint64_t MIN_RTT_THRESH = 4;
+  static constexpr uint64_t MAX_RTT_THRESH = 16;
+  static constexpr uint64_t MIN_RTT_DIVISOR = 8;
+  static constexpr uint64_t N_RTT_SAMPLE = 8;
+  static constexpr uint64_t CSS_GROWTH_DIVISOR = 4;
+  static constexpr uint64_t CSS_ROUNDS = 5;
+  static constexpr uint64_t L = 8; // most segments one ACK may grow the window by in slow start
+  static constexpr uint64_t NO_RTT = UINT64_MAX;
+
+  uint64_t mss_;
+  double cwnd_;
+  uint64_t ssthresh_ { UINT64_MAX };
+  Phase phase_ { Phase::SlowStart };
+  uint64_t srtt_ms_ {}; // smoothed RTT (gain 1/8); 0 until the first sample
+
+  // Congestion avoidance epoch. All windows in bytes.
+  bool in_epoch_ {};
+  uint64_t epoch_start_ms_ {};
+  double k_ {};          // seconds until W(t) is back at w_max_
+  double w_max_ {};      // window just before the last reduction
+  double w_est_ {};      // what Reno would have reached since the epoch began
+  double cwnd_prior_ {}; // window when ssthresh was last set
+  bool after_rto_ {};    // a timeout already reduced the window; further backoffs leave it alone
+
+  // HyStart++ rounds. A round ends when the ACK passes what was next to send when it began.
+  bool hystart_ { true }; // only the initial slow start uses it
+  uint64_t window_end_ {};
+  uint64_t last_round_min_rtt_ { NO_RTT };
+  uint64_t current_round_min_rtt_ { NO_RTT };
+  uint64_t rtt_sample_count_ {};
+  uint64_t css_baseline_min_rtt_ { NO_RTT };
+  uint64_t css_rounds_ {};
+
+  void slow_start( const AckSample& ack );
+  void hystart( const AckSample& ack );
+  void congestion_avoidance( const AckSample& ack );
+  void start_epoch( uint64_t now_ms );
+  double w_cubic( double t_seconds ) const;
+  void reduce( uint64_t bytes_in_flight );
+};
@@ -0,0 +1,116 @@
+#include "mirrored_ring.hh"
+
+#include "exception.hh"
+
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#ifdef __linux__
+
+MirroredRing::MirroredRing( uint64_t min_size )
+{
+  if ( min_size == 0 ) {
+    return;
+  }
+
+  const long page_size = sysconf( _SC_PAGESIZE );
+  if ( page_size <= 0 ) {
+    throw unix_error { "sysconf(_SC_PAGESIZE)" };
+  }
+  const auto page = static_cast<uint64_t>( page_size );
+  const uint64_t size = ( min_size + page - 1 ) / page * page;
+
+  const int fd = CheckSystemCall( "memfd_create", memfd_create( "minnow_ring", MFD_CLOEXEC ) );
+  if ( ftruncate( fd, static_cast<off_t>( size ) ) < 0 ) {
+    const unix_error err { "ftruncate" };
+    ::close( fd );
+    throw err;
+  }
+
+  // Reserve 2*size of address space, then overlay both halves with the same pages.
+  void* const reservation = mmap( nullptr, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+  if ( reservation == MAP_FAILED ) {
+    const unix_error err { "mmap(reserve)" };
+    ::close( fd );
+    throw err;
+  }
+
+  char* const base = static_cast<char*>( reservation );
+  for ( char* const view : { base, base + size } ) {
+    if ( mmap( view, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0 ) == MAP_FAILED ) {
+      const unix_error err { "mmap(view)" };
+      munmap( base, 2 * size );
+      ::close( fd );
+      throw err;
+    }
+  }
+
+  ::close( fd ); // the mappings keep the memfd's pages alive
+  base_ = base;
+  size_ = size;
+}
+
+void MirroredRing::unmap()
+{
+  if ( base_ ) {
+    munmap( base_, 2 * size_ );
+    base_ = nullptr;
+    size_ = 0;
+  }
+}
+
+#else
+
+MirroredRing::MirroredRing( uint64_t min_size )
+{
+  if ( min_size != 0 ) {
+    throw runtime_error( "MirroredRing requires memfd_create (Linux only)" );
+  }
+}
+
+void MirroredRing::unmap() {}
+
+#endif // __linux__
+
+MirroredRing::~MirroredRing()
+{
+  unmap();
+}
+
+MirroredRing::MirroredRing( const MirroredRing& other ) : MirroredRing( other.size_ )
+{
+  if ( base_ ) {
+    memcpy( base_, other.base_, size_ );
+  }
+}
+
+MirroredRing& MirroredRing::operator=( const MirroredRing& other )
+{
+  if ( this != &other ) {
+    MirroredRing copy { other };
+    *this = move( copy );
+  }
+  return *this;
+}
+
+MirroredRing::MirroredRing( MirroredRing&& other ) noexcept
+  : base_( exchange( other.base_, nullptr ) ), size_( exchange( other.size_, 0 ) )
+{}
+
+MirroredRing& MirroredRing::operator=( MirroredRing&& other ) noexcept
+{
+  if ( this != &other ) {
+    unmap();
+    base_ = exchange( other.base_, nullptr );
+    size_ = exchange( other.size_, 0 );
+  }
+  return *this;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+// A fixed-size ring whose pages are mapped twice, back to back, in virtual
+// memory (one memfd, two MAP_FIXED views). Any run of up to size() bytes that
+// starts anywhere in the ring is therefore contiguous: a write or read that
+// "wraps" simply continues into the second view.
+//
+// The ring knows nothing about head or tail; ByteStream derives both from its
+// bytes_pushed_ / bytes_popped_ counters via at().
+class MirroredRing
+{
+public:
+  MirroredRing() = default;
+  explicit MirroredRing( uint64_t min_size ); // rounded up to a whole number of pages
+
+  ~MirroredRing();
+  MirroredRing( const MirroredRing& other );
+  MirroredRing& operator=( const MirroredRing& other );
+  MirroredRing( MirroredRing&& other ) noexcept;
+  MirroredRing& operator=( MirroredRing&& other ) noexcept;
+
+  bool mapped() const { return base_ != nullptr; }
+  uint64_t size() const { return size_; }
+
+  // Address of absolute stream offset `offset`; valid for size() bytes.
+  char* at( uint64_t offset ) { return base_ + offset % size_; }
+  const char* at( uint64_t offset ) const { return base_ + offset % size_; }
+
+private:
+  char* base_ {};
+  uint64_t size_ {};
+
+  void unmap();
+};
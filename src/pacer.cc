@@ -0,0 +1,48 @@
+#include "pacer.hh"
+
+#include <algorithm>
+
+using namespace std;
+
+Pacer::Pacer( PacingConfig config ) : config_( config ), rate_( config.rate ), credit_x1000_( depth_x1000() )
+{
+  if ( rate_ == 0U ) {
+    rate_.reset();
+  }
+}
+
+void Pacer::suggest_rate( optional<uint64_t> bytes_per_s )
+{
+  if ( config_.rate.has_value() ) {
+    return;
+  }
+  rate_ = bytes_per_s == 0U ? nullopt : bytes_per_s;
+  if ( not rate_.has_value() ) {
+    credit_x1000_ = depth_x1000(); // pacing resumes with a full bucket
+  }
+}
+
+void Pacer::tick( uint64_t ms_since_last_tick )
+{
+  if ( not rate_.has_value() ) {
+    return;
+  }
+  const uint64_t headroom = static_cast<uint64_t>( depth_x1000() - min( credit_x1000_, depth_x1000() ) );
+  credit_x1000_ += static_cast<int64_t>( min( headroom, *rate_ * ms_since_last_tick ) );
+}
+
+void Pacer::on_transmit( uint64_t bytes )
+{
+  if ( rate_.has_value() ) {
+    credit_x1000_ -= static_cast<int64_t>( bytes * 1000 );
+  }
+}
+
+uint64_t Pacer::ms_until_ready() const
+{
+  if ( ready() ) {
+    return 0;
+  }
+  const auto debt = static_cast<uint64_t>( -credit_x1000_ );
+  return debt / *rate_ + 1; // the first millisecond that leaves some credit
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "tcp_tuning.hh"
+
+#include <cstdint>
+#include <optional>
+
+// Token-bucket pacing. Credit accrues at the pacing rate as time passes, up to the
+// bucket's depth, and each transmission spends its length. A segment may go whenever
+// any credit is left, so a full segment can overdraw it; the debt is paid off before
+// the next one goes. The rate comes from the config if it sets one, else from
+// whatever the caller suggests (the congestion controller's); with neither, or a rate
+// of zero, nothing is held back.
+class Pacer
+{
+public:
+  explicit Pacer( PacingConfig config );
+
+  // Adopt the rate suggested by the congestion controller, unless the config fixes one.
+  void suggest_rate( std::optional<uint64_t> bytes_per_s );
+
+  void tick( uint64_t ms_since_last_tick );
+  void on_transmit( uint64_t bytes );
+
+  bool ready() const { return not rate_.has_value() or credit_x1000_ > 0; }
+  uint64_t ms_until_ready() const; // 0 if ready()
+  std::optional<uint64_t> rate() const { return rate_; }
+
+private:
+  PacingConfig config_;
+  std::optional<uint64_t> rate_;
+
+  // Credit in thousandths of a byte, so that a rate in bytes per second accrues exactly per millisecond.
+  int64_t credit_x1000_;
+
+  int64_t depth_x1000() const { return static_cast<int64_t>( config_.burst_bytes * 1000 ); }
+};
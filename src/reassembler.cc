@@ -1,87 +1,296 @@
 #include "reassembler.hh"
 
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <memory>
 #include <utility>
 
 using namespace std;
 
+namespace {
+constexpr uint64_t WORD_BITS = 64;
+} // namespace
+
+Reassembler::Reassembler( ByteStream&& output, Tracking tracking )
+  : output_( std::move( output ) ), tracking_( tracking )
+{
+  if ( tracking_ == Tracking::Bitmap ) {
+    const uint64_t capacity = output_.reader().bytes_buffered() + output_.writer().available_capacity();
+    const uint64_t words = max<uint64_t>( 1, ( capacity + WORD_BITS - 1 ) / WORD_BITS );
+    window_.resize( words * WORD_BITS );
+    received_.resize( words );
+  }
+}
+
 void Reassembler::insert( uint64_t first_index, string data, bool is_last_substring )
 {
-  Writer& writer = output_.writer();
+  const Writer& writer = output_.writer();
 
   if ( is_last_substring ) {
     end_index_ = first_index + data.size();
     eof_seen_ = true;
   }
 
+  // 0) Fast path: the next expected bytes with no holes to fill behind them. The
+  //    stream adopts the string as is (truncating it to capacity).
+  if ( first_index == writer.bytes_pushed() and pending_bytes_ == 0 ) {
+    ++stats_.fast_path_inserts;
+    output_.writer().push( std::move( data ) );
+    if ( eof_seen_ and writer.bytes_pushed() == end_index_ ) {
+      output_.writer().close();
+    }
+    return;
+  }
+  ++stats_.slow_path_inserts;
+
   // 1) Clip [first_index, first_index+|data|) to the acceptable window
   //    [first_unassembled, first_unacceptable).
   const uint64_t first_unassembled = writer.bytes_pushed();
   const uint64_t first_unacceptable = first_unassembled + writer.available_capacity();
+  const uint64_t begin = max( first_index, first_unassembled );
+  const uint64_t end = min( first_index + data.size(), first_unacceptable );
 
-  if ( first_index >= first_unacceptable or first_index + data.size() <= first_unassembled ) {
-    data.clear();
-  } else {
-    if ( first_index < first_unassembled ) {
-      data.erase( 0, first_unassembled - first_index );
-      first_index = first_unassembled;
+  if ( begin < end ) {
+    if ( tracking_ == Tracking::Bitmap ) {
+      // 2) Copy the bytes not yet held to their place in the window and mark them received.
+      store( begin, string_view { data }.substr( begin - first_index, end - begin ) );
+      latest_ = begin;
+    } else {
+      // 2) Keep the accepted bytes where they are: the string becomes the owner of a slice,
+      //    unless most of it lies outside the window.
+      uint64_t offset = begin - first_index;
+      if ( ( end - begin ) * 2 < data.size() ) {
+        data = data.substr( offset, end - begin );
+        offset = 0;
+      }
+      const auto owner = make_shared<const string>( std::move( data ) );
+      hold( { begin, { owner, string_view { *owner }.substr( offset, end - begin ) }, owner->size() } );
     }
-    if ( first_index + data.size() > first_unacceptable ) {
-      data.resize( first_unacceptable - first_index );
+
+    // 3) Flush the contiguous prefix into the output stream.
+    flush();
+  }
+
+  if ( eof_seen_ and writer.bytes_pushed() == end_index_ ) {
+    output_.writer().close();
+  }
+}
+
+void Reassembler::hold( Piece piece )
+{
+  const uint64_t begin = piece.begin;
+  const uint64_t end = piece.end();
+  latest_ = begin;
+
+  // First piece that ends after `begin`, i.e. the first one we might overlap.
+  auto first = lower_bound(
+    pending_.begin(), pending_.end(), begin, []( const Piece& p, uint64_t index ) { return p.end() <= index; } );
+
+  if ( first != pending_.end() and first->begin < begin ) {
+    if ( first->end() >= end ) {
+      return; // every byte is already pending
     }
+    // Keep the head of a piece that starts before us.
+    pending_bytes_ -= first->end() - begin;
+    first->slice.bytes = first->slice.bytes.substr( 0, begin - first->begin );
+    compact( *first );
+    ++first;
   }
 
-  if ( not data.empty() ) {
-    // 2) Merge with the immediate predecessor if it touches or overlaps us.
-    auto next = pending_.upper_bound( first_index );
-    if ( next != pending_.begin() ) {
-      auto prev = std::prev( next );
-      const uint64_t prev_end = prev->first + prev->second.size();
-      if ( prev_end >= first_index ) {
-        if ( prev_end >= first_index + data.size() ) {
-          data.clear(); // fully covered
-        } else {
-          // Extend prev with our suffix and adopt it as our working segment so
-          // we can keep absorbing successors below.
-          const uint64_t overlap = prev_end - first_index;
-          prev->second.append( data, overlap );
-          first_index = prev->first;
-          data = std::move( prev->second );
-          pending_.erase( prev );
-        }
-      }
+  // Drop the pieces we cover entirely...
+  auto last = first;
+  while ( last != pending_.end() and last->end() <= end ) {
+    pending_bytes_ -= last->slice.bytes.size();
+    ++last;
+  }
+  // ...and keep the tail of one that straddles our end.
+  if ( last != pending_.end() and last->begin < end ) {
+    pending_bytes_ -= end - last->begin;
+    last->slice.bytes.remove_prefix( end - last->begin );
+    last->begin = end;
+    compact( *last );
+  }
+
+  pending_bytes_ += end - begin;
+  if ( first == last ) {
+    pending_.insert( first, std::move( piece ) );
+  } else {
+    *first = std::move( piece );
+    pending_.erase( next( first ), last );
+  }
+}
+
+void Reassembler::compact( Piece& piece )
+{
+  if ( piece.slice.bytes.size() * 2 < piece.owner_size ) {
+    const auto owner = make_shared<const string>( piece.slice.bytes );
+    piece.slice = { owner, *owner };
+    piece.owner_size = owner->size();
+  }
+}
+
+void Reassembler::flush()
+{
+  Writer& writer = output_.writer();
+
+  if ( tracking_ == Tracking::Bitmap ) {
+    const uint64_t bit = writer.bytes_pushed() % window_.size();
+    if ( not( received_[bit / WORD_BITS] >> ( bit % WORD_BITS ) & 1 ) ) {
+      return; // still a hole at the front
     }
+    const Range run = next_run( writer.bytes_pushed() );
+    clear( run.begin, run.end );
+
+    const auto copy_out = [&]( span<char> dst ) {
+      const uint64_t offset = run.begin % window_.size();
+      const uint64_t head = min<uint64_t>( dst.size(), window_.size() - offset );
+      memcpy( dst.data(), window_.data() + offset, head );
+      memcpy( dst.data() + head, window_.data(), dst.size() - head );
+    };
+    if ( writer.storage() == ByteStream::Storage::MirroredRing ) {
+      const span<char> region = writer.reserve( run.end - run.begin );
+      copy_out( region );
+      writer.commit( region.size() );
+    } else {
+      string chunk( run.end - run.begin, '\0' );
+      copy_out( chunk );
+      writer.push( std::move( chunk ) );
+    }
+    return;
   }
 
-  if ( not data.empty() ) {
-    // 3) Absorb every successor that touches or overlaps us.
-    auto it = pending_.lower_bound( first_index );
-    while ( it != pending_.end() and it->first <= first_index + data.size() ) {
-      const uint64_t next_end = it->first + it->second.size();
-      if ( next_end > first_index + data.size() ) {
-        const uint64_t overlap = first_index + data.size() - it->first;
-        data.append( it->second, overlap );
-      }
-      it = pending_.erase( it );
+  auto it = pending_.begin();
+  while ( it != pending_.end() and it->begin == writer.bytes_pushed() ) {
+    // A segmented stream borrows the slice; a ring copies it into place.
+    pending_bytes_ -= it->slice.bytes.size();
+    writer.push( std::move( it->slice ) );
+    ++it;
+  }
+  pending_.erase( pending_.begin(), it );
+}
+
+void Reassembler::store( uint64_t first_index, string_view data )
+{
+  // A word's worth of bytes is copied only if some of it is new, so heavily
+  // overlapping inserts mostly skip the memcpy.
+  uint64_t bit = first_index % window_.size();
+  while ( not data.empty() ) {
+    const uint64_t shift = bit % WORD_BITS;
+    const uint64_t len = min<uint64_t>( data.size(), WORD_BITS - shift );
+    const uint64_t mask = ( len == WORD_BITS ? ~uint64_t {} : ( uint64_t { 1 } << len ) - 1 ) << shift;
+    uint64_t& word = received_[bit / WORD_BITS];
+    if ( const uint64_t fresh = mask & ~word ) {
+      memcpy( window_.data() + bit, data.data(), len );
+      pending_bytes_ += popcount( fresh );
+      word |= mask;
     }
-    pending_.emplace( first_index, std::move( data ) );
+    data.remove_prefix( len );
+    bit = ( bit + len ) % window_.size();
   }
+}
 
-  // 4) Flush the contiguous prefix into the output stream.
-  while ( not pending_.empty() and pending_.begin()->first == writer.bytes_pushed() ) {
-    auto node = pending_.extract( pending_.begin() );
-    writer.push( std::move( node.mapped() ) );
+void Reassembler::clear( uint64_t begin, uint64_t end )
+{
+  uint64_t bit = begin % window_.size();
+  for ( uint64_t remaining = end - begin; remaining > 0; ) {
+    const uint64_t shift = bit % WORD_BITS;
+    const uint64_t len = min( remaining, WORD_BITS - shift );
+    const uint64_t mask = ( len == WORD_BITS ? ~uint64_t {} : ( uint64_t { 1 } << len ) - 1 ) << shift;
+    received_[bit / WORD_BITS] &= ~mask;
+    remaining -= len;
+    bit = ( bit + len ) % window_.size();
   }
+  pending_bytes_ -= end - begin;
+}
 
-  if ( eof_seen_ and writer.bytes_pushed() == end_index_ ) {
-    writer.close();
+Reassembler::Range Reassembler::next_run( uint64_t from ) const
+{
+  const uint64_t limit = output_.writer().bytes_pushed() + window_.size();
+
+  // Skip clear bits a word at a time...
+  uint64_t index = from;
+  while ( index < limit ) {
+    const uint64_t bit = index % window_.size();
+    const uint64_t word = received_[bit / WORD_BITS] >> ( bit % WORD_BITS );
+    if ( word ) {
+      index += countr_zero( word );
+      break;
+    }
+    index += WORD_BITS - bit % WORD_BITS;
   }
+  if ( index >= limit ) {
+    return { limit, limit };
+  }
+
+  // ...then count set ones the same way.
+  const uint64_t begin = index;
+  while ( index < limit ) {
+    const uint64_t bit = index % window_.size();
+    const uint64_t rest = WORD_BITS - bit % WORD_BITS;
+    const uint64_t ones = countr_one( received_[bit / WORD_BITS] >> ( bit % WORD_BITS ) );
+    index += min<uint64_t>( ones, rest );
+    if ( ones < rest ) {
+      break;
+    }
+  }
+  return { begin, min( index, limit ) };
 }
 
-uint64_t Reassembler::count_bytes_pending() const
+size_t Reassembler::pending_ranges( span<Range> out ) const
 {
-  uint64_t total = 0;
-  for ( const auto& [_, data] : pending_ ) {
-    total += data.size();
+  size_t count = 0;
+  if ( out.empty() ) {
+    return count;
+  }
+
+  if ( tracking_ == Tracking::Bitmap ) {
+    const uint64_t first_unassembled = output_.writer().bytes_pushed();
+    Range latest { 0, 0 };
+    if ( latest_ >= first_unassembled and latest_ < first_unassembled + window_.size() ) {
+      for ( Range run = next_run( first_unassembled ); run.begin < run.end; run = next_run( run.end ) ) {
+        if ( run.begin <= latest_ and latest_ < run.end ) {
+          latest = run;
+          out[count++] = run;
+          break;
+        }
+      }
+    }
+    for ( Range run = next_run( first_unassembled ); run.begin < run.end and count < out.size();
+          run = next_run( run.end ) ) {
+      if ( run.begin != latest.begin ) {
+        out[count++] = run;
+      }
+    }
+    return count;
+  }
+
+  // The run around the most recently held bytes, if they are still pending.
+  auto latest = upper_bound(
+    pending_.begin(), pending_.end(), latest_, []( uint64_t index, const Piece& p ) { return index < p.end(); } );
+  if ( latest != pending_.end() and latest->begin <= latest_ ) {
+    auto lo = latest;
+    while ( lo != pending_.begin() and prev( lo )->end() == lo->begin ) {
+      --lo;
+    }
+    auto hi = next( latest );
+    while ( hi != pending_.end() and hi->begin == prev( hi )->end() ) {
+      ++hi;
+    }
+    out[count++] = { lo->begin, prev( hi )->end() };
+  }
+  const uint64_t skip_begin = count ? out[0].begin : 0; // pending bytes never start at index 0
+
+  // Then the others, lowest first.
+  auto it = pending_.begin();
+  while ( it != pending_.end() and count < out.size() ) {
+    Range run { it->begin, it->end() };
+    for ( ++it; it != pending_.end() and it->begin == run.end; ++it ) {
+      run.end = it->end();
+    }
+    if ( run.begin != skip_begin ) {
+      out[count++] = run;
+    }
   }
-  return total;
+  return count;
 }
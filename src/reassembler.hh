@@ -2,14 +2,33 @@
 
 #include "byte_stream.hh"
 
-#include <map>
+#include <cstdint>
+#include <span>
 #include <string>
+#include <string_view>
+#include <vector>
 
 class Reassembler
 {
 public:
+  // How out-of-order bytes are held until they can be pushed.
+  //   Slices: sorted refcounted views into the inserted strings. A string stays whole while
+  //           at least half of it is held; a piece narrowed below that gets a copy of its own,
+  //           so memory stays within twice the pending bytes. Each held insert allocates a
+  //           refcount block.
+  //   Bitmap: a window buffer covering the stream's capacity (rounded up to 64 bytes) plus
+  //           one bit per byte. Inserts copy into the window, and the contiguous prefix is
+  //           found a 64-bit word at a time with std::countr_one. Inserts never allocate.
+  // Bitmap is the default: it trades one copy of each out-of-order byte for no allocation.
+  // In-order inserts with nothing pending skip both and go straight to the output.
+  enum class Tracking : uint8_t
+  {
+    Slices,
+    Bitmap,
+  };
+
   // Construct Reassembler to write into given ByteStream.
-  explicit Reassembler( ByteStream&& output ) : output_( std::move( output ) ) {}
+  explicit Reassembler( ByteStream&& output, Tracking tracking = Tracking::Bitmap );
 
   /*
    * Insert a new substring to be reassembled into a ByteStream.
@@ -19,9 +38,8 @@ public:
    */
   void insert( uint64_t first_index, std::string data, bool is_last_substring );
 
-  // How many bytes are stored in the Reassembler itself?
-  // This function is for testing only; don't add extra state to support it.
-  uint64_t count_bytes_pending() const;
+  // How many bytes are stored in the Reassembler itself? O(1): the total is kept up to date by insert().
+  uint64_t count_bytes_pending() const { return pending_bytes_; }
 
   // Access output stream reader
   Reader& reader() { return output_.reader(); }
@@ -30,19 +48,81 @@ public:
   // Access output stream writer, but const-only (can't write from outside)
   const Writer& writer() const { return output_.writer(); }
 
+  // A run of pending bytes, [begin, end) in absolute stream indices.
+  struct Range
+  {
+    uint64_t begin;
+    uint64_t end;
+  };
+
+  // Write up to out.size() runs of pending bytes into `out`, merging adjacent pieces: first the run
+  // holding the most recently inserted bytes, then the lowest remaining runs in order -- the layout
+  // of a SACK option (RFC 2018). Returns the number written. With slices, visits no pieces past the
+  // last run reported; with a bitmap, scans at most two passes over the window's words.
+  size_t pending_ranges( std::span<Range> out ) const;
+
+  // How inserts were handled: the fast path hands an in-order substring straight to the
+  // output when nothing is pending; everything else is held as pending pieces first.
+  struct Stats
+  {
+    uint64_t fast_path_inserts {};
+    uint64_t slow_path_inserts {};
+  };
+  const Stats& stats() const { return stats_; }
+
+  Tracking tracking() const { return tracking_; }
+
   void set_error() { output_.set_error(); }
   bool has_error() const { return output_.has_error(); }
   void close() { output_.writer().close(); }
 
 private:
+  // A run of pending bytes starting at absolute stream index `begin`. The bytes stay in the
+  // buffer they arrived in; `slice.owner` keeps that buffer, `owner_size` bytes long, alive
+  // until the run is pushed.
+  struct Piece
+  {
+    uint64_t begin;
+    SharedSlice slice;
+    uint64_t owner_size;
+
+    uint64_t end() const { return begin + slice.bytes.size(); }
+  };
+
+  // Hold `piece`, trimming or replacing the pending pieces it overlaps.
+  void hold( Piece piece );
+
+  // Give a piece that is less than half of its buffer a copy of its own.
+  static void compact( Piece& piece );
+
+  // Push the pending bytes that continue from the first unassembled index, if any.
+  void flush();
+
+  // Tracking::Bitmap helpers. Indices are absolute; bit and byte i live at i % window_.size(),
+  // which is a multiple of 64, so no word of the bitmap straddles the wrap.
+  void store( uint64_t first_index, std::string_view data ); // copy into the window and set the bits
+  void clear( uint64_t begin, uint64_t end );                // forget a run that has been pushed
+  Range next_run( uint64_t from ) const; // first run of set bits at or after `from` (empty if none)
+
   ByteStream output_;
+  Tracking tracking_;
 
-  // Pending substrings keyed by their first_index. Invariant: no two entries
-  // overlap or are adjacent — every insertion merges with neighbors.
-  std::map<uint64_t, std::string> pending_ {};
+  // Tracking::Slices: pending pieces, sorted and pairwise disjoint (though possibly adjacent).
+  // Overlaps are resolved by narrowing views, never by copying bytes.
+  std::vector<Piece> pending_ {};
+
+  // Tracking::Bitmap: everything the Reassembler may hold lies in [bytes_popped, bytes_popped +
+  // capacity), so positions never collide. Both are sized once, at construction.
+  std::string window_ {};
+  std::vector<uint64_t> received_ {}; // bit set: the byte is pending
+
+  uint64_t pending_bytes_ {}; // bytes held, in either representation
+  uint64_t latest_ {};        // first index of the most recently held bytes (for pending_ranges())
 
   // Absolute index of the byte that follows the last byte of the stream
   // (only meaningful once eof_seen_ is true).
   uint64_t end_index_ {};
   bool eof_seen_ {};
+
+  Stats stats_ {};
 };
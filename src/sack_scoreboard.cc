@@ -0,0 +1,185 @@
+#include "sack_scoreboard.hh"
+
+#include <algorithm>
+#include <utility>
+
+using namespace std;
+
+deque<SackScoreboard::Segment>::iterator SackScoreboard::find( uint64_t seqno )
+{
+  return partition_point( segments_.begin(), segments_.end(), [seqno]( const Segment& s ) {
+    return s.end() <= seqno;
+  } );
+}
+
+void SackScoreboard::on_send( uint64_t seqno, uint64_t length )
+{
+  segments_.push_back( { .seqno = seqno, .length = length } );
+  in_flight_ += length;
+}
+
+void SackScoreboard::on_cumulative_ack( uint64_t ackno )
+{
+  while ( not segments_.empty() and segments_.front().end() <= ackno ) {
+    const Segment& s = segments_.front();
+    in_flight_ -= s.length;
+    if ( s.sacked ) {
+      sacked_bytes_ -= s.length;
+      if ( s.seqno < lost_end_ ) {
+        sacked_below_lost_end_ -= s.length;
+      }
+    } else if ( s.retransmit_epoch == epoch_ ) {
+      retransmitted_bytes_ -= s.length;
+    }
+    segments_.pop_front();
+  }
+
+  while ( not sacked_ranges_.empty() and sacked_ranges_.begin()->first < ackno ) {
+    const auto [left, right] = *sacked_ranges_.begin();
+    sacked_ranges_.erase( sacked_ranges_.begin() );
+    if ( right > ackno ) {
+      sacked_ranges_.emplace( ackno, right );
+      break;
+    }
+  }
+}
+
+void SackScoreboard::on_sack( uint64_t left, uint64_t right )
+{
+  if ( segments_.empty() ) {
+    return;
+  }
+  left = max( left, segments_.front().seqno );
+  right = min( right, segments_.back().end() );
+  if ( left >= right ) {
+    return;
+  }
+  sack_seen_ = true;
+
+  // The ranges this block overlaps or touches merge into one.
+  auto first = sacked_ranges_.upper_bound( left );
+  if ( first != sacked_ranges_.begin() and prev( first )->second >= left ) {
+    --first;
+  }
+  uint64_t merged_left = left;
+  uint64_t merged_right = right;
+  auto last = first;
+  for ( ; last != sacked_ranges_.end() and last->first <= right; ++last ) {
+    merged_left = min( merged_left, last->first );
+    merged_right = max( merged_right, last->second );
+  }
+
+  // Only segments overlapping the gaps between the old ranges can have become fully covered.
+  const auto mark_covered = [&]( uint64_t gap_left, uint64_t gap_right ) {
+    for ( auto s = find( gap_left ); s != segments_.end() and s->seqno < gap_right; ++s ) {
+      if ( not s->sacked and s->seqno >= merged_left and s->end() <= merged_right ) {
+        mark_sacked( *s );
+      }
+    }
+  };
+  uint64_t covered_to = left;
+  for ( auto it = first; it != last; ++it ) {
+    if ( it->first > covered_to ) {
+      mark_covered( covered_to, it->first );
+    }
+    covered_to = max( covered_to, it->second );
+  }
+  if ( covered_to < right ) {
+    mark_covered( covered_to, right );
+  }
+
+  sacked_ranges_.erase( first, last );
+  sacked_ranges_.emplace( merged_left, merged_right );
+}
+
+void SackScoreboard::mark_sacked( Segment& segment )
+{
+  segment.sacked = true;
+  sacked_bytes_ += segment.length;
+  if ( segment.seqno < lost_end_ ) {
+    sacked_below_lost_end_ += segment.length;
+  }
+  if ( segment.retransmit_epoch == epoch_ ) {
+    retransmitted_bytes_ -= segment.length;
+  }
+  highest_sacked_ = max( highest_sacked_, segment.end() );
+
+  if ( segment.seqno <= top_sacked_.back() ) {
+    return;
+  }
+  top_sacked_.back() = segment.seqno;
+  for ( size_t i = DUP_THRESH - 1; i > 0 and top_sacked_.at( i ) > top_sacked_.at( i - 1 ); --i ) {
+    swap( top_sacked_.at( i ), top_sacked_.at( i - 1 ) );
+  }
+
+  // Everything unSACKed below the DUP_THRESH-th highest SACKed segment is now lost.
+  const uint64_t new_lost_end = top_sacked_.back();
+  for ( auto s = find( lost_end_ ); s != segments_.end() and s->seqno < new_lost_end; ++s ) {
+    if ( s->sacked and s->seqno >= lost_end_ ) {
+      sacked_below_lost_end_ += s->length;
+    }
+  }
+  lost_end_ = max( lost_end_, new_lost_end );
+}
+
+void SackScoreboard::on_retransmit( uint64_t seqno )
+{
+  const auto it = find( seqno );
+  if ( it == segments_.end() or it->seqno != seqno ) {
+    return;
+  }
+  if ( not it->sacked and it->retransmit_epoch != epoch_ ) {
+    it->retransmit_epoch = epoch_;
+    retransmitted_bytes_ += it->length;
+  }
+  scan_ = max( scan_, it->end() );
+}
+
+void SackScoreboard::on_timeout()
+{
+  ++epoch_;
+  retransmitted_bytes_ = 0;
+  start_recovery();
+}
+
+void SackScoreboard::start_recovery()
+{
+  scan_ = segments_.empty() ? 0 : segments_.front().seqno;
+}
+
+bool SackScoreboard::front_lost() const
+{
+  return not segments_.empty() and not segments_.front().sacked and segments_.front().seqno < lost_end_;
+}
+
+uint64_t SackScoreboard::pipe() const
+{
+  if ( segments_.empty() ) {
+    return 0;
+  }
+  // Per unSACKed sequence number: one unless it is lost, plus one if it was retransmitted.
+  const uint64_t front = segments_.front().seqno;
+  const uint64_t lost = lost_end_ > front ? lost_end_ - front - sacked_below_lost_end_ : 0;
+  return in_flight_ - sacked_bytes_ - lost + retransmitted_bytes_;
+}
+
+optional<SackScoreboard::Hole> SackScoreboard::next_hole()
+{
+  auto it = find( scan_ );
+  while ( it != segments_.end() and ( it->sacked or it->retransmit_epoch == epoch_ ) ) {
+    ++it;
+  }
+  if ( it == segments_.end() ) {
+    scan_ = segments_.empty() ? scan_ : segments_.back().end();
+    return nullopt;
+  }
+  scan_ = it->seqno;
+
+  if ( it->seqno < lost_end_ ) {
+    return Hole { .seqno = it->seqno, .lost = true };
+  }
+  if ( it->end() <= highest_sacked_ ) {
+    return Hole { .seqno = it->seqno, .lost = false };
+  }
+  return nullopt;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <optional>
+
+// The sender's record of which outstanding segments the receiver has SACKed (RFC 6675),
+// kept alongside TCPSender's queue of unacknowledged segments. From it come "pipe", the
+// estimate of how much is still in the network, and NextSeg, the next hole to resend.
+// Sequence numbers are absolute. Every operation is O(log n) in the segments outstanding,
+// amortized: each segment is SACKed, passed by the hole search, and popped at most once.
+class SackScoreboard
+{
+public:
+  static constexpr uint64_t DUP_THRESH = 3; // SACKed segments above one that make it lost
+
+  // A segment was sent for the first time, at the right edge.
+  void on_send( uint64_t seqno, uint64_t length );
+
+  // Everything below `ackno` has been cumulatively acknowledged.
+  void on_cumulative_ack( uint64_t ackno );
+
+  // The receiver holds [left, right). Segments it covers entirely are SACKed.
+  void on_sack( uint64_t left, uint64_t right );
+
+  // The segment starting at `seqno` was retransmitted during loss recovery.
+  void on_retransmit( uint64_t seqno );
+
+  // The retransmission timer expired: earlier retransmissions may be lost too, so they no
+  // longer count toward pipe, and the hole search starts over from the left edge.
+  void on_timeout();
+
+  // Loss recovery begins: search for holes from the left edge.
+  void start_recovery();
+
+  bool sack_seen() const { return sack_seen_; } // without SACK, recovery falls back to NewReno
+  bool front_lost() const;                      // IsLost() for the first outstanding segment
+  uint64_t pipe() const;                        // sequence numbers believed still in the network
+
+  struct Hole
+  {
+    uint64_t seqno; // start of the segment to resend
+    bool lost;      // NextSeg rule (1); otherwise rule (3), to be sent only if new data can't be
+  };
+
+  // The first segment not SACKed and not yet retransmitted in this recovery, if it is lost,
+  // or at least lies below some SACKed data.
+  std::optional<Hole> next_hole();
+
+private:
+  struct Segment
+  {
+    uint64_t seqno;
+    uint64_t length;
+    bool sacked {};
+    uint64_t retransmit_epoch {}; // equal to epoch_ while a retransmission counts toward pipe
+
+    uint64_t end() const { return seqno + length; }
+  };
+
+  std::deque<Segment> segments_ {};
+  std::map<uint64_t, uint64_t> sacked_ranges_ {}; // left -> right; disjoint, not adjacent
+
+  // Starts of the DUP_THRESH highest SACKed segments, highest first (0 if fewer). Every
+  // unSACKed segment below the last of them is lost.
+  std::array<uint64_t, DUP_THRESH> top_sacked_ {};
+  uint64_t lost_end_ {};
+  uint64_t highest_sacked_ {}; // end of the highest SACKed segment
+
+  uint64_t in_flight_ {};
+  uint64_t sacked_bytes_ {};
+  uint64_t sacked_below_lost_end_ {};
+  uint64_t retransmitted_bytes_ {}; // retransmissions not since SACKed or acknowledged
+  uint64_t epoch_ { 1 };
+  uint64_t scan_ {}; // the hole search resumes here
+  bool sack_seen_ {};
+
+  // The first segment that ends after `seqno`.
+  std::deque<Segment>::iterator find( uint64_t seqno );
+  void mark_sacked( Segment& segment );
+};
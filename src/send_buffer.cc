@@ -0,0 +1,54 @@
+#include "send_buffer.hh"
+
+#include <algorithm>
+#include <span>
+
+using namespace std;
+
+SharedSlice SendBuffer::append( Reader& reader, uint64_t len )
+{
+  len = min( len, reader.bytes_buffered() );
+  if ( len == 0 ) {
+    return {};
+  }
+
+  // Bytes the stream already borrows (e.g. from a mapped file) are lent on as they are.
+  if ( SharedSlice borrowed = reader.peek_borrowed(); borrowed.owner ) {
+    borrowed.bytes = borrowed.bytes.substr( 0, len );
+    reader.pop( borrowed.bytes.size() );
+    return borrowed;
+  }
+
+  len = min( len, block_size_ );
+
+  // A segment never straddles two blocks; what is left at the end of one goes unused.
+  if ( blocks_.empty() or blocks_.back().used + len > block_size_ ) {
+    shared_ptr<string> storage;
+    if ( spare_.empty() ) {
+      storage = make_shared<string>( block_size_, '\0' );
+      ++blocks_allocated_;
+    } else {
+      storage = move( spare_.back() );
+      spare_.pop_back();
+    }
+    blocks_.push_back( { .storage = move( storage ), .used = 0, .end = reader.bytes_popped() } );
+  }
+
+  Block& block = blocks_.back();
+  char* const data = block.storage->data() + block.used;
+  block.end = reader.bytes_popped() + len; // borrowed bytes may have been popped since the last append
+  reader.pop_into( span { data, len } );
+  block.used += len;
+  return { .owner = block.storage, .bytes = { data, len } };
+}
+
+void SendBuffer::release( uint64_t offset )
+{
+  while ( not blocks_.empty() and blocks_.front().end <= offset ) {
+    // A slice still held elsewhere keeps its block; otherwise the block is reused.
+    if ( blocks_.front().storage.use_count() == 1 ) {
+      spare_.push_back( move( blocks_.front().storage ) );
+    }
+    blocks_.pop_front();
+  }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "byte_stream.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+// The sender's copy of the payload bytes it has sent but not yet seen acknowledged.
+// Bytes leave the outbound ByteStream once, into fixed-size refcounted blocks that are
+// used as a ring, and every segment's payload is a SharedSlice of one block: sending,
+// keeping a segment for retransmission and sending it again copy nothing. Blocks are
+// released in bulk as the cumulative ACK passes them, and go back into rotation unless a
+// message somewhere still holds a slice, which then keeps the bytes alive unchanged.
+// Bytes the stream only borrows (Reader::peek_borrowed) skip the blocks: the segment
+// shares their owner instead.
+class SendBuffer
+{
+public:
+  static constexpr uint64_t DEFAULT_BLOCK_SIZE = 16 * 1024;
+
+  explicit SendBuffer( uint64_t block_size = DEFAULT_BLOCK_SIZE ) : block_size_( block_size ) {}
+
+  // Move up to `len` bytes (at most one block's worth) from `reader` into the buffer,
+  // contiguously, and return a slice of them. A borrowed run is returned without a copy.
+  SharedSlice append( Reader& reader, uint64_t len );
+
+  // Every stream byte before `offset` has been acknowledged.
+  void release( uint64_t offset );
+
+  size_t blocks_held() const { return blocks_.size(); }           // not yet released
+  uint64_t blocks_allocated() const { return blocks_allocated_; } // ever, not counting reuse
+
+private:
+  struct Block
+  {
+    std::shared_ptr<std::string> storage;
+    uint64_t used {};
+    uint64_t end {}; // stream offset just past its last byte
+  };
+
+  uint64_t block_size_;
+  std::deque<Block> blocks_ {};                        // oldest first; the back one is being filled
+  std::vector<std::shared_ptr<std::string>> spare_ {}; // released blocks no slice refers to
+  uint64_t blocks_allocated_ {};
+};
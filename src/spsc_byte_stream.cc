@@ -0,0 +1,146 @@
+#ifdef __linux__
+
+#include "spsc_byte_stream.hh"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+// Lost-wakeup argument: the producer stores bytes_pushed_ and then loads
+// bytes_popped_; the consumer stores bytes_popped_ and then loads
+// bytes_pushed_. Both are sequentially consistent, so at least one side sees
+// the other's store: either the producer notices the consumer had drained
+// everything and notifies, or the consumer's next check already sees the new
+// bytes. The full-stream wakeup for the producer is the mirror image.
+
+SpscByteStream::SpscByteStream( uint64_t capacity ) : capacity_( capacity ), ring_( capacity ) {}
+
+void SpscByteStream::set_error()
+{
+  error_.store( true );
+  reader_wakeup_.notify();
+  writer_wakeup_.notify();
+}
+
+void SpscWriter::push( string_view data )
+{
+  const span<char> region = reserve( data.size() );
+  if ( region.empty() ) {
+    return;
+  }
+  memcpy( region.data(), data.data(), region.size() );
+  commit( region.size() );
+}
+
+span<char> SpscWriter::reserve( uint64_t len )
+{
+  const uint64_t pushed = bytes_pushed_.load( memory_order_relaxed ); // only this thread stores it
+  reserved_ = min( len, available_capacity() );
+  if ( reserved_ == 0 ) {
+    return {};
+  }
+  return { ring_.at( pushed ), reserved_ };
+}
+
+void SpscWriter::commit( uint64_t len )
+{
+  len = min( len, reserved_ );
+  reserved_ = 0;
+  if ( len == 0 ) {
+    return;
+  }
+
+  const uint64_t old_pushed = bytes_pushed_.load( memory_order_relaxed );
+  bytes_pushed_.store( old_pushed + len );
+  if ( bytes_popped_.load() == old_pushed ) {
+    reader_wakeup_.notify(); // the Reader had drained everything and may be asleep
+  }
+}
+
+void SpscWriter::close()
+{
+  closed_.store( true );
+  reader_wakeup_.notify();
+}
+
+bool SpscWriter::is_closed() const
+{
+  return closed_.load();
+}
+
+uint64_t SpscWriter::available_capacity() const
+{
+  return capacity_ - ( bytes_pushed_.load( memory_order_relaxed ) - bytes_popped_.load() );
+}
+
+uint64_t SpscWriter::bytes_pushed() const
+{
+  return bytes_pushed_.load( memory_order_relaxed );
+}
+
+string_view SpscReader::peek() const
+{
+  const uint64_t popped = bytes_popped_.load( memory_order_relaxed ); // only this thread stores it
+  const uint64_t pushed = bytes_pushed_.load();
+  if ( pushed == popped ) {
+    return {};
+  }
+  return { ring_.at( popped ), pushed - popped };
+}
+
+void SpscReader::pop( uint64_t len )
+{
+  const uint64_t old_popped = bytes_popped_.load( memory_order_relaxed );
+  len = min( len, bytes_pushed_.load() - old_popped );
+  if ( len == 0 ) {
+    return;
+  }
+
+  bytes_popped_.store( old_popped + len );
+  if ( bytes_pushed_.load() == old_popped + capacity_ ) {
+    writer_wakeup_.notify(); // the Writer had filled the stream and may be asleep
+  }
+}
+
+bool SpscReader::is_finished() const
+{
+  // closed_ is stored after the final push, so once it reads true the final bytes_pushed_ is visible too.
+  return closed_.load() and bytes_buffered() == 0;
+}
+
+uint64_t SpscReader::bytes_buffered() const
+{
+  return bytes_pushed_.load() - bytes_popped_.load( memory_order_relaxed );
+}
+
+uint64_t SpscReader::bytes_popped() const
+{
+  return bytes_popped_.load( memory_order_relaxed );
+}
+
+SpscReader& SpscByteStream::reader()
+{
+  static_assert( sizeof( SpscReader ) == sizeof( SpscByteStream ),
+                 "Please add member variables to the SpscByteStream base, not the SpscReader." );
+  return static_cast<SpscReader&>( *this ); // NOLINT(*-downcast)
+}
+
+const SpscReader& SpscByteStream::reader() const
+{
+  return static_cast<const SpscReader&>( *this ); // NOLINT(*-downcast)
+}
+
+SpscWriter& SpscByteStream::writer()
+{
+  static_assert( sizeof( SpscWriter ) == sizeof( SpscByteStream ),
+                 "Please add member variables to the SpscByteStream base, not the SpscWriter." );
+  return static_cast<SpscWriter&>( *this ); // NOLINT(*-downcast)
+}
+
+const SpscWriter& SpscByteStream::writer() const
+{
+  return static_cast<const SpscWriter&>( *this ); // NOLINT(*-downcast)
+}
+
+#endif // __linux__
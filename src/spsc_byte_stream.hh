@@ -0,0 +1,115 @@
+#pragma once
+
+#ifdef __linux__
+
+#include "eventfd.hh"
+#include "mirrored_ring.hh"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+class SpscReader;
+class SpscWriter;
+
+// A bounded byte stream shared by exactly one producer thread (the Writer) and
+// one consumer thread (the Reader), without locks.
+//
+// Bytes live in a MirroredRing, so peek() is always every buffered byte. The
+// producer publishes with bytes_pushed_ and the consumer with bytes_popped_;
+// the two counters sit on separate cache lines so neither side's stores
+// invalidate the other's hot state.
+//
+// Wakeups: each side owns an EventFD that is made readable only on an edge the
+// other side cares about -- the Reader's when bytes arrive in an empty stream
+// (or on close/error), the Writer's when a full stream gains space. An event
+// loop rule on that fd should call wakeup().clear() first and then do as much
+// work as it can; a notification that races with the clear is never lost.
+// Since the fd itself carries readiness, the rule's interest should follow
+// the stream's lifetime (e.g. `not is_finished()`), not bytes_buffered().
+//
+// SpscWriter methods may only be called from the producer thread and
+// SpscReader methods only from the consumer thread.
+//
+// Only the tests use it so far. TCPMinnowSocket still hands bytes between the owner
+// thread and the TCP thread through the _thread_data socketpair, because its owner-side
+// API is that socket's fd (bidirectional_stream_copy and CS144TCPSocket both poll it).
+// Moving the handoff onto a pair of these streams is tracked as a separate follow-up:
+//  - the owner gets an SpscWriter for outbound bytes and an SpscReader for inbound ones,
+//    polled through their wakeup() fds instead of the socketpair;
+//  - the TCP thread's rules 2 and 3 become non-fd rules paired with wakeup rules on the
+//    other two EventFDs, so the socketpair and its two syscalls per chunk go away;
+//  - shutdown and close map onto close() and set_error() on the two streams.
+class SpscByteStream
+{
+public:
+  explicit SpscByteStream( uint64_t capacity );
+
+  SpscReader& reader();
+  const SpscReader& reader() const;
+  SpscWriter& writer();
+  const SpscWriter& writer() const;
+
+  // Either side may flag an error; both sides are woken.
+  void set_error();
+  bool has_error() const { return error_.load(); }
+
+  // Shared between two threads: neither copyable nor movable.
+  SpscByteStream( const SpscByteStream& other ) = delete;
+  SpscByteStream& operator=( const SpscByteStream& other ) = delete;
+  SpscByteStream( SpscByteStream&& other ) = delete;
+  SpscByteStream& operator=( SpscByteStream&& other ) = delete;
+  ~SpscByteStream() = default;
+
+protected:
+  static constexpr size_t kCacheLine = 64;
+
+  // Written once at construction (or rarely), read by both sides.
+  uint64_t capacity_;
+  MirroredRing ring_;
+  EventFD reader_wakeup_ {};
+  EventFD writer_wakeup_ {};
+  std::atomic<bool> error_ {};
+  std::atomic<bool> closed_ {};
+
+  // Producer state.
+  alignas( kCacheLine ) std::atomic<uint64_t> bytes_pushed_ {};
+  uint64_t reserved_ {}; // length of the outstanding reserve() region
+
+  // Consumer state.
+  alignas( kCacheLine ) std::atomic<uint64_t> bytes_popped_ {};
+};
+
+class SpscWriter : public SpscByteStream
+{
+public:
+  void push( std::string_view data ); // Push data, truncated to available_capacity().
+  void close();                       // Signal end of stream; wakes the Reader.
+
+  // Same contract as Writer::reserve()/commit(): the region is the ring itself.
+  std::span<char> reserve( uint64_t len );
+  void commit( uint64_t len );
+
+  bool is_closed() const;
+  uint64_t available_capacity() const;
+  uint64_t bytes_pushed() const;
+
+  EventFD& wakeup() { return writer_wakeup_; } // readable when a full stream gains space
+};
+
+class SpscReader : public SpscByteStream
+{
+public:
+  std::string_view peek() const; // Every buffered byte, contiguous.
+  void pop( uint64_t len );      // Discard up to `len` bytes; wakes the Writer if it was full.
+
+  bool is_finished() const;
+  uint64_t bytes_buffered() const;
+  uint64_t bytes_popped() const;
+
+  EventFD& wakeup() { return reader_wakeup_; } // readable when an empty stream gains data, or on close
+};
+
+#endif // __linux__
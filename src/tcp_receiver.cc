@@ -1,6 +1,7 @@
 #include "tcp_receiver.hh"
 
 #include <algorithm>
+#include <array>
 
 using namespace std;
 
@@ -25,7 +26,7 @@ void TCPReceiver::receive( TCPSenderMessage message )
   const uint64_t abs_seqno = message.seqno.unwrap( *isn_, checkpoint );
   const uint64_t stream_index = message.SYN ? abs_seqno : abs_seqno - 1;
 
-  reassembler_.insert( stream_index, move( message.payload ), message.FIN );
+  reassembler_.insert( stream_index, message.payload.release(), message.FIN );
 }
 
 TCPReceiverMessage TCPReceiver::send() const
@@ -42,5 +43,13 @@ TCPReceiverMessage TCPReceiver::send() const
 
   // Acknowledge: SYN (1) + bytes received + (FIN if stream is closed).
   const uint64_t next_seqno = 1 + writer.bytes_pushed() + ( writer.is_closed() ? 1 : 0 );
-  return { .ackno = Wrap32::wrap( next_seqno, *isn_ ), .window_size = window_size, .RST = false };
+  TCPReceiverMessage msg { .ackno = Wrap32::wrap( next_seqno, *isn_ ), .window_size = window_size, .RST = false };
+
+  // Report what has arrived beyond the ackno, shifted by one for the SYN like the ackno itself.
+  array<Reassembler::Range, TCPReceiverMessage::MAX_SACK_BLOCKS> ranges {};
+  msg.sack_block_count = static_cast<uint8_t>( reassembler_.pending_ranges( ranges ) );
+  for ( size_t i = 0; i < msg.sack_block_count; ++i ) {
+    msg.sack_blocks[i] = { Wrap32::wrap( 1 + ranges[i].begin, *isn_ ), Wrap32::wrap( 1 + ranges[i].end, *isn_ ) };
+  }
+  return msg;
 }
@@ -2,6 +2,7 @@
 #include "tcp_config.hh"
 
 #include <algorithm>
+#include <optional>
 
 using namespace std;
 
@@ -25,12 +26,10 @@ bool TCPSender::send_segment( const TransmitFunction& transmit, uint64_t window_
   }
 
   // Pull as much payload as fits into both the window and a single segment.
-  const uint64_t payload_room = min( window_remaining - length, TCPConfig::MAX_PAYLOAD_SIZE );
+  const uint64_t payload_room = min( window_remaining - length, mss_ );
   Reader& reader = input_.reader();
-  while ( msg.payload.size() < payload_room and reader.bytes_buffered() > 0 ) {
-    const string_view view = reader.peek().substr( 0, payload_room - msg.payload.size() );
-    msg.payload.append( view );
-    reader.pop( view.size() );
+  if ( payload_room > 0 and reader.bytes_buffered() > 0 ) {
+    msg.payload = send_buffer_.append( reader, payload_room );
   }
   length += msg.payload.size();
 
@@ -46,12 +45,25 @@ bool TCPSender::send_segment( const TransmitFunction& transmit, uint64_t window_
   }
 
   transmit( msg );
+  if ( pacer_.has_value() ) {
+    pacer_->on_transmit( length );
+  }
+  if ( bytes_in_flight_ == 0 ) {
+    first_sent_ms_ = delivered_ms_ = now_ms_; // intervals start afresh after an idle period
+  }
   next_seqno_ += length;
   bytes_in_flight_ += length;
   syn_sent_ = syn_sent_ or msg.SYN;
   fin_sent_ = fin_sent_ or msg.FIN;
 
-  outstanding_.push_back( move( msg ) );
+  scoreboard_.on_send( next_seqno_ - length, length );
+  outstanding_.push_back( { .msg = move( msg ),
+                            .seqno = next_seqno_ - length,
+                            .sent_ms = now_ms_,
+                            .delivered = delivered_,
+                            .delivered_ms = delivered_ms_,
+                            .first_sent_ms = first_sent_ms_,
+                            .app_limited = app_limited_until_ != 0 } );
   if ( not timer_.is_running() ) {
     timer_.start();
   }
@@ -60,28 +72,150 @@ bool TCPSender::send_segment( const TransmitFunction& transmit, uint64_t window_
 
 void TCPSender::push( const TransmitFunction& transmit )
 {
-  // Treat a closed-window receiver as window=1 to allow probing (RFC 793 §3.7).
-  const uint64_t effective_window = zero_window_ ? 1 : window_size_;
-  const uint64_t abs_ack = next_seqno_ - bytes_in_flight_;
-  const uint64_t right_edge = abs_ack + effective_window;
+  paced_out_ = false;
+  if ( pacer_.has_value() ) {
+    pacer_->suggest_rate( congestion_control_->pacing_rate() );
+  }
+
+  // A fast retransmit isn't held back: the pacer only keeps it from adding to a burst.
+  if ( retransmit_pending_ and not outstanding_.empty() ) {
+    retransmit( transmit, outstanding_.front().seqno );
+  }
+  retransmit_pending_ = false;
+
+  // Until everything outstanding at a loss is acknowledged, SACK says what to resend (RFC 6675 §5.1).
+  const bool recovering = in_fast_recovery_ or next_seqno_ - bytes_in_flight_ < recover_;
+  if ( fast_retransmit_ and recovering and scoreboard_.sack_seen() ) {
+    push_by_pipe( transmit );
+  } else {
+    // Treat a closed-window receiver as window=1 to allow probing (RFC 793 §3.7).
+    uint64_t cwnd = congestion_control_->cwnd();
+    cwnd += min( recovery_inflation_, UINT64_MAX - cwnd );
+    const uint64_t effective_window = zero_window_ ? 1 : min<uint64_t>( window_size_, cwnd );
+    const uint64_t abs_ack = next_seqno_ - bytes_in_flight_;
+    const uint64_t right_edge = abs_ack + effective_window;
+
+    while ( next_seqno_ < right_edge and has_new_data() and not paced_out() ) {
+      if ( not send_segment( transmit, right_edge - next_seqno_ ) ) {
+        break;
+      }
+    }
+  }
+
+  // Out of data with window to spare: rate samples until what's in flight is delivered
+  // measure the application, not the network.
+  if ( input_.reader().bytes_buffered() == 0 and bytes_in_flight_ < congestion_control_->cwnd()
+       and not paced_out_ ) {
+    app_limited_until_ = max<uint64_t>( delivered_ + bytes_in_flight_, 1 );
+  }
+}
+
+void TCPSender::push_batch( const BatchTransmitFunction& transmit )
+{
+  push( collect_batch() );
+  flush_batch( transmit );
+}
+
+void TCPSender::tick_batch( uint64_t ms_since_last_tick, const BatchTransmitFunction& transmit )
+{
+  tick( ms_since_last_tick, collect_batch() );
+  flush_batch( transmit );
+}
+
+TCPSender::TransmitFunction TCPSender::collect_batch()
+{
+  return [this]( const TCPSenderMessage& msg ) { batch_.push_back( msg ); };
+}
+
+void TCPSender::flush_batch( const BatchTransmitFunction& transmit )
+{
+  if ( not batch_.empty() ) {
+    transmit( batch_ );
+  }
+  batch_.clear(); // the copies' slices would otherwise keep acknowledged blocks from being reused
+}
 
-  while ( next_seqno_ < right_edge and not fin_sent_ ) {
-    if ( not send_segment( transmit, right_edge - next_seqno_ ) ) {
+void TCPSender::push_by_pipe( const TransmitFunction& transmit )
+{
+  const uint64_t cwnd = congestion_control_->cwnd();
+  const uint64_t right_edge = next_seqno_ - bytes_in_flight_ + ( zero_window_ ? 1 : window_size_ );
+  while ( scoreboard_.pipe() + mss_ <= cwnd ) {
+    const uint64_t room = cwnd - scoreboard_.pipe();
+    const optional<SackScoreboard::Hole> hole = scoreboard_.next_hole();
+    const bool new_data = next_seqno_ < right_edge and has_new_data();
+    if ( ( not hole.has_value() and not new_data ) or paced_out() ) {
       break;
     }
+    if ( hole.has_value() and hole->lost ) {
+      retransmit( transmit, hole->seqno );
+    } else if ( new_data and send_segment( transmit, min( right_edge - next_seqno_, room ) ) ) {
+      continue;
+    } else if ( hole.has_value() ) {
+      retransmit( transmit, hole->seqno );
+    } else {
+      break;
+    }
+  }
+}
+
+void TCPSender::retransmit( const TransmitFunction& transmit, uint64_t seqno )
+{
+  const auto it = partition_point(
+    outstanding_.begin(), outstanding_.end(), [seqno]( const Outstanding& o ) { return o.seqno < seqno; } );
+  if ( it == outstanding_.end() or it->seqno != seqno ) {
+    return;
+  }
+  transmit( it->msg );
+  if ( pacer_.has_value() ) {
+    pacer_->on_transmit( it->msg.sequence_length() );
+  }
+  it->retransmitted = true;
+  scoreboard_.on_retransmit( seqno );
+}
+
+bool TCPSender::has_new_data() const
+{
+  return not syn_sent_ or input_.reader().bytes_buffered() > 0 or ( input_.writer().is_closed() and not fin_sent_ );
+}
+
+bool TCPSender::paced_out()
+{
+  paced_out_ = pacer_.has_value() and not pacer_->ready();
+  return paced_out_;
+}
+
+optional<uint64_t> TCPSender::ms_until_next_send() const
+{
+  if ( not paced_out_ ) {
+    return nullopt;
   }
+  return pacer_->ms_until_ready();
 }
 
 void TCPSender::receive( const TCPReceiverMessage& msg )
 {
   if ( msg.RST ) {
     outstanding_.clear();
+    send_buffer_.release( UINT64_MAX );
+    scoreboard_ = {};
     bytes_in_flight_ = 0;
+    in_fast_recovery_ = retransmit_pending_ = false;
     timer_.stop();
     input_.set_error();
     return;
   }
 
+  // The MSS option rides on the peer's SYN, so it arrives before anything has been delivered.
+  // A smaller MSS than ours is the most the peer will take in one segment (RFC 9293 §3.7.1).
+  if ( msg.mss.has_value() and *msg.mss > 0 and delivered_ == 0 ) {
+    const uint64_t mss = min<uint64_t>( *msg.mss, configured_mss_ );
+    if ( mss != mss_ ) {
+      mss_ = mss;
+      congestion_control_->set_mss( mss_ );
+    }
+  }
+
+  const bool window_changed = msg.window_size != window_size_;
   zero_window_ = ( msg.window_size == 0 );
   window_size_ = msg.window_size;
 
@@ -93,19 +227,84 @@ void TCPSender::receive( const TCPReceiverMessage& msg )
     return; // ACK for data we haven't sent — ignore.
   }
 
-  bool acked_anything = false;
+  const uint64_t prior_ackno = next_seqno_ - bytes_in_flight_;
+  uint64_t bytes_acked = 0;
+  bool retransmission_acked = false;
+  optional<uint64_t> rtt_ms;
+  optional<RateSample> rate;
+  uint64_t send_elapsed_ms = 0;
+  uint64_t ack_elapsed_ms = 0;
   while ( not outstanding_.empty() ) {
-    const TCPSenderMessage& seg = outstanding_.front();
-    const uint64_t seg_end = seg.seqno.unwrap( isn_, next_seqno_ ) + seg.sequence_length();
+    const Outstanding& front = outstanding_.front();
+    const uint64_t seg_end = front.seqno + front.msg.sequence_length();
     if ( seg_end > abs_ackno ) {
       break;
     }
-    bytes_in_flight_ -= seg.sequence_length();
+    bytes_acked += front.msg.sequence_length();
+    bytes_in_flight_ -= front.msg.sequence_length();
+    delivered_ += front.msg.sequence_length();
+    delivered_ms_ = now_ms_;
+
+    // Time the newest segment this ACK covers. If it covers any retransmission, the ACK may
+    // have been held up waiting for it, so there's no sample at all (Karn's algorithm).
+    retransmission_acked = retransmission_acked or front.retransmitted;
+    rtt_ms = retransmission_acked ? nullopt : optional { now_ms_ - front.sent_ms };
+    if ( not front.retransmitted ) {
+      rate = RateSample { .prior_delivered = front.delivered, .app_limited = front.app_limited };
+      send_elapsed_ms = front.sent_ms - front.first_sent_ms;
+      ack_elapsed_ms = delivered_ms_ - front.delivered_ms;
+      first_sent_ms_ = front.sent_ms;
+    }
     outstanding_.pop_front();
-    acked_anything = true;
+  }
+  if ( abs_ackno > 0 ) {
+    send_buffer_.release( abs_ackno - 1 ); // stream index of the first unacknowledged byte
+  }
+  if ( app_limited_until_ != 0 and delivered_ > app_limited_until_ ) {
+    app_limited_until_ = 0;
+  }
+  if ( rate.has_value() ) {
+    rate->delivered = delivered_ - rate->prior_delivered;
+    rate->interval_ms = max( send_elapsed_ms, ack_elapsed_ms );
+  }
+
+  scoreboard_.on_cumulative_ack( abs_ackno );
+  for ( const SackBlock& block : msg.sack() ) {
+    scoreboard_.on_sack( block.left.unwrap( isn_, next_seqno_ ), block.right.unwrap( isn_, next_seqno_ ) );
   }
 
-  if ( acked_anything ) {
+  // A duplicate ACK (RFC 5681 §2): nothing new acknowledged, the same window, data outstanding.
+  if ( fast_retransmit_ and abs_ackno == prior_ackno and bytes_in_flight_ > 0 and not window_changed ) {
+    on_duplicate_ack( abs_ackno );
+  }
+
+  if ( bytes_acked > 0 ) {
+    const bool was_in_recovery = in_fast_recovery_;
+    if ( in_fast_recovery_ and abs_ackno >= recover_ ) {
+      in_fast_recovery_ = false; // a full ACK: everything outstanding at the loss has arrived
+      recovery_inflation_ = 0;
+    } else if ( in_fast_recovery_ and not scoreboard_.sack_seen() ) {
+      // A partial ACK: the next segment was lost too. Resend it, and deflate the window by
+      // what was acknowledged, less the one segment the ACK itself shows has left (RFC 6582 §3.2).
+      recovery_inflation_ -= min( recovery_inflation_, bytes_acked );
+      if ( bytes_acked >= mss_ ) {
+        recovery_inflation_ += mss_;
+      }
+      retransmit_pending_ = true;
+    }
+    dup_acks_ = 0;
+
+    if ( rtt_ms.has_value() ) {
+      timer_.record_rtt( *rtt_ms );
+    }
+    congestion_control_->on_ack( { .now_ms = now_ms_,
+                                   .ackno = abs_ackno,
+                                   .bytes_acked = bytes_acked,
+                                   .bytes_in_flight = bytes_in_flight_,
+                                   .rtt_ms = rtt_ms,
+                                   .delivered = delivered_,
+                                   .rate = rate,
+                                   .in_recovery = was_in_recovery } );
     timer_.reset_backoff();
     if ( outstanding_.empty() ) {
       timer_.stop();
@@ -113,20 +312,72 @@ void TCPSender::receive( const TCPReceiverMessage& msg )
       timer_.start(); // restart with fresh RTO
     }
   }
+
+  // With SACK, loss is also inferred from DUP_THRESH segments SACKed above the first hole,
+  // whether or not the ACKs carrying them were duplicates (RFC 6675 §5 step 4).
+  if ( fast_retransmit_ and not in_fast_recovery_ and abs_ackno >= recover_ and scoreboard_.front_lost() ) {
+    enter_recovery();
+  }
+}
+
+void TCPSender::on_duplicate_ack( uint64_t ackno )
+{
+  ++dup_acks_;
+  if ( in_fast_recovery_ ) {
+    if ( not scoreboard_.sack_seen() ) {
+      recovery_inflation_ += mss_; // another segment has left the network
+    }
+    return;
+  }
+
+  // Only a loss in data sent since the last recovery or timeout starts a new one (RFC 6582 §4.1).
+  if ( dup_acks_ == DUP_ACK_THRESHOLD and ackno >= recover_ ) {
+    enter_recovery();
+  }
+}
+
+void TCPSender::enter_recovery()
+{
+  congestion_control_->on_loss( now_ms_, bytes_in_flight_ );
+  in_fast_recovery_ = true;
+  recover_ = next_seqno_;
+  if ( scoreboard_.sack_seen() ) {
+    scoreboard_.start_recovery(); // pipe, not an inflated window, limits what is sent
+  } else {
+    recovery_inflation_ = DUP_ACK_THRESHOLD * mss_;
+  }
+  retransmit_pending_ = true;
 }
 
 void TCPSender::tick( uint64_t ms_since_last_tick, const TransmitFunction& transmit )
 {
+  now_ms_ += ms_since_last_tick;
   timer_.tick( ms_since_last_tick );
-  if ( not timer_.is_expired() or outstanding_.empty() ) {
-    return;
+  if ( pacer_.has_value() ) {
+    pacer_->tick( ms_since_last_tick );
+  }
+  if ( timer_.is_expired() and not outstanding_.empty() ) {
+    on_timeout( transmit );
   }
 
-  transmit( outstanding_.front() );
+  // Segments held back by pacing go out as credit allows.
+  if ( paced_out_ ) {
+    push( transmit );
+  }
+}
+
+void TCPSender::on_timeout( const TransmitFunction& transmit )
+{
   // Don't penalize ourselves for retransmitting into a closed window — the
   // peer wasn't going to take it anyway.
   if ( not zero_window_ ) {
+    congestion_control_->on_rto( now_ms_, bytes_in_flight_ );
     timer_.record_retransmission();
+    scoreboard_.on_timeout();
+    in_fast_recovery_ = false;
+    recovery_inflation_ = dup_acks_ = 0;
+    recover_ = next_seqno_;
   }
+  retransmit( transmit, outstanding_.front().seqno );
   timer_.start();
 }
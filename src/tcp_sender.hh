@@ -1,32 +1,94 @@
 #pragma once
 
 #include "byte_stream.hh"
+#include "congestion_control.hh"
+#include "pacer.hh"
+#include "sack_scoreboard.hh"
+#include "send_buffer.hh"
+#include "tcp_config.hh"
 #include "tcp_receiver_message.hh"
 #include "tcp_sender_message.hh"
 #include "timer.hh"
 
 #include <deque>
 #include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
 
 // Drives the sending half of a TCP connection: turns the outbound ByteStream
 // into a sequence of TCPSenderMessages, retransmits on timeout, and consumes
-// ACKs / window updates from the peer.
+// ACKs / window updates from the peer. How much may be in flight is the smaller
+// of the receiver's window and the congestion controller's cwnd. If fast retransmit is
+// enabled, three duplicate ACKs trigger it and NewReno fast recovery; once the peer sends
+// SACK blocks, recovery follows RFC 6675 instead and resends every hole SACK reveals.
+// Optionally, a token bucket paces segments out at a rate instead of in bursts. Segments
+// carry up to the configured MSS, or less if the peer's SYN advertised a smaller one.
 class TCPSender
 {
 public:
-  TCPSender( ByteStream&& input, Wrap32 isn, uint64_t initial_RTO_ms )
-    : input_( std::move( input ) ), isn_( isn ), timer_( initial_RTO_ms )
+  TCPSender( ByteStream&& input,
+             Wrap32 isn,
+             uint64_t initial_RTO_ms,
+             CongestionControlAlgorithm congestion_control = CongestionControlAlgorithm::NewReno,
+             std::optional<RtoLimits> adaptive_rto = std::nullopt,
+             std::optional<PacingConfig> pacing = std::nullopt,
+             uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE,
+             bool fast_retransmit = false )
+    : input_( std::move( input ) )
+    , isn_( isn )
+    , configured_mss_( mss )
+    , mss_( mss )
+    , timer_( initial_RTO_ms, adaptive_rto )
+    , congestion_control_( CongestionControl::make( congestion_control, mss ) )
+    , pacer_( pacing )
+    , fast_retransmit_( fast_retransmit )
+  {}
+
+  // As above, with a controller supplied by the caller (e.g. one a test can observe).
+  TCPSender( ByteStream&& input,
+             Wrap32 isn,
+             uint64_t initial_RTO_ms,
+             std::unique_ptr<CongestionControl> congestion_control,
+             std::optional<RtoLimits> adaptive_rto = std::nullopt,
+             std::optional<PacingConfig> pacing = std::nullopt,
+             uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE,
+             bool fast_retransmit = false )
+    : input_( std::move( input ) )
+    , isn_( isn )
+    , configured_mss_( mss )
+    , mss_( mss )
+    , timer_( initial_RTO_ms, adaptive_rto )
+    , congestion_control_( std::move( congestion_control ) )
+    , pacer_( pacing )
+    , fast_retransmit_( fast_retransmit )
   {}
 
   using TransmitFunction = std::function<void( const TCPSenderMessage& )>;
 
-  // Emit segments until either the input is drained or the send window is full.
+  // Emit segments until either the input is drained or the send window is full,
+  // after any retransmission that duplicate or partial ACKs have called for.
+  // With pacing, new segments also wait for the token bucket.
   void push( const TransmitFunction& transmit );
 
   // Advance time; retransmit the oldest unacked segment if the RTO has elapsed.
+  // With pacing, also release whatever segments the bucket now allows.
   void tick( uint64_t ms_since_last_tick, const TransmitFunction& transmit );
 
-  // Process an ACK / window-update / RST from the peer.
+  // As push() and tick(), but everything sent is handed over at once, as a train of segments,
+  // for a caller that can write many per system call (endtoend's adapter uses one sendmmsg(2);
+  // a TUN device still takes one write(2) per datagram). The messages' payloads are still
+  // slices of the send buffer: collecting them copies no bytes.
+  using BatchTransmitFunction = std::function<void( std::span<const TCPSenderMessage> )>;
+  void push_batch( const BatchTransmitFunction& transmit );
+  void tick_batch( uint64_t ms_since_last_tick, const BatchTransmitFunction& transmit );
+
+  // How long until pacing releases a segment it is holding back (0 if one may go now),
+  // so an event loop can sleep until then. nullopt if pacing is holding nothing back.
+  std::optional<uint64_t> ms_until_next_send() const;
+
+  // Process an ACK / window-update / RST from the peer, and its MSS option if it carries one.
   void receive( const TCPReceiverMessage& msg );
 
   // A "blank" segment carrying just the next seqno and the RST flag if errored.
@@ -35,7 +97,16 @@ public:
 
   // Test-only accessors.
   uint64_t sequence_numbers_in_flight() const { return bytes_in_flight_; }
+  uint64_t mss() const { return mss_; }
   uint64_t consecutive_retransmissions() const { return timer_.consecutive_retransmissions(); }
+  const CongestionControl& congestion_control() const { return *congestion_control_; }
+  bool in_fast_recovery() const { return in_fast_recovery_; }
+  uint64_t sequence_numbers_in_pipe() const { return scoreboard_.pipe(); }
+
+  // Round-trip times measured so far (never of retransmitted segments), and the RTO they give.
+  RttStats rtt_stats() const { return timer_.rtt_stats(); }
+
+  const SendBuffer& send_buffer() const { return send_buffer_; }
 
   const Writer& writer() const { return input_.writer(); }
   const Reader& reader() const { return input_.reader(); }
@@ -44,7 +115,14 @@ public:
 private:
   ByteStream input_;
   Wrap32 isn_;
+  uint64_t configured_mss_; // the most payload a segment may carry
+  uint64_t mss_;            // the same, or less if the peer's MSS option asked for less
   RetransmissionTimer timer_;
+  std::unique_ptr<CongestionControl> congestion_control_;
+  uint64_t now_ms_ {}; // total time passed to tick()
+  std::optional<Pacer> pacer_;
+  bool paced_out_ {}; // the last push() stopped for want of pacing credit
+  std::vector<TCPSenderMessage> batch_ {}; // a train being collected for push_batch() or tick_batch()
 
   // Receiver-advertised window. A zero window is treated as 1 for probing
   // (RFC 793 §3.7) — but retransmissions don't bump backoff in that case.
@@ -56,9 +134,60 @@ private:
   bool syn_sent_ {};
   bool fin_sent_ {};
 
-  std::deque<TCPSenderMessage> outstanding_ {};
+  // Delivery-rate estimation state: how much has been delivered, when the count last moved,
+  // when the newest segment acknowledged was sent, and the delivered count that will end
+  // an app-limited stretch (0 if not app-limited).
+  uint64_t delivered_ {};
+  uint64_t delivered_ms_ {};
+  uint64_t first_sent_ms_ {};
+  uint64_t app_limited_until_ {};
+
+  // Payload bytes sent but not yet acknowledged; outstanding segments hold slices of it.
+  SendBuffer send_buffer_ {};
+
+  // A segment awaiting acknowledgment, with a snapshot of the delivery state when it was
+  // sent, for RTT and delivery-rate samples.
+  struct Outstanding
+  {
+    TCPSenderMessage msg;
+    uint64_t seqno;         // absolute seqno of msg
+    uint64_t sent_ms;       // now_ms_ at first transmission
+    uint64_t delivered;     // delivered_ at that time
+    uint64_t delivered_ms;  // delivered_ms_ at that time
+    uint64_t first_sent_ms; // first_sent_ms_ at that time
+    bool app_limited;       // sent during an app-limited stretch
+    bool retransmitted {};  // an ACK for it can't be timed (Karn's algorithm)
+  };
+  std::deque<Outstanding> outstanding_ {};
+  SackScoreboard scoreboard_ {}; // the same segments, as the receiver's SACK blocks report them
+
+  // Fast retransmit and NewReno fast recovery (RFC 5681 §3.2, RFC 6582). Without them,
+  // only the retransmission timer resends anything.
+  bool fast_retransmit_;
+  static constexpr uint64_t DUP_ACK_THRESHOLD = 3;
+  uint64_t dup_acks_ {};
+  bool in_fast_recovery_ {};
+  uint64_t recover_ {};            // next_seqno_ when recovery (or a timeout) last began
+  uint64_t recovery_inflation_ {}; // window beyond cwnd for segments the duplicate ACKs say have left
+  bool retransmit_pending_ {};     // push() resends the oldest outstanding segment first
+
+  void on_duplicate_ack( uint64_t ackno );
+  void on_timeout( const TransmitFunction& transmit ); // the RTO expired with data outstanding
+  void enter_recovery();
+
+  // SACK-based recovery (RFC 6675 §5 step C): while pipe leaves room for a segment, send
+  // the next lost hole, else new data, else a hole below SACKed data.
+  void push_by_pipe( const TransmitFunction& transmit );
+  void retransmit( const TransmitFunction& transmit, uint64_t seqno );
+
+  // True (and remembered) if pacing forbids sending right now.
+  bool paced_out();
+  bool has_new_data() const; // a SYN, payload or FIN not yet sent
 
   // Build and transmit the next segment starting at next_seqno_, bounded by
   // `window_remaining` sequence numbers. Returns true iff a segment was sent.
   bool send_segment( const TransmitFunction& transmit, uint64_t window_remaining );
+
+  TransmitFunction collect_batch(); // appends to batch_
+  void flush_batch( const BatchTransmitFunction& transmit ); // hand over batch_, then drop it
 };
@@ -1,2 +1,52 @@
 #include "timer.hh"
-// All members of Timer / NetworkTimer / RetransmissionTimer are defined inline.
+
+#include <algorithm>
+
+using namespace std;
+
+// Timer and NetworkTimer are defined inline.
+
+void RetransmissionTimer::record_retransmission()
+{
+  ++consecutive_retransmissions_;
+  uint64_t backed_off = timer_.timeout_ms() * 2;
+  if ( adaptive_.has_value() ) {
+    backed_off = min( backed_off, max( adaptive_->max_ms, timer_.timeout_ms() ) );
+  }
+  timer_.set_timeout_ms( backed_off );
+}
+
+void RetransmissionTimer::record_rtt( uint64_t rtt_ms )
+{
+  // RFC 6298 (2.2) for the first sample, (2.3) after: RTTVAR gain 1/4, SRTT gain 1/8.
+  if ( rtt_samples_ == 0 ) {
+    srtt_x8_ = rtt_ms * 8;
+    rttvar_x8_ = rtt_ms * 4;
+  } else {
+    const uint64_t rtt_x8 = rtt_ms * 8;
+    const uint64_t error_x8 = srtt_x8_ > rtt_x8 ? srtt_x8_ - rtt_x8 : rtt_x8 - srtt_x8_;
+    rttvar_x8_ = rttvar_x8_ - rttvar_x8_ / 4 + error_x8 / 4;
+    srtt_x8_ = srtt_x8_ - srtt_x8_ / 8 + rtt_ms;
+  }
+  ++rtt_samples_;
+  latest_rtt_ms_ = rtt_ms;
+  min_rtt_ms_ = min( min_rtt_ms_, rtt_ms );
+
+  if ( adaptive_.has_value() ) {
+    const uint64_t rto_x8 = srtt_x8_ + max( CLOCK_GRANULARITY_MS * 8, 4 * rttvar_x8_ );
+    rto_ms_ = clamp( ( rto_x8 + 7 ) / 8, adaptive_->min_ms, max( adaptive_->min_ms, adaptive_->max_ms ) );
+  }
+}
+
+RttStats RetransmissionTimer::rtt_stats() const
+{
+  if ( rtt_samples_ == 0 ) {
+    return { .rto_ms = rto_ms_ };
+  }
+  return { .samples = rtt_samples_,
+           .latest_ms = latest_rtt_ms_,
+           .min_ms = min_rtt_ms_,
+           .smoothed_ms = ( srtt_x8_ + 4 ) / 8,
+           .variation_ms = ( rttvar_x8_ + 4 ) / 8,
+           .rto_ms = rto_ms_ };
+}
@@ -1,8 +1,11 @@
 
 #pragma once
 
+#include "tcp_tuning.hh"
+
 #include <cstddef>
 #include <cstdint>
+#include <optional>
 
 // A simple millisecond countdown timer. start() begins counting, tick() advances,
 // is_expired() reports whether timeout has been reached.
@@ -49,13 +52,28 @@ public:
   using Timer::Timer;
 };
 
+// Round-trip time statistics, as kept by RetransmissionTimer.
+struct RttStats
+{
+  uint64_t samples {};                     // RTT measurements taken so far
+  std::optional<uint64_t> latest_ms {};    // absent until the first sample
+  std::optional<uint64_t> min_ms {};       // smallest sample seen
+  std::optional<uint64_t> smoothed_ms {};  // SRTT
+  std::optional<uint64_t> variation_ms {}; // RTTVAR
+  uint64_t rto_ms {};                      // RTO a new transmission would get, without backoff
+};
+
 // Retransmission timer with exponential backoff. Owns a Timer plus the
-// current RTO and a count of consecutive retransmissions.
+// current RTO and a count of consecutive retransmissions. Given RtoLimits, the
+// RTO adapts to the RTT samples the caller reports (RFC 6298): SRTT + 4 * RTTVAR,
+// kept within the limits, backoff included. Samples must never come from
+// retransmitted segments (Karn's algorithm); that is the caller's job.
+// Without limits the RTO stays at initial_RTO_ms, and samples only feed the stats.
 class RetransmissionTimer
 {
 public:
-  explicit RetransmissionTimer( uint64_t initial_RTO_ms )
-    : initial_RTO_ms_( initial_RTO_ms ), timer_( initial_RTO_ms )
+  explicit RetransmissionTimer( uint64_t initial_RTO_ms, std::optional<RtoLimits> adaptive = std::nullopt )
+    : rto_ms_( initial_RTO_ms ), adaptive_( adaptive ), timer_( initial_RTO_ms )
   {}
 
   void start() { timer_.start(); }
@@ -68,23 +86,35 @@ public:
   // whether to start() or stop() afterwards depending on outstanding data.
   void reset_backoff()
   {
-    timer_.set_timeout_ms( initial_RTO_ms_ );
+    timer_.set_timeout_ms( rto_ms_ );
     consecutive_retransmissions_ = 0;
   }
 
   // RTO expired and a real retransmission is being sent (window > 0):
   // double the RTO and bump the count. Caller still calls start() to
   // restart the elapsed clock.
-  void record_retransmission()
-  {
-    ++consecutive_retransmissions_;
-    timer_.set_timeout_ms( timer_.timeout_ms() * 2 );
-  }
+  void record_retransmission();
+
+  // Fold in a round-trip measurement and recompute the RTO. The running
+  // timer keeps its current timeout until the next reset_backoff().
+  void record_rtt( uint64_t rtt_ms );
 
   uint64_t consecutive_retransmissions() const { return consecutive_retransmissions_; }
+  uint64_t timeout_ms() const { return timer_.timeout_ms(); } // current RTO, backoff included
+  RttStats rtt_stats() const;
 
 private:
-  uint64_t initial_RTO_ms_;
+  static constexpr uint64_t CLOCK_GRANULARITY_MS = 1; // G: tick() counts whole milliseconds
+
+  uint64_t rto_ms_;
+  std::optional<RtoLimits> adaptive_;
   Timer timer_;
   uint64_t consecutive_retransmissions_ {};
+
+  // SRTT and RTTVAR in eighths of a millisecond, so the 1/8 and 1/4 gains don't round away.
+  uint64_t srtt_x8_ {};
+  uint64_t rttvar_x8_ {};
+  uint64_t latest_rtt_ms_ {};
+  uint64_t min_rtt_ms_ { UINT64_MAX };
+  uint64_t rtt_samples_ {};
 };
@@ -1,5 +1,7 @@
 #include "wrapping_integers.hh"
 
+#include <algorithm>
+
 using namespace std;
 
 Wrap32 Wrap32::wrap( uint64_t n, Wrap32 zero_point )
@@ -7,31 +9,16 @@ Wrap32 Wrap32::wrap( uint64_t n, Wrap32 zero_point )
   return zero_point + static_cast<uint32_t>( n );
 }
 
-uint64_t Wrap32::unwrap( Wrap32 zero_point, uint64_t checkpoint ) const
+void Wrap32::unwrap_many( span<const Wrap32> seqnos, Wrap32 zero_point, uint64_t checkpoint, span<uint64_t> out )
 {
-  // Of all absolute seqnos that map to *this, return the one closest to `checkpoint`.
-  // Strategy: build the candidate that shares `checkpoint`'s upper 32 bits, then check
-  // its ±2^32 neighbours and pick whichever is nearest.
-  constexpr uint64_t kRound = 1ULL << 32;
-
-  const uint32_t offset = raw_value_ - zero_point.raw_value_;
-  const uint64_t candidate = ( checkpoint & ~static_cast<uint64_t>( UINT32_MAX ) ) | offset;
-
-  auto distance = [checkpoint]( uint64_t v ) { return v > checkpoint ? v - checkpoint : checkpoint - v; };
-
-  uint64_t best = candidate;
-  uint64_t best_dist = distance( candidate );
-
-  if ( candidate >= kRound ) {
-    const uint64_t prev = candidate - kRound;
-    if ( distance( prev ) < best_dist ) {
-      best = prev;
-      best_dist = distance( prev );
-    }
-  }
-  const uint64_t next = candidate + kRound;
-  if ( distance( next ) < best_dist ) {
-    best = next;
+  const Checkpoint hoisted { checkpoint };
+  const size_t n = min( seqnos.size(), out.size() );
+  for ( size_t i = 0; i < n; ++i ) {
+    out[i] = unwrap_offset( seqnos[i].raw_value_ - zero_point.raw_value_, hoisted );
   }
-  return best;
 }
+
+// unwrap() is usable in constant expressions.
+static_assert( Wrap32 { 1 }.unwrap( Wrap32 { 0 }, UINT32_MAX ) == ( uint64_t { 1 } << 32 ) + 1 );
+static_assert( Wrap32 { 0 }.unwrap( Wrap32 { 1 }, 1 ) == UINT32_MAX );
+static_assert( Wrap32 { UINT32_MAX }.unwrap( Wrap32 { INT32_MAX }, 0 ) == uint64_t { 1 } << 31 );
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <span>
 
 /*
  * The Wrap32 type represents a 32-bit unsigned integer that:
@@ -10,7 +11,7 @@
 class Wrap32
 {
 public:
-  explicit Wrap32( uint32_t raw_value ) : raw_value_( raw_value ) {}
+  explicit constexpr Wrap32( uint32_t raw_value ) : raw_value_( raw_value ) {}
 
   /* Construct a Wrap32 given an absolute sequence number n and the zero point. */
   static Wrap32 wrap( uint64_t n, Wrap32 zero_point );
@@ -22,11 +23,53 @@ public:
    * There are many possible absolute sequence numbers that all wrap to the same Wrap32.
    * The unwrap method should return the one that is closest to the checkpoint.
    */
-  uint64_t unwrap( Wrap32 zero_point, uint64_t checkpoint ) const;
+  constexpr uint64_t unwrap( Wrap32 zero_point, uint64_t checkpoint ) const
+  {
+    return unwrap_offset( raw_value_ - zero_point.raw_value_, Checkpoint { checkpoint } );
+  }
 
-  Wrap32 operator+( uint32_t n ) const { return Wrap32 { raw_value_ + n }; }
-  bool operator==( const Wrap32& other ) const { return raw_value_ == other.raw_value_; }
+  /*
+   * Unwrap seqnos[i] into out[i] for every i below min(seqnos.size(), out.size()), all relative
+   * to the same zero point and checkpoint. The loop is branch-free, so the compiler can vectorize it.
+   */
+  static void unwrap_many( std::span<const Wrap32> seqnos,
+                           Wrap32 zero_point,
+                           uint64_t checkpoint,
+                           std::span<uint64_t> out );
+
+  constexpr Wrap32 operator+( uint32_t n ) const { return Wrap32 { raw_value_ + n }; }
+  constexpr bool operator==( const Wrap32& other ) const { return raw_value_ == other.raw_value_; }
 
 protected:
   uint32_t raw_value_ {};
+
+private:
+  // The absolute seqno congruent to `offset` (mod 2^32) that is closest to `checkpoint`: step from
+  // the checkpoint by the signed 32-bit difference, then move up one wrap if that fell below zero
+  // (possible only for checkpoints under 2^31). An exact tie, a difference of 2^31, goes to the
+  // candidate sharing the checkpoint's upper 32 bits. Everything is plain integer arithmetic, with
+  // the per-checkpoint conditions computed once so a batch can hoist them.
+  struct Checkpoint
+  {
+    uint64_t value;
+    uint32_t low;
+    uint64_t near_zero; // 1 if value < 2^31
+    uint32_t low_half;  // 1 if low < 2^31
+
+    explicit constexpr Checkpoint( uint64_t checkpoint )
+      : value( checkpoint )
+      , low( static_cast<uint32_t>( checkpoint ) )
+      , near_zero( checkpoint < ( uint64_t { 1 } << 31 ) )
+      , low_half( low < ( 1U << 31 ) )
+    {}
+  };
+
+  static constexpr uint64_t unwrap_offset( uint32_t offset, const Checkpoint& checkpoint )
+  {
+    const uint32_t diff = offset - checkpoint.low;
+    const uint64_t stepped = checkpoint.value + static_cast<uint64_t>( static_cast<int32_t>( diff ) );
+    const uint64_t underflow = ( stepped >> 63 ) & checkpoint.near_zero;
+    const uint64_t tie_upward = static_cast<uint32_t>( diff == ( 1U << 31 ) ) & checkpoint.low_half;
+    return stepped + ( ( underflow | tie_upward ) << 32 );
+  }
 };
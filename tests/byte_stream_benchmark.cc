@@ -0,0 +1,368 @@
+#include "byte_stream.hh"
+#include "cycle_counter.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <optional>
+#include <random>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Sweeps ByteStream over capacity x write size x read size x storage and reports,
+// per configuration: ns/byte, Gbit/s, heap allocations per MB moved, and cycles/byte
+// (when perf_event_open(2) is permitted). Output is a table, JSON or CSV, so results
+// from different builds of minnow_optimized can be diffed or plotted.
+//
+// With no arguments it runs a small default sweep suitable for `ctest`.
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+// Heap allocations made while `counting_allocations` is set. Only the timed region counts.
+uint64_t allocation_count = 0;
+bool counting_allocations = false;
+
+} // namespace
+
+void* operator new( size_t size )
+{
+  if ( counting_allocations ) {
+    ++allocation_count;
+  }
+  if ( void* ptr = malloc( size ? size : 1 ) ) { // NOLINT(*-no-malloc)
+    return ptr;
+  }
+  throw bad_alloc {};
+}
+
+void operator delete( void* ptr ) noexcept
+{
+  free( ptr ); // NOLINT(*-no-malloc)
+}
+
+void operator delete( void* ptr, size_t /* size */ ) noexcept
+{
+  free( ptr ); // NOLINT(*-no-malloc)
+}
+
+namespace {
+
+struct Config
+{
+  ByteStream::Storage storage;
+  uint64_t capacity;
+  uint64_t write_size;
+  uint64_t read_size;
+};
+
+struct Result
+{
+  Config config;
+  uint64_t bytes;
+  double ns_per_byte;
+  double gigabits_per_second;
+  double allocations_per_mb;
+  optional<double> cycles_per_byte;
+};
+
+struct Options
+{
+  enum class Format : uint8_t
+  {
+    Text,
+    JSON,
+    CSV
+  };
+
+  Format format = Format::Text;
+  vector<ByteStream::Storage> storages { ByteStream::Storage::Segmented, ByteStream::Storage::MirroredRing };
+  vector<uint64_t> capacities { 4096, 32768, 262144 };
+  vector<uint64_t> write_sizes { 64, 1500, 4096 };
+  vector<uint64_t> read_sizes { 32, 1500, 65536 };
+  uint64_t bytes = 1'000'000;
+  unsigned repeat = 1;
+  double min_gbps = 0.1;
+};
+
+string_view storage_name( ByteStream::Storage storage )
+{
+  return storage == ByteStream::Storage::MirroredRing ? "ring" : "segmented";
+}
+
+Result run_one( const Config& config, const string& data, unsigned repeat, CycleCounter& cycles )
+{
+  // Split the data into segments before timing
+  vector<string> split_data;
+  Result best { config, data.size(), 0, 0, 0, {} };
+
+  for ( unsigned round = 0; round < repeat; ++round ) {
+    split_data.clear();
+    for ( size_t i = 0; i < data.size(); i += config.write_size ) {
+      split_data.emplace_back( data.substr( i, config.write_size ) );
+    }
+
+    ByteStream bs { config.capacity, config.storage };
+    string output_data;
+    output_data.reserve( data.size() );
+    size_t next_write = 0;
+
+    allocation_count = 0;
+    counting_allocations = true;
+    cycles.start();
+    const auto start_time = steady_clock::now();
+
+    while ( not bs.reader().is_finished() ) {
+      if ( next_write == split_data.size() ) {
+        if ( not bs.writer().is_closed() ) {
+          bs.writer().close();
+        }
+      } else if ( split_data[next_write].size() <= bs.writer().available_capacity() ) {
+        bs.writer().push( move( split_data[next_write] ) );
+        ++next_write;
+      }
+
+      if ( bs.reader().bytes_buffered() ) {
+        const auto peeked = bs.reader().peek().substr( 0, config.read_size );
+        output_data += peeked;
+        bs.reader().pop( peeked.size() );
+      }
+    }
+
+    const auto stop_time = steady_clock::now();
+    const optional<uint64_t> cycle_count = cycles.stop();
+    counting_allocations = false;
+
+    if ( data != output_data ) {
+      throw runtime_error( "Mismatch between data written and read" );
+    }
+
+    const auto bytes = static_cast<double>( data.size() );
+    const double ns_per_byte = static_cast<double>( duration_cast<nanoseconds>( stop_time - start_time ).count() )
+                               / bytes;
+
+    // keep the fastest round
+    if ( round == 0 or ns_per_byte < best.ns_per_byte ) {
+      best.ns_per_byte = ns_per_byte;
+      best.gigabits_per_second = 8 / ns_per_byte;
+      best.allocations_per_mb = static_cast<double>( allocation_count ) / ( bytes / 1e6 );
+      if ( cycle_count ) {
+        best.cycles_per_byte = static_cast<double>( *cycle_count ) / bytes;
+      }
+    }
+  }
+
+  return best;
+}
+
+void print_text( const vector<Result>& results, bool have_cycles )
+{
+  cout << left << setw( 10 ) << "storage" << right << setw( 9 ) << "capacity" << setw( 7 ) << "write" << setw( 7 )
+       << "read" << setw( 10 ) << "ns/byte" << setw( 9 ) << "Gbit/s" << setw( 11 ) << "allocs/MB" << setw( 13 )
+       << "cycles/byte\n";
+  for ( const auto& r : results ) {
+    cout << left << setw( 10 ) << storage_name( r.config.storage ) << right << setw( 9 ) << r.config.capacity
+         << setw( 7 ) << r.config.write_size << setw( 7 ) << r.config.read_size << fixed << setprecision( 3 )
+         << setw( 10 ) << r.ns_per_byte << setprecision( 2 ) << setw( 9 ) << r.gigabits_per_second << setw( 11 )
+         << r.allocations_per_mb << setw( 12 );
+    if ( r.cycles_per_byte ) {
+      cout << *r.cycles_per_byte;
+    } else {
+      cout << "n/a";
+    }
+    cout << "\n";
+  }
+  if ( not have_cycles ) {
+    cout << "(cycle counter unavailable: perf_event_open(2) not permitted here)\n";
+  }
+}
+
+void print_json( const vector<Result>& results )
+{
+  cout << "[\n";
+  for ( size_t i = 0; i < results.size(); ++i ) {
+    const auto& r = results[i];
+    cout << "  {\"storage\": \"" << storage_name( r.config.storage ) << "\", \"capacity\": " << r.config.capacity
+         << ", \"write_size\": " << r.config.write_size << ", \"read_size\": " << r.config.read_size
+         << ", \"bytes\": " << r.bytes << setprecision( 6 ) << ", \"ns_per_byte\": " << r.ns_per_byte
+         << ", \"gbit_per_s\": " << r.gigabits_per_second << ", \"allocs_per_mb\": " << r.allocations_per_mb
+         << ", \"cycles_per_byte\": ";
+    if ( r.cycles_per_byte ) {
+      cout << *r.cycles_per_byte;
+    } else {
+      cout << "null";
+    }
+    cout << "}" << ( i + 1 < results.size() ? "," : "" ) << "\n";
+  }
+  cout << "]\n";
+}
+
+void print_csv( const vector<Result>& results )
+{
+  cout << "storage,capacity,write_size,read_size,bytes,ns_per_byte,gbit_per_s,allocs_per_mb,cycles_per_byte\n";
+  for ( const auto& r : results ) {
+    cout << storage_name( r.config.storage ) << "," << r.config.capacity << "," << r.config.write_size << ","
+         << r.config.read_size << "," << r.bytes << "," << setprecision( 6 ) << r.ns_per_byte << ","
+         << r.gigabits_per_second << "," << r.allocations_per_mb << ",";
+    if ( r.cycles_per_byte ) {
+      cout << *r.cycles_per_byte;
+    }
+    cout << "\n";
+  }
+}
+
+vector<uint64_t> parse_list( const string& arg )
+{
+  vector<uint64_t> ret;
+  stringstream ss { arg };
+  for ( string item; getline( ss, item, ',' ); ) {
+    ret.push_back( stoull( item ) );
+  }
+  if ( ret.empty() ) {
+    throw runtime_error( "empty list: " + arg );
+  }
+  return ret;
+}
+
+void show_usage( const char* argv0 )
+{
+  cerr << "Usage: " << argv0 << " [options]\n\n"
+       << "   --format <text|json|csv>       Output format                     (text)\n"
+       << "   --storage <segmented|ring|all> ByteStream storage backend(s)     (all)\n"
+       << "   --capacity <n,n,...>           Capacities to sweep               (4096,32768,262144)\n"
+       << "   --write <n,n,...>              Write sizes to sweep              (64,1500,4096)\n"
+       << "   --read <n,n,...>               Read sizes to sweep               (32,1500,65536)\n"
+       << "   --bytes <n>                    Bytes moved per configuration     (1000000)\n"
+       << "   --repeat <n>                   Rounds per configuration; best is reported (1)\n"
+       << "   --min-gbps <x>                 Fail if any configuration is slower (0.1)\n\n"
+       << "Configurations whose write size exceeds the capacity are skipped.\n";
+}
+
+Options get_options( span<char*> args )
+{
+  Options opts;
+  for ( size_t i = 1; i < args.size(); i += 2 ) {
+    if ( i + 1 >= args.size() ) {
+      throw runtime_error( "missing argument to "s + args[i] );
+    }
+    const string_view flag = args[i];
+    const string value = args[i + 1];
+
+    if ( flag == "--format" ) {
+      if ( value == "text" ) {
+        opts.format = Options::Format::Text;
+      } else if ( value == "json" ) {
+        opts.format = Options::Format::JSON;
+      } else if ( value == "csv" ) {
+        opts.format = Options::Format::CSV;
+      } else {
+        throw runtime_error( "unknown format: " + value );
+      }
+    } else if ( flag == "--storage" ) {
+      if ( value == "segmented" ) {
+        opts.storages = { ByteStream::Storage::Segmented };
+      } else if ( value == "ring" ) {
+        opts.storages = { ByteStream::Storage::MirroredRing };
+      } else if ( value != "all" ) {
+        throw runtime_error( "unknown storage: " + value );
+      }
+    } else if ( flag == "--capacity" ) {
+      opts.capacities = parse_list( value );
+    } else if ( flag == "--write" ) {
+      opts.write_sizes = parse_list( value );
+    } else if ( flag == "--read" ) {
+      opts.read_sizes = parse_list( value );
+    } else if ( flag == "--bytes" ) {
+      opts.bytes = stoull( value );
+    } else if ( flag == "--repeat" ) {
+      opts.repeat = max( 1U, static_cast<unsigned>( stoul( value ) ) );
+    } else if ( flag == "--min-gbps" ) {
+      opts.min_gbps = stod( value );
+    } else {
+      throw runtime_error( "unknown option: " + string { flag } );
+    }
+  }
+  return opts;
+}
+
+void program_body( const Options& opts )
+{
+  // Generate the data to be written
+  const string data = [&] {
+    default_random_engine rd { 789 };
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < opts.bytes; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  CycleCounter cycles;
+  vector<Result> results;
+
+  for ( const auto storage : opts.storages ) {
+    for ( const auto capacity : opts.capacities ) {
+      for ( const auto write_size : opts.write_sizes ) {
+        if ( write_size == 0 or write_size > capacity ) {
+          continue; // the writer only pushes whole writes, so it would never make progress
+        }
+        for ( const auto read_size : opts.read_sizes ) {
+          results.push_back( run_one( { storage, capacity, write_size, read_size }, data, opts.repeat, cycles ) );
+        }
+      }
+    }
+  }
+
+  switch ( opts.format ) {
+    case Options::Format::Text:
+      print_text( results, cycles.available() );
+      break;
+    case Options::Format::JSON:
+      print_json( results );
+      break;
+    case Options::Format::CSV:
+      print_csv( results );
+      break;
+  }
+
+  for ( const auto& r : results ) {
+    if ( r.gigabits_per_second < opts.min_gbps ) {
+      throw runtime_error( "ByteStream (" + string { storage_name( r.config.storage ) }
+                           + ", capacity=" + to_string( r.config.capacity ) + ", write_size="
+                           + to_string( r.config.write_size ) + ", read_size=" + to_string( r.config.read_size )
+                           + ") did not meet minimum speed of " + to_string( opts.min_gbps ) + " Gbit/s" );
+    }
+  }
+}
+
+} // namespace
+
+int main( int argc, char* argv[] )
+{
+  try {
+    if ( argc <= 0 ) {
+      abort();
+    }
+    const auto args = span( argv, argc );
+    if ( argc == 2 and ( args[1] == "-h"s or args[1] == "--help"s ) ) {
+      show_usage( args[0] );
+      return EXIT_SUCCESS;
+    }
+    program_body( get_options( args ) );
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
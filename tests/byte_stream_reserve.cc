@@ -0,0 +1,106 @@
+#include "byte_stream_test_harness.hh"
+#include "test_should_be.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+
+void reserve_tests( ByteStream::Storage storage )
+{
+  {
+    ByteStreamTestHarness test { "reserve-commit", 15, storage };
+
+    test.execute( ReserveCommit { 3, "cat" } );
+    test.execute( BytesPushed { 3 } );
+    test.execute( AvailableCapacity { 12 } );
+    test.execute( Peek { "cat" } );
+
+    test.execute( Push { "tac" } );
+    test.execute( ReserveCommit { 100, "dog" } );
+    test.execute( BytesPushed { 9 } );
+    test.execute( BytesBuffered { 9 } );
+    test.execute( Peek { "cattacdog" } );
+
+    test.execute( Close {} );
+    test.execute( ReadAll { "cattacdog" } );
+    test.execute( IsFinished { true } );
+  }
+
+  {
+    ByteStreamTestHarness test { "reserve-bounded-by-capacity", 4, storage };
+
+    test.execute( ReserveCommit { 10, "catdog" } );
+    test.execute( BytesPushed { 4 } );
+    test.execute( AvailableCapacity { 0 } );
+    test.execute( Peek { "catd" } );
+    test.execute( ReserveCommit { 10, "x" } );
+    test.execute( BytesPushed { 4 } );
+
+    test.execute( Pop { 3 } );
+    test.execute( ReserveCommit { 10, "og" } );
+    test.execute( BytesPushed { 6 } );
+    test.execute( AvailableCapacity { 1 } );
+    test.execute( Peek { "dog" } );
+  }
+
+  {
+    ByteStreamTestHarness test { "partial-commit", 15, storage };
+
+    test.execute( ReserveCommit { 8, "ab" } );
+    test.execute( BytesPushed { 2 } );
+    test.execute( AvailableCapacity { 13 } );
+    test.execute( ReserveCommit { 8, "" } );
+    test.execute( BytesPushed { 2 } );
+    test.execute( ReserveCommit { 8, "cdefgh" } );
+    test.execute( Peek { "abcdefgh" } );
+  }
+}
+
+// A commit that fills most of a segmented stream's staging buffer lends it to the segment rather than
+// copying it, and the buffer is reused once that segment is popped.
+void test_segmented_handover()
+{
+  ByteStream stream { 64, ByteStream::Storage::Segmented };
+  auto region = stream.writer().reserve( 64 );
+  const char* staged = region.data();
+  string( 40, 'x' ).copy( region.data(), 40 );
+  stream.writer().commit( 40 );
+  test_should_be( uint64_t { stream.reader().peek().data() == staged }, uint64_t { 1 } );
+
+  region = stream.writer().reserve( 24 ); // the segment still borrows the first buffer
+  test_should_be( uint64_t { region.data() == staged }, uint64_t { 0 } );
+  string( 4, 'y' ).copy( region.data(), 4 );
+  stream.writer().commit( 4 );
+  test_should_be( stream.reader().bytes_buffered(), uint64_t { 44 } );
+
+  stream.reader().pop( 44 );
+  region = stream.writer().reserve( 24 ); // the short commit was copied out, so this buffer is free
+  const char* second = region.data();
+  stream.writer().commit( 0 );
+  test_should_be( uint64_t { stream.writer().reserve( 24 ).data() == second }, uint64_t { 1 } );
+
+  ByteStream looped { 64, ByteStream::Storage::Segmented };
+  staged = looped.writer().reserve( 64 ).data();
+  looped.writer().commit( 40 );
+  looped.reader().pop( 40 );
+  test_should_be( uint64_t { looped.writer().reserve( 64 ).data() == staged }, uint64_t { 1 } );
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    reserve_tests( ByteStream::Storage::Segmented );
+    reserve_tests( ByteStream::Storage::MirroredRing );
+    test_segmented_handover();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
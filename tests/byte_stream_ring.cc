@@ -0,0 +1,87 @@
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+constexpr auto ring = ByteStream::Storage::MirroredRing;
+}
+
+int main()
+{
+  try {
+    {
+      ByteStreamTestHarness test { "ring: peek spans every push", 15, ring };
+
+      test.execute( Push { "cat" } );
+      test.execute( Push { "tac" } );
+      test.execute( BytesBuffered { 6 } );
+      test.execute( AvailableCapacity { 9 } );
+      test.execute( PeekOnce { "cattac" } );
+
+      test.execute( Pop { 2 } );
+      test.execute( PeekOnce { "ttac" } );
+      test.execute( Close {} );
+      test.execute( ReadAll { "ttac" } );
+      test.execute( IsFinished { true } );
+    }
+
+    {
+      ByteStreamTestHarness test { "ring: overwrite truncates to capacity", 2, ring };
+
+      test.execute( Push { "cat" } );
+      test.execute( BytesPushed { 2 } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( PeekOnce { "ca" } );
+      test.execute( Pop { 1 } );
+      test.execute( Push { "tac" } );
+      test.execute( BytesPushed { 3 } );
+      test.execute( PeekOnce { "at" } );
+    }
+
+    {
+      // The ring is a whole number of pages; push and pop enough to lap it
+      // several times so reads and writes straddle the mirror boundary.
+      const uint64_t capacity = 5000;
+      ByteStreamTestHarness test { "ring: wraparound stays contiguous", capacity, ring };
+
+      string expected;
+      uint64_t pushed = 0;
+      for ( unsigned round = 0; round < 30; ++round ) {
+        string chunk;
+        for ( unsigned i = 0; i < 1499; ++i ) {
+          chunk.push_back( static_cast<char>( 'a' + ( pushed + i ) % 26 ) );
+        }
+        test.execute( Push { chunk } );
+        pushed += chunk.size();
+        expected += chunk;
+
+        test.execute( PeekOnce { expected } );
+        test.execute( Pop { 1400 } );
+        expected.erase( 0, 1400 );
+        test.execute( BytesBuffered { expected.size() } );
+      }
+      test.execute( Close {} );
+      test.execute( ReadAll { expected } );
+      test.execute( IsFinished { true } );
+    }
+
+    {
+      ByteStreamTestHarness test { "ring: zero capacity", 0, ring };
+
+      test.execute( Push { "cat" } );
+      test.execute( BytesPushed { 0 } );
+      test.execute( BufferEmpty { true } );
+      test.execute( PeekOnce { "" } );
+      test.execute( Close {} );
+      test.execute( IsFinished { true } );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
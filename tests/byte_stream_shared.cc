@@ -0,0 +1,64 @@
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+#include <memory>
+
+using namespace std;
+
+int main()
+{
+  try {
+    {
+      ByteStreamTestHarness test { "shared slice is borrowed", 15 };
+      const auto owner = make_shared<const string>( "catdog" );
+
+      test.execute( Push { "a" } );
+      test.execute( PushShared { owner } );
+      test.execute( BytesPushed { 7 } );
+      test.execute( Peek { "acatdog" } );
+      test.execute( Pop { 1 } );
+      test.execute( PeekBorrows { owner, true } );
+      test.execute( Pop { 2 } );
+      test.execute( PeekOnce { "tdog" } );
+      test.execute( PeekBorrows { owner, true } );
+      test.execute( Close {} );
+      test.execute( ReadAll { "tdog" } );
+      test.execute( IsFinished { true } );
+    }
+
+    {
+      ByteStreamTestHarness test { "shared slice truncated to capacity", 4 };
+      const auto owner = make_shared<const string>( "catdog" );
+
+      test.execute( PushShared { owner } );
+      test.execute( BytesPushed { 4 } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( PeekOnce { "catd" } );
+      test.execute( PeekBorrows { owner, true } );
+    }
+
+    {
+      ByteStreamTestHarness test { "shared slice outlives the caller's handle", 15 };
+
+      test.execute( PushShared { make_shared<const string>( "hello" ) } );
+      test.execute( Push { " world" } );
+      test.execute( Close {} );
+      test.execute( ReadAll { "hello world" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "shared slice is copied into a ring", 15, ByteStream::Storage::MirroredRing };
+      const auto owner = make_shared<const string>( "catdog" );
+
+      test.execute( PushShared { owner } );
+      test.execute( PeekOnce { "catdog" } );
+      test.execute( PeekBorrows { owner, false } );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
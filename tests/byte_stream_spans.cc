@@ -0,0 +1,72 @@
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    {
+      ByteStreamTestHarness test { "peek_spans covers every segment", 15 };
+
+      test.execute( PeekSpans { 8, {} } );
+      test.execute( Push { "cat" } );
+      test.execute( Push { "tac" } );
+      test.execute( Push { "dog" } );
+      test.execute( PeekSpans { 8, { "cat", "tac", "dog" } } );
+
+      test.execute( Pop { 1 } );
+      test.execute( PeekSpans { 8, { "at", "tac", "dog" } } );
+      test.execute( Pop { 3 } );
+      test.execute( PeekSpans { 8, { "ac", "dog" } } );
+      test.execute( BytesBuffered { 5 } );
+    }
+
+    {
+      ByteStreamTestHarness test { "peek_spans respects max_iov", 15 };
+
+      test.execute( Push { "a" } );
+      test.execute( Push { "bc" } );
+      test.execute( Push { "def" } );
+      test.execute( PeekSpans { 2, { "a", "bc" } } );
+      test.execute( PeekSpans { 1, { "a" } } );
+      test.execute( PeekSpans { 0, {} } );
+    }
+
+    {
+      ByteStreamTestHarness test { "peek_spans on a ring is one span", 15, ByteStream::Storage::MirroredRing };
+
+      test.execute( Push { "cat" } );
+      test.execute( Push { "tac" } );
+      test.execute( PeekSpans { 8, { "cattac" } } );
+      test.execute( Pop { 4 } );
+      test.execute( PeekSpans { 8, { "ac" } } );
+      test.execute( Pop { 2 } );
+      test.execute( PeekSpans { 8, {} } );
+    }
+
+    for ( const auto storage : { ByteStream::Storage::Segmented, ByteStream::Storage::MirroredRing } ) {
+      ByteStreamTestHarness test { "pop_into copies across segments", 15, storage };
+
+      test.execute( PopInto { 4, "" } );
+      test.execute( Push { "cat" } );
+      test.execute( Push { "tac" } );
+      test.execute( Push { "dog" } );
+      test.execute( PopInto { 2, "ca" } );
+      test.execute( PopInto { 5, "ttacd" } );
+      test.execute( BytesPopped { 7 } );
+      test.execute( AvailableCapacity { 13 } );
+      test.execute( PeekOnce { "og" } );
+      test.execute( Push { "s" } );
+      test.execute( PopInto { 100, "ogs" } );
+      test.execute( BufferEmpty { true } );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
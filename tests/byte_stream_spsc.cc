@@ -0,0 +1,156 @@
+#include "epoll_eventloop.hh"
+#include "exception.hh"
+#include "spsc_byte_stream.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <poll.h>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+void expect_peek( const SpscReader& reader, string_view expected )
+{
+  if ( reader.peek() != expected ) {
+    throw runtime_error( "peek() should have returned \"" + string { expected } + "\", but returned \""
+                         + string { reader.peek() } + "\"" );
+  }
+}
+
+void test_basics()
+{
+  SpscByteStream stream { 15 };
+  SpscWriter& writer = stream.writer();
+  SpscReader& reader = stream.reader();
+
+  writer.push( "hello" );
+  test_should_be( writer.bytes_pushed(), uint64_t { 5 } );
+  test_should_be( uint64_t { reader.wakeup().clear() }, uint64_t { 1 } ); // empty -> non-empty wakes the Reader
+  writer.push( "world" );
+  test_should_be( writer.bytes_pushed(), uint64_t { 10 } );
+  test_should_be( uint64_t { reader.wakeup().clear() }, uint64_t { 0 } ); // already non-empty: no wakeup
+
+  expect_peek( reader, "helloworld" );
+  test_should_be( writer.available_capacity(), uint64_t { 5 } );
+  reader.pop( 10 );
+  test_should_be( reader.bytes_buffered(), uint64_t { 0 } );
+  test_should_be( reader.bytes_popped(), uint64_t { 10 } );
+
+  writer.push( "0123456789" );
+  test_should_be( writer.bytes_pushed(), uint64_t { 20 } );
+  test_should_be( uint64_t { reader.wakeup().clear() }, uint64_t { 1 } );
+  expect_peek( reader, "0123456789" ); // contiguous across the ring's end
+
+  writer.close();
+  test_should_be( uint64_t { reader.wakeup().clear() }, uint64_t { 1 } );
+  test_should_be( uint64_t { reader.is_finished() }, uint64_t { 0 } );
+  reader.pop( 10 );
+  test_should_be( uint64_t { reader.is_finished() }, uint64_t { 1 } );
+}
+
+void test_writer_wakeup()
+{
+  SpscByteStream stream { 4 };
+  SpscWriter& writer = stream.writer();
+  SpscReader& reader = stream.reader();
+
+  writer.push( "catdog" ); // truncated to capacity
+  test_should_be( writer.bytes_pushed(), uint64_t { 4 } );
+  test_should_be( writer.available_capacity(), uint64_t { 0 } );
+  test_should_be( uint64_t { writer.wakeup().clear() }, uint64_t { 0 } );
+
+  reader.pop( 1 ); // full -> not full wakes the Writer
+  test_should_be( uint64_t { writer.wakeup().clear() }, uint64_t { 1 } );
+  reader.pop( 1 );
+  test_should_be( uint64_t { writer.wakeup().clear() }, uint64_t { 0 } );
+
+  const span<char> region = writer.reserve( 10 );
+  test_should_be( uint64_t { region.size() }, uint64_t { 2 } );
+  region[0] = 'x';
+  writer.commit( 1 );
+  expect_peek( reader, "tdx" );
+}
+
+// Producer thread blocks in poll(2) on the Writer's wakeup; consumer drains
+// through an EpollEventLoop rule on the Reader's wakeup.
+void test_two_threads()
+{
+  const string data = [] {
+    default_random_engine rd { 144 };
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < 4'000'000; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  SpscByteStream stream { 65536 };
+
+  thread producer { [&] {
+    SpscWriter& writer = stream.writer();
+    string_view remaining = data;
+    while ( not remaining.empty() ) {
+      const uint64_t before = writer.bytes_pushed();
+      writer.push( remaining.substr( 0, 1500 ) );
+      const uint64_t accepted = writer.bytes_pushed() - before;
+      remaining.remove_prefix( accepted );
+      if ( accepted == 0 ) {
+        pollfd pfd { writer.wakeup().fd_num(), POLLIN, 0 };
+        CheckSystemCall( "poll", ::poll( &pfd, 1, -1 ) );
+        writer.wakeup().clear();
+      }
+    }
+    writer.close();
+  } };
+
+  string received;
+  received.reserve( data.size() );
+
+  EpollEventLoop loop;
+  SpscReader& reader = stream.reader();
+  loop.add_rule(
+    "drain SPSC stream",
+    reader.wakeup(),
+    EpollEventLoop::Direction::In,
+    [&] {
+      reader.wakeup().clear();
+      while ( not reader.peek().empty() ) {
+        const string_view view = reader.peek().substr( 0, 4096 );
+        received += view;
+        reader.pop( view.size() );
+      }
+    },
+    [&] { return not reader.is_finished(); } );
+
+  while ( loop.wait_next_event( 1000 ) != EpollEventLoop::Result::Exit ) {}
+  producer.join();
+
+  test_should_be( uint64_t { received.size() }, uint64_t { data.size() } );
+  if ( received != data ) {
+    throw runtime_error( "Mismatch between data written and read" );
+  }
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    test_basics();
+    test_writer_wakeup();
+    test_two_threads();
+  } catch ( const exception& e ) {
+    cerr << "Test failed: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -4,7 +4,12 @@
 #include "common.hh"
 #include "helpers.hh"
 
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <span>
 #include <utility>
+#include <vector>
 
 static_assert( sizeof( Reader ) == sizeof( ByteStream ),
                "Please add member variables to the ByteStream base, not the ByteStream Reader." );
@@ -15,8 +20,13 @@ static_assert( sizeof( Writer ) == sizeof( ByteStream ),
 class ByteStreamTestHarness : public TestHarness<ByteStream>
 {
 public:
-  ByteStreamTestHarness( std::string test_name, uint64_t capacity )
-    : TestHarness( move( test_name ), "capacity=" + std::to_string( capacity ), ByteStream { capacity } )
+  ByteStreamTestHarness( std::string test_name,
+                         uint64_t capacity,
+                         ByteStream::Storage storage = ByteStream::Storage::Segmented )
+    : TestHarness( move( test_name ),
+                   "capacity=" + std::to_string( capacity )
+                     + ( storage == ByteStream::Storage::MirroredRing ? " (mirrored ring)" : "" ),
+                   ByteStream { capacity, storage } )
   {}
 
   size_t peek_size() { return object().reader().peek().size(); }
@@ -34,6 +44,68 @@ struct Push : public Action<ByteStream>
   constexpr std::string obj() const override { return "Writer"; }
 };
 
+struct ReserveCommit : public Action<ByteStream>
+{
+  uint64_t reserve_len_;
+  std::string data_;
+
+  ReserveCommit( uint64_t reserve_len, std::string data ) : reserve_len_( reserve_len ), data_( move( data ) ) {}
+  std::string description() const override
+  {
+    return "reserve( " + std::to_string( reserve_len_ ) + " ), fill with \"" + pretty_print( data_ ) + "\", commit";
+  }
+  void execute( ByteStream& bs ) const override
+  {
+    const uint64_t expected_len = std::min( reserve_len_, bs.writer().available_capacity() );
+    const std::span<char> region = bs.writer().reserve( reserve_len_ );
+    if ( region.size() != expected_len ) {
+      throw ExpectationViolation { "reserve() should have returned " + std::to_string( expected_len )
+                                   + " bytes, but returned " + std::to_string( region.size() ) };
+    }
+    const size_t len = std::min( region.size(), data_.size() );
+    std::copy_n( data_.begin(), len, region.begin() );
+    bs.writer().commit( len );
+  }
+  constexpr std::string obj() const override { return "Writer"; }
+};
+
+struct PopInto : public Action<ByteStream>
+{
+  size_t buffer_len_;
+  std::string output_;
+
+  PopInto( size_t buffer_len, std::string output ) : buffer_len_( buffer_len ), output_( move( output ) ) {}
+  std::string description() const override
+  {
+    return "pop_into( " + std::to_string( buffer_len_ ) + "-byte buffer ) gives \"" + pretty_print( output_ )
+           + "\"";
+  }
+  void execute( ByteStream& bs ) const override
+  {
+    std::string buffer( buffer_len_, '\0' );
+    const uint64_t copied = bs.reader().pop_into( buffer );
+    buffer.resize( copied );
+    if ( buffer != output_ ) {
+      throw ExpectationViolation { "pop_into() should have copied \"" + pretty_print( output_ )
+                                   + "\", but copied \"" + pretty_print( buffer ) + "\"" };
+    }
+  }
+  constexpr std::string obj() const override { return "Reader"; }
+};
+
+struct PushShared : public Action<ByteStream>
+{
+  std::shared_ptr<const std::string> owner_;
+
+  explicit PushShared( std::shared_ptr<const std::string> owner ) : owner_( move( owner ) ) {}
+  std::string description() const override
+  {
+    return "push shared slice \"" + pretty_print( *owner_ ) + "\" to the stream";
+  }
+  void execute( ByteStream& bs ) const override { bs.writer().push( SharedSlice { owner_, *owner_ } ); }
+  constexpr std::string obj() const override { return "Writer"; }
+};
+
 struct Close : public Action<ByteStream>
 {
   std::string description() const override { return "close"; }
@@ -119,6 +191,64 @@ struct PeekOnce : public Peek
   }
 };
 
+struct PeekBorrows : public Expectation<ByteStream>
+{
+  std::shared_ptr<const std::string> owner_;
+  bool borrows_;
+
+  PeekBorrows( std::shared_ptr<const std::string> owner, bool borrows )
+    : owner_( move( owner ) ), borrows_( borrows )
+  {}
+  std::string description() const override
+  {
+    return std::string { "peek() " } + ( borrows_ ? "points into" : "does not point into" ) + " \""
+           + pretty_print( *owner_ ) + "\"";
+  }
+  void execute( const ByteStream& bs ) const override
+  {
+    const std::string_view peeked = bs.reader().peek();
+    const bool inside = not peeked.empty() and std::less_equal {}( owner_->data(), peeked.data() )
+                        and std::less {}( peeked.data(), owner_->data() + owner_->size() );
+    if ( inside != borrows_ ) {
+      throw ExpectationViolation { std::string { "peek() should " } + ( borrows_ ? "" : "not " )
+                                   + "have pointed into the pushed slice's memory" };
+    }
+  }
+};
+
+struct PeekSpans : public Expectation<ByteStream>
+{
+  size_t max_iov_;
+  std::vector<std::string> spans_;
+
+  PeekSpans( size_t max_iov, std::vector<std::string> spans ) : max_iov_( max_iov ), spans_( move( spans ) ) {}
+
+  static std::string describe( const auto& spans )
+  {
+    std::string ret = "{";
+    for ( const auto& span : spans ) {
+      ret += " \"" + pretty_print( span ) + "\"";
+    }
+    return ret + " }";
+  }
+
+  std::string description() const override
+  {
+    return "peek_spans( " + std::to_string( max_iov_ ) + " ) gives " + describe( spans_ );
+  }
+
+  void execute( const ByteStream& bs ) const override
+  {
+    const auto got = bs.reader().peek_spans( max_iov_ );
+    if ( not std::equal( got.begin(), got.end(), spans_.begin(), spans_.end() ) ) {
+      throw ExpectationViolation { "peek_spans() should have returned " + describe( spans_ )
+                                   + ", but instead returned " + describe( got ) };
+    }
+  }
+
+  constexpr std::string obj() const override { return "Reader"; }
+};
+
 struct IsClosed : public ExpectBool<ByteStream>
 {
   using ExpectBool::ExpectBool;
@@ -0,0 +1,282 @@
+#include "byte_stream.hh"
+#include "epoll_eventloop.hh"
+#include "exception.hh"
+#include "test_should_be.hh"
+
+#include <array>
+#include <cstdint>
+#include <exception>
+#include <fcntl.h>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+// Counts readiness edges as reported by the callbacks.
+struct EdgeLog
+{
+  uint64_t readable_on {};
+  uint64_t readable_off {};
+  uint64_t writable_on {};
+  uint64_t writable_off {};
+
+  void watch( ByteStream& stream )
+  {
+    stream.on_readable_change( [this]( bool ready ) { ++( ready ? readable_on : readable_off ); } );
+    stream.on_writable_change( [this]( bool ready ) { ++( ready ? writable_on : writable_off ); } );
+  }
+
+  void expect( uint64_t r_on, uint64_t r_off, uint64_t w_on, uint64_t w_off ) const
+  {
+    test_should_be( readable_on, r_on );
+    test_should_be( readable_off, r_off );
+    test_should_be( writable_on, w_on );
+    test_should_be( writable_off, w_off );
+  }
+};
+
+void test_default_watermarks()
+{
+  ByteStream stream { 4 };
+  EdgeLog log;
+  log.watch( stream );
+
+  test_should_be( uint64_t { stream.reader().is_readable() }, uint64_t { 0 } );
+  test_should_be( uint64_t { stream.writer().is_writable() }, uint64_t { 1 } );
+
+  stream.writer().push( "ab" );
+  log.expect( 1, 0, 0, 0 ); // empty -> non-empty
+  stream.writer().push( "c" );
+  log.expect( 1, 0, 0, 0 ); // no edge
+  stream.writer().push( "defg" );
+  log.expect( 1, 0, 0, 1 ); // full
+
+  stream.reader().pop( 1 );
+  log.expect( 1, 0, 1, 1 ); // no longer full
+  stream.reader().pop( 3 );
+  log.expect( 1, 1, 1, 1 ); // drained
+
+  stream.writer().close();
+  log.expect( 2, 1, 1, 2 ); // a closed stream is readable (to see EOF) and no longer writable
+  test_should_be( uint64_t { stream.reader().is_readable() }, uint64_t { 1 } );
+}
+
+void test_custom_watermarks()
+{
+  ByteStream stream { 8 };
+  stream.set_watermarks( 3, 5 );
+  EdgeLog log;
+  log.watch( stream );
+
+  stream.writer().push( "ab" );
+  log.expect( 0, 0, 0, 0 ); // below the low watermark
+  stream.writer().push( "c" );
+  log.expect( 1, 0, 0, 0 );
+  stream.writer().push( "de" );
+  log.expect( 1, 0, 0, 1 ); // reached the high watermark with capacity to spare
+  test_should_be( stream.writer().available_capacity(), uint64_t { 3 } );
+
+  stream.reader().pop( 1 );
+  log.expect( 1, 0, 1, 1 );
+  stream.reader().pop( 2 );
+  log.expect( 1, 1, 1, 1 );
+
+  stream.set_watermarks( 2, 5 );
+  log.expect( 2, 1, 1, 1 ); // moving a watermark can itself be an edge
+
+  stream.set_error();
+  log.expect( 2, 1, 1, 2 );
+}
+
+void test_invalid_watermarks()
+{
+  ByteStream stream { 8 };
+  for ( const auto& [low, high] : { pair<uint64_t, uint64_t> { 0, 4 }, { 5, 4 }, { 1, 9 } } ) {
+    bool threw = false;
+    try {
+      stream.set_watermarks( low, high );
+    } catch ( const invalid_argument& ) {
+      threw = true;
+    }
+    test_should_be( uint64_t { threw }, uint64_t { 1 } );
+  }
+  stream.set_watermarks( 8, 8 ); // the bounds themselves are fine
+}
+
+void test_copy_drops_callbacks()
+{
+  ByteStream stream { 4 };
+  EdgeLog log;
+  log.watch( stream );
+
+  ByteStream copy = stream;
+  copy.writer().push( "abcd" );
+  log.expect( 0, 0, 0, 0 );
+
+  stream.writer().push( "a" );
+  log.expect( 1, 0, 0, 0 );
+}
+
+// Copies a pipe through a small ByteStream with EpollEventLoop rules that are armed
+// and disarmed only by the stream's readiness edges.
+void test_armed_rules()
+{
+  const string data = [] {
+    default_random_engine rd { 8 };
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < 50'000; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  array<int, 2> in_fds {};
+  array<int, 2> out_fds {};
+  CheckSystemCall( "pipe2", pipe2( in_fds.data(), O_NONBLOCK | O_CLOEXEC ) );
+  CheckSystemCall( "pipe2", pipe2( out_fds.data(), O_NONBLOCK | O_CLOEXEC ) );
+  FileDescriptor in_read { in_fds[0] };
+  FileDescriptor out_read { out_fds[0] };
+  FileDescriptor out_write { out_fds[1] };
+  {
+    FileDescriptor in_write { in_fds[1] };
+    test_should_be( uint64_t { in_write.write( data ) }, uint64_t { data.size() } );
+  }
+
+  ByteStream stream { 1000 };
+  EpollEventLoop loop;
+
+  auto fill = loop.add_armed_rule(
+    "fill stream",
+    in_read,
+    EpollEventLoop::Direction::In,
+    [&] {
+      read_into( in_read, stream.writer() );
+      if ( in_read.eof() ) {
+        stream.writer().close();
+      }
+    },
+    stream.writer().is_writable(),
+    [&] { stream.writer().close(); } ); // a hung-up pipe cancels the rule before read() sees EOF
+
+  auto drain = loop.add_armed_rule(
+    "drain stream",
+    out_write,
+    EpollEventLoop::Direction::Out,
+    [&] {
+      drain_to( stream.reader(), out_write );
+      if ( stream.reader().is_finished() ) {
+        out_write.close();
+      }
+    },
+    stream.reader().is_readable() );
+
+  uint64_t edges = 0;
+  stream.on_writable_change( [&]( bool ready ) {
+    fill.set_armed( ready );
+    ++edges;
+  } );
+  stream.on_readable_change( [&]( bool ready ) {
+    drain.set_armed( ready );
+    ++edges;
+  } );
+
+  while ( loop.wait_next_event( 1000 ) != EpollEventLoop::Result::Exit ) {}
+
+  string received;
+  while ( not out_read.eof() ) {
+    string chunk;
+    out_read.read( chunk );
+    received += chunk;
+  }
+  test_should_be( uint64_t { received.size() }, uint64_t { data.size() } );
+  if ( received != data ) {
+    throw runtime_error( "Mismatch between data written and read" );
+  }
+  if ( edges < 2 * ( data.size() / 1000 ) ) {
+    throw runtime_error( "expected the stream to fill and drain repeatedly, saw only " + to_string( edges )
+                         + " readiness edges" );
+  }
+}
+
+// A plain In rule that is not interested when its pipe hangs up keeps going once the
+// stream has room again, rather than losing the bytes still in the pipe.
+void test_plain_rule_after_hangup()
+{
+  const string data( 50'000, 'x' );
+
+  array<int, 2> in_fds {};
+  array<int, 2> out_fds {};
+  CheckSystemCall( "pipe2", pipe2( in_fds.data(), O_NONBLOCK | O_CLOEXEC ) );
+  CheckSystemCall( "pipe2", pipe2( out_fds.data(), O_NONBLOCK | O_CLOEXEC ) );
+  FileDescriptor in_read { in_fds[0] };
+  FileDescriptor out_read { out_fds[0] };
+  FileDescriptor out_write { out_fds[1] };
+  {
+    FileDescriptor in_write { in_fds[1] };
+    test_should_be( uint64_t { in_write.write( data ) }, uint64_t { data.size() } );
+  }
+
+  ByteStream stream { 1000 };
+  EpollEventLoop loop;
+
+  loop.add_rule(
+    "fill stream",
+    in_read,
+    EpollEventLoop::Direction::In,
+    [&] {
+      read_into( in_read, stream.writer() );
+      if ( in_read.eof() ) {
+        stream.writer().close();
+      }
+    },
+    [&] { return stream.writer().available_capacity() > 0 and not stream.writer().is_closed(); },
+    [&] { stream.writer().close(); } );
+
+  loop.add_rule(
+    "drain stream",
+    out_write,
+    EpollEventLoop::Direction::Out,
+    [&] {
+      drain_to( stream.reader(), out_write );
+      if ( stream.reader().is_finished() ) {
+        out_write.close();
+      }
+    },
+    [&] { return stream.reader().bytes_buffered() > 0 or stream.writer().is_closed(); } );
+
+  while ( loop.wait_next_event( 1000 ) != EpollEventLoop::Result::Exit ) {}
+
+  string received;
+  while ( not out_read.eof() ) {
+    string chunk;
+    out_read.read( chunk );
+    received += chunk;
+  }
+  test_should_be( uint64_t { received.size() }, uint64_t { data.size() } );
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    test_default_watermarks();
+    test_custom_watermarks();
+    test_invalid_watermarks();
+    test_copy_drops_callbacks();
+    test_armed_rules();
+    test_plain_rule_after_hangup();
+  } catch ( const exception& e ) {
+    cerr << "Test failed: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
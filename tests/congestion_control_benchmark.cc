@@ -0,0 +1,228 @@
+#include "tcp_config.hh"
+#include "tcp_receiver.hh"
+#include "tcp_sender.hh"
+
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+// A one-way path: a drop-tail queue drained at `bytes_per_ms`, then `delay_ms` of propagation.
+// ACKs come back over a path with the same delay and no bottleneck.
+struct Link
+{
+  string name;
+  uint64_t bytes_per_ms;
+  uint64_t delay_ms;
+  uint64_t buffer_bytes;
+
+  uint64_t bdp() const { return bytes_per_ms * 2 * delay_ms; }
+};
+
+struct Result
+{
+  double goodput_mbps {};        // bytes read by the receiving application
+  double utilization {};         // goodput as a fraction of the bottleneck rate
+  double loss_percent {};        // segments dropped at the bottleneck, of those sent
+  double mean_queue_delay_ms {}; // time segments spent waiting at the bottleneck
+  uint64_t retransmissions {};
+};
+
+template<class Message>
+struct Delayed
+{
+  uint64_t due_ms;
+  Message msg;
+};
+
+char pattern( uint64_t index )
+{
+  return static_cast<char>( 'a' + index % 26 );
+}
+
+class Simulation
+{
+public:
+  Simulation( const Link& link, CongestionControlAlgorithm algorithm )
+    : link_( link )
+    , sender_( ByteStream { cfg_.send_capacity },
+               cfg_.isn,
+               cfg_.rt_timeout,
+               algorithm,
+               cfg_.adaptive_rto,
+               cfg_.pacing,
+               cfg_.mss,
+               cfg_.fast_retransmit )
+  {}
+
+  Result run( uint64_t duration_ms )
+  {
+    for ( now_ms_ = 0; now_ms_ < duration_ms; ++now_ms_ ) {
+      step();
+    }
+    const double seconds = static_cast<double>( duration_ms ) / 1000;
+    const double goodput = static_cast<double>( bytes_read_ ) / seconds;
+    return { .goodput_mbps = goodput * 8 / 1e6,
+             .utilization = goodput / ( static_cast<double>( link_.bytes_per_ms ) * 1000 ),
+             .loss_percent = 100.0 * static_cast<double>( drops_ ) / static_cast<double>( sent_ ),
+             .mean_queue_delay_ms = static_cast<double>( queue_delay_ms_ ) / static_cast<double>( forwarded_ ),
+             .retransmissions = retransmissions_ };
+  }
+
+private:
+  // Paced if the controller sets a rate.
+  TCPConfig cfg_ { .adaptive_rto = RtoLimits {}, .pacing = PacingConfig {}, .fast_retransmit = true };
+  Link link_;
+  TCPSender sender_;
+  TCPReceiver receiver_ { Reassembler { ByteStream { cfg_.recv_capacity } } };
+
+  uint64_t now_ms_ {};
+  deque<Delayed<TCPSenderMessage>> queue_ {}; // due_ms is the enqueue time
+  uint64_t queued_bytes_ {};
+  uint64_t credit_ {};
+  deque<Delayed<TCPSenderMessage>> forward_ {};
+  deque<Delayed<TCPReceiverMessage>> reverse_ {};
+
+  uint64_t bytes_written_ {};
+  uint64_t bytes_read_ {};
+  uint64_t highest_sent_ {};
+  uint64_t sent_ {};
+  uint64_t drops_ {};
+  uint64_t forwarded_ {};
+  uint64_t queue_delay_ms_ {};
+  uint64_t retransmissions_ {};
+
+  void step()
+  {
+    while ( not reverse_.empty() and reverse_.front().due_ms <= now_ms_ ) {
+      sender_.receive( reverse_.front().msg );
+      reverse_.pop_front();
+    }
+
+    // The sending application always has more to say.
+    Writer& writer = sender_.writer();
+    string data;
+    for ( uint64_t n = writer.available_capacity(); n > 0; --n ) {
+      data.push_back( pattern( bytes_written_++ ) );
+    }
+    writer.push( move( data ) );
+
+    const auto transmit = [this]( const TCPSenderMessage& msg ) { enqueue( msg ); };
+    sender_.push( transmit );
+    sender_.tick( 1, transmit );
+
+    serve_bottleneck();
+
+    while ( not forward_.empty() and forward_.front().due_ms <= now_ms_ ) {
+      receiver_.receive( move( forward_.front().msg ) );
+      forward_.pop_front();
+      reverse_.push_back( { now_ms_ + link_.delay_ms, receiver_.send() } );
+    }
+
+    Reader& reader = receiver_.reader();
+    while ( reader.bytes_buffered() > 0 ) {
+      const string_view chunk = reader.peek();
+      for ( const char c : chunk ) {
+        if ( c != pattern( bytes_read_++ ) ) {
+          throw runtime_error( "corrupted byte at index " + to_string( bytes_read_ - 1 ) );
+        }
+      }
+      reader.pop( chunk.size() );
+    }
+  }
+
+  void enqueue( const TCPSenderMessage& msg )
+  {
+    ++sent_;
+    const uint64_t end = msg.seqno.unwrap( cfg_.isn, highest_sent_ ) + msg.sequence_length();
+    if ( end <= highest_sent_ ) {
+      ++retransmissions_;
+    }
+    highest_sent_ = max( highest_sent_, end );
+
+    if ( queued_bytes_ + msg.sequence_length() > link_.buffer_bytes ) {
+      ++drops_;
+      return;
+    }
+    queued_bytes_ += msg.sequence_length();
+    queue_.push_back( { now_ms_, msg } );
+  }
+
+  void serve_bottleneck()
+  {
+    credit_ += link_.bytes_per_ms;
+    while ( not queue_.empty() and queue_.front().msg.sequence_length() <= credit_ ) {
+      credit_ -= queue_.front().msg.sequence_length();
+      queued_bytes_ -= queue_.front().msg.sequence_length();
+      queue_delay_ms_ += now_ms_ - queue_.front().due_ms;
+      ++forwarded_;
+      forward_.push_back( { now_ms_ + link_.delay_ms, move( queue_.front().msg ) } );
+      queue_.pop_front();
+    }
+    if ( queue_.empty() ) {
+      credit_ = 0; // an idle link doesn't bank capacity
+    }
+  }
+};
+
+void program_body()
+{
+  // The receiver's window tops out at 64 KiB (no window scaling), so each path's BDP plus
+  // buffer is kept just below it: the congestion controller, not flow control, has to find the limit.
+  const vector<Link> links {
+    { .name = "100 ms RTT, 4 Mbit/s, 10 kB buffer", .bytes_per_ms = 500, .delay_ms = 50, .buffer_bytes = 10'000 },
+    { .name = "200 ms RTT, 2 Mbit/s, 10 kB buffer", .bytes_per_ms = 250, .delay_ms = 100, .buffer_bytes = 10'000 },
+    { .name = "100 ms RTT, 1 Mbit/s, 50 kB buffer", .bytes_per_ms = 125, .delay_ms = 50, .buffer_bytes = 50'000 },
+  };
+  const vector<pair<string, CongestionControlAlgorithm>> algorithms {
+    { "none", CongestionControlAlgorithm::None },
+    { "newreno", CongestionControlAlgorithm::NewReno },
+    { "cubic", CongestionControlAlgorithm::Cubic },
+    { "bbr", CongestionControlAlgorithm::Bbr },
+  };
+  constexpr uint64_t duration_ms = 60'000;
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  for ( const auto& link : links ) {
+    cout << link.name << " (BDP " << link.bdp() << " bytes), " << duration_ms / 1000 << " s simulated:\n";
+    for ( const auto& [name, algorithm] : algorithms ) {
+      const Result r = Simulation { link, algorithm }.run( duration_ms );
+      if ( r.goodput_mbps <= 0 ) {
+        throw runtime_error( name + " made no progress over " + link.name );
+      }
+      cout << "  " << left << setw( 8 ) << name << right << fixed << setprecision( 3 ) << setw( 7 )
+           << r.goodput_mbps << " Mbit/s goodput (" << setprecision( 1 ) << setw( 5 ) << 100 * r.utilization
+           << "% of link), " << setprecision( 2 ) << setw( 5 ) << r.loss_percent << "% loss, " << setw( 6 )
+           << r.retransmissions << " retransmissions, " << setprecision( 1 ) << setw( 5 ) << r.mean_queue_delay_ms
+           << " ms mean queueing delay\n";
+      debug_output << "        " << link.name << ": " << name << " " << fixed << setprecision( 2 )
+                   << r.goodput_mbps << " Mbit/s, " << r.loss_percent << "% loss\n";
+    }
+  }
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
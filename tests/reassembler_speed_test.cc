@@ -1,107 +1,456 @@
 #include "reassembler.hh"
 
+#include <algorithm>
 #include <chrono>
 #include <cstddef>
 #include <fstream>
+#include <functional>
 #include <iomanip>
 #include <iostream>
-#include <queue>
 #include <random>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <sys/resource.h>
 #include <tuple>
+#include <vector>
 
 using namespace std;
 using namespace std::chrono;
 
-void speed_test( const size_t num_chunks,  // NOLINT(bugprone-easily-swappable-parameters)
-                 const size_t chunk_size,  // NOLINT(bugprone-easily-swappable-parameters)
-                 const size_t overlap,     // NOLINT(bugprone-easily-swappable-parameters)
-                 const size_t capacity,    // NOLINT(bugprone-easily-swappable-parameters)
-                 const size_t random_seed, // NOLINT(bugprone-easily-swappable-parameters)
-                 string_view scenario )
-{
-  // Generate the data to be written
-  const string data = [&] {
-    default_random_engine rd { random_seed };
-    uniform_int_distribution<char> ud;
-    string ret;
-    for ( size_t i = 0; i < num_chunks * chunk_size; ++i ) {
-      ret += ud( rd );
-    }
-    return ret;
-  }();
-
-  // Split the data into segments before writing
-  queue<tuple<uint64_t, string, bool>> split_data;
-  for ( size_t i = 0; i < data.size(); i += capacity ) {
-    size_t chunk_begin = min( i + capacity - 1, data.size() - 1 );
-    while ( true ) {
-      split_data.emplace(
-        chunk_begin, data.substr( chunk_begin, chunk_size ), chunk_begin + chunk_size >= data.size() );
-      if ( chunk_begin >= overlap ) {
-        chunk_begin -= overlap;
-      } else {
-        split_data.emplace( 0, data.substr( 0, chunk_size ), 0 + chunk_size >= data.size() );
-        break;
-      }
+namespace {
+
+struct Segment
+{
+  uint64_t first_index;
+  string data;
+  bool is_last;
+};
+using Segments = vector<Segment>;
+
+constexpr size_t default_capacity = 32768;
+
+string generate_data( size_t len, size_t random_seed )
+{
+  default_random_engine rd { random_seed };
+  uniform_int_distribution<char> ud;
+  string ret;
+  for ( size_t i = 0; i < len; ++i ) {
+    ret += ud( rd );
+  }
+  return ret;
+}
+
+string_view tracking_name( Reassembler::Tracking tracking )
+{
+  return tracking == Reassembler::Tracking::Bitmap ? "bitmap" : "slices";
+}
+
+Segment make_segment( const string& data, size_t begin, size_t end )
+{
+  return { begin, data.substr( begin, end - begin ), end == data.size() };
+}
+
+// Cut [begin, end) into consecutive pieces of `size` bytes (the last may be shorter).
+vector<pair<size_t, size_t>> cut( size_t begin, size_t end, size_t size )
+{
+  vector<pair<size_t, size_t>> ret;
+  for ( size_t i = begin; i < end; i += size ) {
+    ret.emplace_back( i, min( i + size, end ) );
+  }
+  return ret;
+}
+
+/* Resident set size, from /proc/self/status. On Linux the high-water mark can be reset between
+ * scenarios; elsewhere the peak reported is the peak for the whole process so far. */
+
+uint64_t status_kib( string_view field )
+{
+  ifstream status { "/proc/self/status" };
+  for ( string line; getline( status, line ); ) {
+    if ( line.starts_with( field ) ) {
+      return stoull( line.substr( field.size() ) );
     }
   }
+  if ( field == "VmHWM:" ) {
+    rusage usage {};
+    getrusage( RUSAGE_SELF, &usage );
+    return usage.ru_maxrss;
+  }
+  return 0;
+}
+
+// Reset the high-water mark and return the current RSS (KiB) as the baseline.
+uint64_t reset_peak_rss()
+{
+  {
+    ofstream clear_refs { "/proc/self/clear_refs" };
+    clear_refs << "5\n";
+  }
+  return status_kib( "VmRSS:" );
+}
+
+struct Result
+{
+  double gigabits_per_second;
+  double ns_per_insert;
+  uint64_t peak_pending;
+  uint64_t peak_rss_kib;
+  uint64_t rss_growth_kib; // peak during the run over the RSS just before it (mostly the output copy)
+  Reassembler::Stats stats;
+};
 
-  Reassembler reassembler { ByteStream { capacity } };
+// Insert every segment, draining the output as we go. Throughput is computed over `bytes_counted`.
+// A trace need not cover the whole stream, so `require_finished` may be false; either way, what
+// the reader saw must match the data.
+Result run_scenario( const string& data,
+                     Segments segments,
+                     const size_t capacity,      // NOLINT(bugprone-easily-swappable-parameters)
+                     const size_t bytes_counted, // NOLINT(bugprone-easily-swappable-parameters)
+                     const Reassembler::Tracking tracking,
+                     const bool require_finished = true )
+{
+  const uint64_t baseline_rss_kib = reset_peak_rss();
+  Reassembler reassembler { ByteStream { capacity }, tracking };
 
   string output_data;
   output_data.reserve( data.size() );
+  uint64_t peak_pending = 0;
 
   const auto start_time = steady_clock::now();
-  while ( not split_data.empty() ) {
-    auto& next = split_data.front();
-    reassembler.insert( get<uint64_t>( next ), move( get<string>( next ) ), get<bool>( next ) );
-    split_data.pop();
+  for ( auto& segment : segments ) {
+    reassembler.insert( segment.first_index, move( segment.data ), segment.is_last );
+    peak_pending = max( peak_pending, reassembler.count_bytes_pending() );
 
     while ( reassembler.reader().bytes_buffered() ) {
       output_data += reassembler.reader().peek();
       reassembler.reader().pop( output_data.size() - reassembler.reader().bytes_popped() );
     }
   }
-
   const auto stop_time = steady_clock::now();
 
-  if ( not reassembler.reader().is_finished() ) {
+  if ( require_finished and not reassembler.reader().is_finished() ) {
     throw runtime_error( "Reassembler did not close ByteStream when finished" );
   }
 
-  if ( data != output_data ) {
+  if ( string_view { data }.substr( 0, output_data.size() ) != output_data
+       or ( require_finished and output_data.size() != data.size() ) ) {
     throw runtime_error( "Mismatch between data written and read" );
   }
 
-  auto test_duration = duration_cast<duration<double>>( stop_time - start_time );
-  auto bytes_per_second = static_cast<double>( num_chunks * capacity ) / test_duration.count();
-  auto bits_per_second = 8 * bytes_per_second;
-  auto gigabits_per_second = bits_per_second / 1e9;
+  const auto test_duration = duration_cast<duration<double>>( stop_time - start_time );
+  const uint64_t peak_rss = status_kib( "VmHWM:" );
+  return { .gigabits_per_second = 8 * static_cast<double>( bytes_counted ) / test_duration.count() / 1e9,
+           .ns_per_insert = 1e9 * test_duration.count() / static_cast<double>( max<size_t>( segments.size(), 1 ) ),
+           .peak_pending = peak_pending,
+           .peak_rss_kib = peak_rss,
+           .rss_growth_kib = peak_rss - min( baseline_rss_kib, peak_rss ),
+           .stats = reassembler.stats() };
+}
+
+void report( fstream& debug_output,
+             const Result& result,
+             const size_t capacity,
+             const Reassembler::Tracking tracking,
+             string_view scenario )
+{
+  const uint64_t inserts = result.stats.fast_path_inserts + result.stats.slow_path_inserts;
+  cout << "Reassembler (" << tracking_name( tracking ) << ") to ByteStream with capacity=" << capacity << ", "
+       << scenario << ": " << fixed << setprecision( 2 ) << result.gigabits_per_second << " Gbit/s, "
+       << setprecision( 1 ) << result.ns_per_insert << " ns/insert, peak pending " << result.peak_pending
+       << " bytes, peak RSS " << result.peak_rss_kib << " KiB (+" << result.rss_growth_kib << " during the run), "
+       << result.stats.fast_path_inserts << " of " << inserts << " inserts on the fast path.\n";
+
+  debug_output << "        Reassembler " << setw( 7 ) << left << tracking_name( tracking ) << setw( 22 )
+               << scenario << right << fixed << setprecision( 2 ) << setw( 6 ) << result.gigabits_per_second
+               << " Gbit/s " << setprecision( 1 ) << setw( 8 ) << result.ns_per_insert << " ns/insert\n";
+}
+
+/* The scenarios. Each lays out every byte of `data` at least once, so the stream must finish. */
+
+// Each capacity-sized window arrives back to front, in chunks of chunk_size overlapping by
+// chunk_size - step. (Throughput is reported over num_chunks * capacity bytes, as it always has been.)
+Segments sliding_overlap( const string& data, size_t capacity, size_t chunk_size, size_t step )
+{
+  Segments ret;
+  for ( size_t i = 0; i < data.size(); i += capacity ) {
+    size_t chunk_begin = min( i + capacity - 1, data.size() - 1 );
+    while ( true ) {
+      ret.push_back( make_segment( data, chunk_begin, min( chunk_begin + chunk_size, data.size() ) ) );
+      if ( chunk_begin >= step ) {
+        chunk_begin -= step;
+      } else {
+        ret.push_back( make_segment( data, 0, min( chunk_size, data.size() ) ) );
+        break;
+      }
+    }
+  }
+  return ret;
+}
+
+// Every segment is the next expected one, as on a clean link.
+Segments in_order( const string& data, size_t chunk_size )
+{
+  Segments ret;
+  for ( const auto& [begin, end] : cut( 0, data.size(), chunk_size ) ) {
+    ret.push_back( make_segment( data, begin, end ) );
+  }
+  return ret;
+}
 
+// Every chunk arrives one byte short, leaving a 1-byte hole in front of it; the holes are then
+// filled in order, each one releasing the chunk behind it.
+Segments one_byte_holes( const string& data, size_t capacity, size_t chunk_size )
+{
+  Segments ret;
+  for ( size_t window = 0; window < data.size(); window += capacity ) {
+    const auto chunks = cut( window, min( window + capacity, data.size() ), chunk_size );
+    for ( const auto& [begin, end] : chunks ) {
+      ret.push_back( make_segment( data, begin + 1, end ) );
+    }
+    for ( const auto& [begin, end] : chunks ) {
+      ret.push_back( make_segment( data, begin, begin + 1 ) );
+    }
+  }
+  return ret;
+}
+
+// The chunks of each window arrive in a random order.
+Segments random_permutation( const string& data, size_t capacity, size_t chunk_size, default_random_engine& rd )
+{
+  Segments ret;
+  for ( size_t window = 0; window < data.size(); window += capacity ) {
+    auto chunks = cut( window, min( window + capacity, data.size() ), chunk_size );
+    shuffle( chunks.begin(), chunks.end(), rd );
+    for ( const auto& [begin, end] : chunks ) {
+      ret.push_back( make_segment( data, begin, end ) );
+    }
+  }
+  return ret;
+}
+
+// The chunks of each window arrive last to first.
+Segments reverse_order( const string& data, size_t capacity, size_t chunk_size )
+{
+  Segments ret;
+  for ( size_t window = 0; window < data.size(); window += capacity ) {
+    auto chunks = cut( window, min( window + capacity, data.size() ), chunk_size );
+    for ( auto it = chunks.rbegin(); it != chunks.rend(); ++it ) {
+      ret.push_back( make_segment( data, it->first, it->second ) );
+    }
+  }
+  return ret;
+}
+
+// Segments of 1 to 8 bytes, with each neighbouring pair swapped half the time.
+Segments tiny_segments( const string& data, default_random_engine& rd )
+{
+  uniform_int_distribution<size_t> size_dist { 1, 8 };
+  bernoulli_distribution swap_dist { 0.5 };
+  Segments ret;
+  for ( size_t begin = 0; begin < data.size(); ) {
+    const size_t end = min( begin + size_dist( rd ), data.size() );
+    ret.push_back( make_segment( data, begin, end ) );
+    if ( ret.size() % 2 == 0 and swap_dist( rd ) ) {
+      swap( ret[ret.size() - 2], ret.back() );
+    }
+    begin = end;
+  }
+  return ret;
+}
+
+// Chunks of each window in a random order, each followed by nine copies of chunks from the
+// same window that have already been sent: 90% of inserts are duplicates.
+Segments mostly_duplicates( const string& data, size_t capacity, size_t chunk_size, default_random_engine& rd )
+{
+  Segments ret;
+  for ( size_t window = 0; window < data.size(); window += capacity ) {
+    auto chunks = cut( window, min( window + capacity, data.size() ), chunk_size );
+    shuffle( chunks.begin(), chunks.end(), rd );
+    for ( size_t i = 0; i < chunks.size(); ++i ) {
+      ret.push_back( make_segment( data, chunks[i].first, chunks[i].second ) );
+      uniform_int_distribution<size_t> sent { 0, i };
+      for ( size_t dup = 0; dup < 9; ++dup ) {
+        const auto& [begin, end] = chunks[sent( rd )];
+        ret.push_back( make_segment( data, begin, end ) );
+      }
+    }
+  }
+  return ret;
+}
+
+// Each window arrives with small holes (1-32 bytes) punched at random offsets, and the
+// holes are then filled in a random order.
+Segments many_small_holes( const string& data, size_t capacity, default_random_engine& rd )
+{
+  uniform_int_distribution<size_t> run_dist { 16, 256 };
+  uniform_int_distribution<size_t> hole_dist { 1, 32 };
+  Segments ret;
+  for ( size_t window = 0; window < data.size(); window += capacity ) {
+    const size_t window_end = min( window + capacity, data.size() );
+    vector<pair<size_t, size_t>> holes;
+    for ( size_t begin = window; begin < window_end; ) {
+      const size_t hole_end = min( begin + hole_dist( rd ), window_end );
+      holes.emplace_back( begin, hole_end );
+      const size_t run_end = min( hole_end + run_dist( rd ), window_end );
+      if ( hole_end < run_end ) {
+        ret.push_back( make_segment( data, hole_end, run_end ) );
+      }
+      begin = run_end;
+    }
+    shuffle( holes.begin(), holes.end(), rd );
+    for ( const auto& [begin, end] : holes ) {
+      ret.push_back( make_segment( data, begin, end ) );
+    }
+  }
+  return ret;
+}
+
+/* Traces. Each line of a trace file is "<first_index> <length>", optionally followed by "last";
+ * blank lines and lines starting with '#' are ignored. The payload bytes are synthesized. */
+
+struct Trace
+{
+  string data;
+  Segments segments;
+  bool complete; // do the segments cover every byte, including a last one?
+};
+
+Trace load_trace( const string& path )
+{
+  ifstream file { path };
+  if ( not file ) {
+    throw runtime_error( "could not open trace " + path );
+  }
+
+  vector<tuple<uint64_t, uint64_t, bool>> records;
+  uint64_t stream_end = 0;
+  bool has_last = false;
+  for ( string line; getline( file, line ); ) {
+    if ( line.empty() or line.front() == '#' ) {
+      continue;
+    }
+    istringstream fields { line };
+    uint64_t first_index {};
+    uint64_t length {};
+    string flag;
+    if ( not( fields >> first_index >> length ) ) {
+      throw runtime_error( "malformed trace line in " + path + ": " + line );
+    }
+    fields >> flag;
+    records.emplace_back( first_index, length, flag == "last" );
+    stream_end = max( stream_end, first_index + length );
+    has_last |= flag == "last";
+  }
+
+  Trace trace { generate_data( stream_end, 2018 ), {}, false };
+  vector<bool> covered( stream_end );
+  for ( const auto& [first_index, length, is_last] : records ) {
+    trace.segments.push_back( { first_index, trace.data.substr( first_index, length ), is_last } );
+    fill_n( covered.begin() + static_cast<ptrdiff_t>( first_index ), length, true );
+  }
+  trace.complete = has_last and ranges::all_of( covered, []( bool b ) { return b; } );
+  return trace;
+}
+
+struct Scenario
+{
+  string_view name;
+  size_t data_size;
+  function<Segments( const string&, default_random_engine& )> build;
+  size_t bytes_counted {}; // defaults to data_size
+};
+
+void program_body( span<char*> trace_paths )
+{
   fstream debug_output;
   debug_output.open( "/dev/tty" );
 
-  cout << "Reassembler to ByteStream with capacity=" << capacity << " reached " << fixed << setprecision( 2 )
-       << gigabits_per_second << " Gbit/s.\n";
+  const size_t capacity = default_capacity;
+  const vector<Scenario> scenarios {
+    { "no overlap",
+      1500 * 1000,
+      [&]( const string& d, auto& ) { return sliding_overlap( d, capacity, 1500, 1500 ); },
+      1000 * capacity },
+    { "10x overlap",
+      1500 * 1000,
+      [&]( const string& d, auto& ) { return sliding_overlap( d, capacity, 1500, 150 ); },
+      1000 * capacity },
+    { "in-order MSS", 1460 * 20000, []( const string& d, auto& ) { return in_order( d, 1460 ); } },
+    { "1-byte holes", 1460 * 20000, [&]( const string& d, auto& ) { return one_byte_holes( d, capacity, 1460 ); } },
+    { "random permutation",
+      1460 * 20000,
+      [&]( const string& d, auto& rd ) { return random_permutation( d, capacity, 1460, rd ); } },
+    { "reverse order", 1460 * 20000, [&]( const string& d, auto& ) { return reverse_order( d, capacity, 1460 ); } },
+    { "tiny segments", 1 << 21, []( const string& d, auto& rd ) { return tiny_segments( d, rd ); } },
+    { "90% duplicates",
+      1460 * 5000,
+      [&]( const string& d, auto& rd ) { return mostly_duplicates( d, capacity, 1460, rd ); } },
+    { "many small holes",
+      1 << 23,
+      [&]( const string& d, auto& rd ) { return many_small_holes( d, capacity, rd ); } },
+  };
 
-  debug_output << "        Reassembler throughput " << scenario << fixed << setprecision( 2 ) << setw( 5 )
-               << gigabits_per_second << " Gbit/s\n";
+  size_t seed = 1370;
+  for ( const auto& scenario : scenarios ) {
+    const string data = generate_data( scenario.data_size, seed++ );
+    for ( const auto tracking : { Reassembler::Tracking::Slices, Reassembler::Tracking::Bitmap } ) {
+      default_random_engine rd { seed };
+      Segments segments = scenario.build( data, rd );
+      const Result result = run_scenario( data,
+                                          move( segments ),
+                                          capacity,
+                                          scenario.bytes_counted ? scenario.bytes_counted : data.size(),
+                                          tracking );
+      report( debug_output, result, capacity, tracking, scenario.name );
+
+      if ( result.gigabits_per_second < 0.1 ) {
+        throw runtime_error( "Reassembler did not meet minimum speed of 0.1 Gbit/s." );
+      }
+
+      if ( scenario.name == "in-order MSS" and result.stats.slow_path_inserts != 0 ) {
+        throw runtime_error( "In-order inserts should all have taken the fast path." );
+      }
+    }
+  }
 
-  if ( gigabits_per_second < 0.1 ) {
-    throw runtime_error( "Reassembler did not meet minimum speed of 0.1 Gbit/s." );
+  for ( const string path : trace_paths ) { // NOLINT(performance-for-range-copy)
+    for ( const auto tracking : { Reassembler::Tracking::Slices, Reassembler::Tracking::Bitmap } ) {
+      Trace trace = load_trace( path );
+      const Result result
+        = run_scenario( trace.data, move( trace.segments ), capacity, trace.data.size(), tracking, trace.complete );
+      report( debug_output, result, capacity, tracking, "trace " + path );
+    }
   }
 }
 
-void program_body()
+void show_usage( const char* argv0 )
 {
-  speed_test( 1000, 1500, 1500, 32768, 1370, "(no overlap):  " );
-  speed_test( 1000, 1500, 150, 32768, 6163, "(10x overlap): " );
+  cerr << "Usage: " << argv0 << " [--trace FILE]...\n\n"
+       << "Runs the built-in reassembly scenarios, then replays each trace FILE. A trace has one\n"
+       << "segment per line, \"<first_index> <length> [last]\"; lines starting with '#' are ignored.\n";
 }
 
-int main()
+} // namespace
+
+int main( int argc, char* argv[] )
 {
   try {
-    program_body();
+    if ( argc <= 0 ) {
+      abort();
+    }
+    const auto args = span( argv, argc );
+    vector<char*> trace_paths;
+    for ( size_t i = 1; i < args.size(); ++i ) {
+      if ( args[i] == "--trace"s and i + 1 < args.size() ) {
+        trace_paths.push_back( args[++i] );
+      } else {
+        show_usage( args[0] );
+        return EXIT_FAILURE;
+      }
+    }
+    program_body( trace_paths );
   } catch ( const exception& e ) {
     cerr << "Exception: " << e.what() << "\n";
     return EXIT_FAILURE;
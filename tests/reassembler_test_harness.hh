@@ -4,7 +4,9 @@
 #include "helpers.hh"
 #include "reassembler.hh"
 
+#include <cstdlib>
 #include <sstream>
+#include <string_view>
 #include <utility>
 
 template<std::derived_from<TestStep<ByteStream>> T>
@@ -22,13 +24,29 @@ struct ReassemblerTestStep : public TestStep<Reassembler>
   constexpr std::string obj() const override { return step_.obj(); }
 };
 
+// REASSEMBLER_TRACKING=slices runs the same tests against Reassembler::Tracking::Slices. Outside the tests,
+// TCPConfig::reassembler_tracking selects the mode.
+inline Reassembler::Tracking reassembler_tracking()
+{
+  const char* env = getenv( "REASSEMBLER_TRACKING" );
+  return env and std::string_view { env } == "slices" ? Reassembler::Tracking::Slices
+                                                      : Reassembler::Tracking::Bitmap;
+}
+
+inline std::string tracking_description( Reassembler::Tracking tracking )
+{
+  return tracking == Reassembler::Tracking::Slices ? " (slices)" : "";
+}
+
 class ReassemblerTestHarness : public TestHarness<Reassembler>
 {
 public:
-  ReassemblerTestHarness( std::string test_name, uint64_t capacity )
+  ReassemblerTestHarness( std::string test_name,
+                          uint64_t capacity,
+                          Reassembler::Tracking tracking = reassembler_tracking() )
     : TestHarness( move( test_name ),
-                   "capacity=" + std::to_string( capacity ),
-                   { Reassembler { ByteStream { capacity } } } )
+                   "capacity=" + std::to_string( capacity ) + tracking_description( tracking ),
+                   { Reassembler { ByteStream { capacity }, tracking } } )
   {}
 
   template<std::derived_from<TestStep<ByteStream>> T>
@@ -1,12 +1,14 @@
 #pragma once
 
 #include "common.hh"
+#include "reassembler_test_harness.hh"
 #include "tcp_receiver.hh"
 #include "tcp_receiver_message.hh"
 
 #include <optional>
 #include <sstream>
 #include <utility>
+#include <vector>
 
 template<std::derived_from<TestStep<Reassembler>> T>
 struct DirectReassemblerTest : public TestStep<TCPReceiver>
@@ -39,8 +41,8 @@ class TCPReceiverTestHarness : public TestHarness<TCPReceiver>
 public:
   TCPReceiverTestHarness( std::string test_name, uint64_t capacity )
     : TestHarness( move( test_name ),
-                   "capacity=" + std::to_string( capacity ),
-                   { TCPReceiver { Reassembler { ByteStream { capacity } } } } )
+                   "capacity=" + std::to_string( capacity ) + tracking_description( reassembler_tracking() ),
+                   { TCPReceiver { Reassembler { ByteStream { capacity }, reassembler_tracking() } } } )
   {}
 
   template<std::derived_from<TestStep<Reassembler>> T>
@@ -108,6 +110,36 @@ struct ExpectAcknoBetween : public Expectation<TCPReceiver>
   }
 };
 
+struct ExpectSack : public Expectation<TCPReceiver>
+{
+  std::vector<std::pair<Wrap32, Wrap32>> blocks_;
+  explicit ExpectSack( std::vector<std::pair<Wrap32, Wrap32>> blocks ) : blocks_( std::move( blocks ) ) {}
+
+  static std::string blocks_to_string( const std::vector<std::pair<Wrap32, Wrap32>>& blocks )
+  {
+    std::string ret = "[";
+    for ( const auto& [left, right] : blocks ) {
+      ret += ( ret.size() > 1 ? ", " : "" ) + to_string( left ) + "-" + to_string( right );
+    }
+    return ret + "]";
+  }
+
+  std::string description() const override { return "SACK blocks = " + blocks_to_string( blocks_ ); }
+
+  void execute( const TCPReceiver& rs ) const override
+  {
+    const TCPReceiverMessage msg = rs.send();
+    std::vector<std::pair<Wrap32, Wrap32>> actual;
+    for ( const SackBlock& block : msg.sack() ) {
+      actual.emplace_back( block.left, block.right );
+    }
+    if ( actual != blocks_ ) {
+      throw ExpectationViolation( "should have had SACK blocks = " + blocks_to_string( blocks_ )
+                                  + ", but instead they were " + blocks_to_string( actual ) );
+    }
+  }
+};
+
 struct HasAckno : public ExpectBool<TCPReceiver>
 {
   using ExpectBool::ExpectBool;
@@ -0,0 +1,149 @@
+#include "byte_stream_test_harness.hh"
+#include "helpers.hh"
+#include "random.hh"
+#include "reassembler_test_harness.hh"
+#include "receiver_test_harness.hh"
+#include "tcp_over_ip.hh"
+#include "tcp_segment.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+// A segment carrying SACK blocks should survive serialize() and parse() intact.
+void test_sack_option_roundtrip()
+{
+  TCPSegment seg;
+  seg.udinfo = { .src_port = 1234, .dst_port = 5678, .cksum = 0 };
+  seg.message.sender->seqno = Wrap32 { 100 };
+  seg.message.sender->payload = "hello";
+  seg.message.receiver->ackno = Wrap32 { 4000 };
+  seg.message.receiver->window_size = 1000;
+  seg.message.receiver->sack_blocks = { { { Wrap32 { 5000 }, Wrap32 { 6000 } },
+                                          { Wrap32 { 4100 }, Wrap32 { 4200 } },
+                                          { Wrap32 { 4300 }, Wrap32 { 4400 } },
+                                          { Wrap32 { 4500 }, Wrap32 { 4600 } } } };
+  seg.message.receiver->sack_block_count = 4;
+  seg.compute_checksum( 0 );
+
+  Serializer serializer;
+  seg.serialize( serializer );
+  auto wire = serializer.finish();
+  uint64_t length = 0;
+  for ( const auto& buf : wire ) {
+    length += buf->size();
+  }
+  if ( length != TCPSegment::HEADER_LENGTH + 36 + 5 ) {
+    throw runtime_error( "unexpected serialized length " + to_string( length ) );
+  }
+
+  TCPSegment parsed;
+  Parser parser { std::move( wire ) };
+  parsed.parse( parser, 0 );
+  if ( parser.has_error() ) {
+    throw runtime_error( "could not parse a segment with a SACK option" );
+  }
+  if ( parsed.message.sender->payload != "hello" or parsed.message.receiver->ackno != Wrap32 { 4000 }
+       or parsed.message.receiver->window_size != 1000 ) {
+    throw runtime_error( "SACK option disturbed the rest of the segment: " + parsed.to_string() );
+  }
+  const auto sent = seg.message.receiver->sack();
+  const auto received = parsed.message.receiver->sack();
+  if ( not equal( sent.begin(), sent.end(), received.begin(), received.end(), []( auto a, auto b ) {
+         return a.left == b.left and a.right == b.right;
+       } ) ) {
+    throw runtime_error( "SACK blocks did not survive the round trip: " + parsed.to_string() );
+  }
+}
+
+// The IPv4 length, and so the TCP checksum's pseudo-header, should count the option bytes.
+void test_sack_option_in_ip()
+{
+  TCPMessage msg;
+  msg.sender->seqno = Wrap32 { 100 };
+  msg.sender->payload = "hello";
+  msg.receiver->ackno = Wrap32 { 4000 };
+  msg.receiver->sack_blocks = { { { Wrap32 { 5000 }, Wrap32 { 6000 } } } };
+  msg.receiver->sack_block_count = 1;
+
+  TCPOverIPv4Adapter adapter;
+  const InternetDatagram dgram = adapter.wrap_tcp_in_ip( msg );
+  if ( dgram.header.len != IPv4Header::LENGTH + TCPSegment::HEADER_LENGTH + 12 + 5 ) {
+    throw runtime_error( "unexpected IPv4 length " + to_string( dgram.header.len ) );
+  }
+  if ( not adapter.unwrap_tcp_in_ip( clone( dgram ) ) ) {
+    throw runtime_error( "a segment with a SACK option failed its checksum" );
+  }
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "holes reported, then filled", 2358 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectSack { {} } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( ExpectSack { { { Wrap32 { isn + 5 }, Wrap32 { isn + 9 } } } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 13 ).with_data( "mn" ) );
+      test.execute( ExpectSack { { { Wrap32 { isn + 13 }, Wrap32 { isn + 15 } },
+                                   { Wrap32 { isn + 5 }, Wrap32 { isn + 9 } } } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 9 ).with_data( "ijkl" ) );
+      test.execute( ExpectSack { { { Wrap32 { isn + 5 }, Wrap32 { isn + 15 } } } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 15 } } );
+      test.execute( ExpectSack { {} } );
+      test.execute( ReadAll { "abcdefghijklmn" } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "most recent block first, then the lowest", 2358 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      for ( const uint32_t offset : { 50, 10, 60, 20, 40 } ) {
+        test.execute( SegmentArrives {}.with_seqno( isn + offset ).with_data( "xyz" ) );
+      }
+      test.execute( SegmentArrives {}.with_seqno( isn + 30 ).with_data( "xyz" ) );
+      test.execute( ExpectSack { { { Wrap32 { isn + 30 }, Wrap32 { isn + 33 } },
+                                   { Wrap32 { isn + 10 }, Wrap32 { isn + 13 } },
+                                   { Wrap32 { isn + 20 }, Wrap32 { isn + 23 } },
+                                   { Wrap32 { isn + 40 }, Wrap32 { isn + 43 } } } } );
+
+      // A duplicate still identifies the block it landed in.
+      test.execute( SegmentArrives {}.with_seqno( isn + 61 ).with_data( "y" ) );
+      test.execute( ExpectSack { { { Wrap32 { isn + 60 }, Wrap32 { isn + 63 } },
+                                   { Wrap32 { isn + 10 }, Wrap32 { isn + 13 } },
+                                   { Wrap32 { isn + 20 }, Wrap32 { isn + 23 } },
+                                   { Wrap32 { isn + 30 }, Wrap32 { isn + 33 } } } } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "adjacent segments form one block", 2358 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 8 ).with_data( "cd" ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 4 ).with_data( "ab" ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 6 ).with_data( "xx" ) );
+      test.execute( ExpectSack { { { Wrap32 { isn + 4 }, Wrap32 { isn + 10 } } } } );
+    }
+
+    test_sack_option_roundtrip();
+    test_sack_option_in_ip();
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
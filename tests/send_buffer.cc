@@ -0,0 +1,166 @@
+#include "random.hh"
+#include "send_buffer.hh"
+#include "sender_test_harness.hh"
+#include "tcp_segment.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+uint64_t holds( const SharedSlice& slice, string_view expected )
+{
+  return uint64_t { slice.bytes == expected };
+}
+
+void test_send_buffer_directly()
+{
+  ByteStream stream { 100 };
+  stream.writer().push( "abcdefghij" );
+  SendBuffer buffer { 8 };
+
+  SharedSlice a = buffer.append( stream.reader(), 3 );
+  SharedSlice b = buffer.append( stream.reader(), 4 );
+  SharedSlice c = buffer.append( stream.reader(), 4 ); // only three left, and they don't fit after "defg"
+  test_should_be( holds( a, "abc" ), uint64_t { 1 } );
+  test_should_be( holds( b, "defg" ), uint64_t { 1 } );
+  test_should_be( holds( c, "hij" ), uint64_t { 1 } );
+  test_should_be( uint64_t { a.owner == b.owner and b.owner != c.owner }, uint64_t { 1 } );
+  test_should_be( buffer.blocks_allocated(), uint64_t { 2 } );
+  test_should_be( stream.reader().bytes_buffered(), uint64_t { 0 } );
+
+  // A block is released only once every byte in it is acknowledged...
+  buffer.release( 6 );
+  test_should_be( uint64_t { buffer.blocks_held() }, uint64_t { 2 } );
+  buffer.release( 7 );
+  test_should_be( uint64_t { buffer.blocks_held() }, uint64_t { 1 } );
+
+  // ...and it isn't reused while a slice of it is still around.
+  stream.writer().push( "klmnopqr" );
+  SharedSlice d = buffer.append( stream.reader(), 8 );
+  test_should_be( holds( d, "klmnopqr" ), uint64_t { 1 } );
+  test_should_be( holds( a, "abc" ), uint64_t { 1 } );
+  test_should_be( buffer.blocks_allocated(), uint64_t { 3 } );
+
+  // Blocks nobody refers to any more are reused instead.
+  c = {};
+  d = {};
+  buffer.release( 18 );
+  test_should_be( uint64_t { buffer.blocks_held() }, uint64_t { 0 } );
+  stream.writer().push( "stuvwxyz" );
+  const SharedSlice e = buffer.append( stream.reader(), 5 );
+  const SharedSlice f = buffer.append( stream.reader(), 5 );
+  test_should_be( holds( e, "stuvw" ), uint64_t { 1 } );
+  test_should_be( holds( f, "xyz" ), uint64_t { 1 } );
+  test_should_be( buffer.blocks_allocated(), uint64_t { 3 } );
+}
+
+// Bytes the stream borrows (e.g. from a mapped file) go out as slices of their owner, not block copies.
+void test_send_buffer_lends_borrowed()
+{
+  const auto file = make_shared<const string>( "0123456789" );
+  ByteStream stream { 100 };
+  stream.writer().push( "ab" );
+  stream.writer().push( SharedSlice { file, *file } );
+  SendBuffer buffer { 8 };
+
+  const SharedSlice a = buffer.append( stream.reader(), 2 );
+  const SharedSlice b = buffer.append( stream.reader(), 6 );
+  const SharedSlice c = buffer.append( stream.reader(), 20 );
+  test_should_be( holds( a, "ab" ), uint64_t { 1 } );
+  test_should_be( holds( b, "012345" ), uint64_t { 1 } );
+  test_should_be( holds( c, "6789" ), uint64_t { 1 } );
+  test_should_be( uint64_t { b.owner == file and b.bytes.data() == file->data() }, uint64_t { 1 } );
+  test_should_be( uint64_t { c.owner == file and c.bytes.data() == file->data() + 6 }, uint64_t { 1 } );
+  test_should_be( buffer.blocks_allocated(), uint64_t { 1 } );
+
+  // The block still ends at the right stream offset after the borrowed bytes went past it.
+  stream.writer().push( "xyz" );
+  const SharedSlice d = buffer.append( stream.reader(), 3 );
+  test_should_be( uint64_t { d.owner == a.owner }, uint64_t { 1 } );
+  buffer.release( 14 );
+  test_should_be( uint64_t { buffer.blocks_held() }, uint64_t { 1 } );
+  buffer.release( 15 );
+  test_should_be( uint64_t { buffer.blocks_held() }, uint64_t { 0 } );
+}
+
+// Segments carry slices of the send buffer, and a retransmission resends the same bytes in place.
+void test_sender_shares_payloads( Wrap32 isn )
+{
+  TCPSender sender { ByteStream { 4 * MSS }, isn, TCPConfig::TIMEOUT_DFLT, CongestionControlAlgorithm::None };
+  vector<TCPSenderMessage> sent;
+  const auto transmit = [&sent]( const TCPSenderMessage& msg ) { sent.push_back( msg ); };
+
+  sender.push( transmit );
+  sender.receive( { .ackno = isn + 1, .window_size = BIG_WINDOW } );
+  sender.writer().push( string( 2 * MSS, 'x' ) );
+  sender.push( transmit );
+  sender.tick( TCPConfig::TIMEOUT_DFLT, transmit );
+  test_should_be( uint64_t { sent.size() }, uint64_t { 4 } );
+  test_should_be( uint64_t { sent.at( 1 ).payload.is_shared() }, uint64_t { 1 } );
+  test_should_be( uint64_t { sent.at( 3 ).seqno == sent.at( 1 ).seqno }, uint64_t { 1 } );
+  test_should_be( uint64_t { sent.at( 3 ).payload.view().data() == sent.at( 1 ).payload.view().data() },
+                  uint64_t { 1 } );
+  test_should_be( uint64_t { sender.send_buffer().blocks_held() }, uint64_t { 1 } );
+
+  sender.receive( { .ackno = isn + 1 + 2 * MSS, .window_size = BIG_WINDOW } );
+  test_should_be( uint64_t { sender.send_buffer().blocks_held() }, uint64_t { 0 } );
+}
+
+// Serializing a segment with a shared payload points at the payload instead of copying it.
+void test_serialize_shares_payload()
+{
+  ByteStream stream { 100 };
+  stream.writer().push( "hello, world" );
+  SendBuffer buffer;
+  TCPSegment seg;
+  seg.message.sender->payload = buffer.append( stream.reader(), 12 );
+  seg.compute_checksum( 0 );
+
+  Serializer serializer;
+  seg.serialize( serializer );
+  const vector<string_view> views = serializer.views();
+  test_should_be( uint64_t { views.size() }, uint64_t { 2 } );
+  test_should_be( uint64_t { views.back().data() == seg.message.sender->payload.view().data() }, uint64_t { 1 } );
+
+  auto wire = serializer.finish();
+  TCPSegment parsed;
+  Parser parser { std::move( wire ) };
+  parsed.parse( parser, 0 );
+  test_should_be( uint64_t { parser.has_error() }, uint64_t { 0 } );
+  test_should_be( uint64_t { parsed.message.sender->payload == "hello, world" }, uint64_t { 1 } );
+
+  // An owned payload is borrowed the same way, rather than copied into the Serializer.
+  seg.message.sender->payload = string { "goodbye, world" };
+  Serializer owned;
+  seg.serialize( owned );
+  test_should_be( uint64_t { owned.views().back().data() == seg.message.sender->payload.view().data() },
+                  uint64_t { 1 } );
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    test_send_buffer_directly();
+    test_send_buffer_lends_borrowed();
+    test_sender_shares_payloads( Wrap32( rd() ) );
+    test_serialize_shares_payload();
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,396 @@
+#include "bbr.hh"
+#include "congestion_control.hh"
+#include "cubic.hh"
+#include "random.hh"
+#include "sender_test_harness.hh"
+#include "test_should_be.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+void expect_full_segments( TCPSenderTestHarness& test, size_t count )
+{
+  for ( size_t i = 0; i < count; ++i ) {
+    test.execute( ExpectMessage {}.with_no_flags().with_payload_size( MSS ) );
+  }
+}
+
+void test_newreno_directly()
+{
+  NewReno cc { MSS };
+  test_should_be( cc.cwnd(), 10 * MSS );
+  test_should_be( uint64_t { cc.in_slow_start() }, uint64_t { 1 } );
+
+  cc.on_rto( 0, 12 * MSS );
+  test_should_be( cc.cwnd(), MSS );
+  test_should_be( cc.ssthresh(), 6 * MSS );
+  cc.on_rto( 0, 12 * MSS ); // backing off again leaves ssthresh alone
+  test_should_be( cc.ssthresh(), 6 * MSS );
+
+  // Slow start: one MSS per ACK, however much it covers.
+  for ( int i = 0; i < 5; ++i ) {
+    cc.on_ack( { .now_ms = 0, .bytes_acked = 2 * MSS, .bytes_in_flight = 0 } );
+  }
+  test_should_be( cc.cwnd(), 6 * MSS );
+  test_should_be( uint64_t { cc.in_slow_start() }, uint64_t { 0 } );
+
+  // Congestion avoidance: one MSS per cwnd of acknowledged bytes.
+  for ( int i = 0; i < 5; ++i ) {
+    cc.on_ack( { .now_ms = 0, .bytes_acked = MSS, .bytes_in_flight = 0 } );
+  }
+  test_should_be( cc.cwnd(), 6 * MSS );
+  cc.on_ack( { .now_ms = 0, .bytes_acked = MSS, .bytes_in_flight = 0 } );
+  test_should_be( cc.cwnd(), 7 * MSS );
+
+  // Multiplicative decrease, never below two segments.
+  cc.on_loss( 0, 7 * MSS );
+  test_should_be( cc.cwnd(), 7 * MSS / 2 );
+  cc.on_loss( 0, MSS );
+  test_should_be( cc.cwnd(), 2 * MSS );
+}
+
+// Acknowledge a window's worth of one-MSS segments per round trip for `rounds` round trips. The
+// sender keeps about a window outstanding, so each HyStart++ round is one of these round trips.
+void run_rounds( Cubic& cc, uint64_t& now_ms, uint64_t& ackno, uint64_t rtt_ms, size_t rounds )
+{
+  for ( size_t round = 0; round < rounds; ++round ) {
+    const uint64_t window = cc.cwnd();
+    for ( uint64_t acked = 0; acked + MSS <= window; acked += MSS ) {
+      ackno += MSS;
+      cc.on_ack(
+        { .now_ms = now_ms, .ackno = ackno, .bytes_acked = MSS, .bytes_in_flight = window, .rtt_ms = rtt_ms } );
+    }
+    now_ms += rtt_ms;
+  }
+}
+
+void test_cubic_directly()
+{
+  uint64_t now_ms = 0;
+  uint64_t ackno = 0;
+
+  Cubic cc { MSS };
+  test_should_be( cc.cwnd(), 10 * MSS );
+  run_rounds( cc, now_ms, ackno, 100, 4 ); // slow start to 160 segments
+  cc.on_loss( now_ms, 100 * MSS );
+  test_should_be( cc.cwnd(), 70 * MSS ); // beta = 0.7
+  test_should_be( static_cast<uint64_t>( cc.w_max() ), 100 * MSS );
+  test_should_be( uint64_t { cc.phase() == Cubic::Phase::CongestionAvoidance }, uint64_t { 1 } );
+
+  // K = cbrt(30 segments / 0.4) ~ 4.2 s: concave growth back to W_max, then convex growth past it.
+  run_rounds( cc, now_ms, ackno, 100, 42 );
+  test_should_be( uint64_t { cc.cwnd() > 95 * MSS and cc.cwnd() <= 101 * MSS }, uint64_t { 1 } );
+  run_rounds( cc, now_ms, ackno, 100, 40 );
+  test_should_be( uint64_t { cc.cwnd() > 115 * MSS }, uint64_t { 1 } );
+
+  // Fast convergence: losing again below W_max lowers W_max further.
+  Cubic shrinking { MSS };
+  shrinking.on_loss( 0, 10 * MSS );
+  shrinking.on_loss( 0, 7 * MSS );
+  test_should_be( static_cast<uint64_t>( shrinking.w_max() ), uint64_t { 5950 } );
+
+  // With a short RTT, Reno's AIMD would outgrow the cubic curve; CUBIC follows it instead.
+  Cubic short_rtt { MSS };
+  short_rtt.on_loss( 0, 10 * MSS );
+  now_ms = 0;
+  run_rounds( short_rtt, now_ms, ackno, 1, 100 );
+  test_should_be( uint64_t { short_rtt.cwnd() > 20 * MSS }, uint64_t { 1 } );
+
+  // A timeout restarts slow start from one segment, toward the reduced ssthresh.
+  cc.on_rto( now_ms, 100 * MSS );
+  test_should_be( cc.cwnd(), MSS );
+  test_should_be( uint64_t { cc.phase() == Cubic::Phase::SlowStart }, uint64_t { 1 } );
+}
+
+void test_hystart()
+{
+  uint64_t now_ms = 0;
+  uint64_t ackno = 0;
+
+  Cubic cc { MSS };
+  run_rounds( cc, now_ms, ackno, 100, 2 );
+  test_should_be( uint64_t { cc.phase() == Cubic::Phase::SlowStart }, uint64_t { 1 } );
+  test_should_be( cc.cwnd(), 40 * MSS ); // doubling each round
+
+  // The round's minimum RTT rises by more than max(4, min(100/8, 16)) ms: slow down.
+  run_rounds( cc, now_ms, ackno, 113, 1 );
+  test_should_be( uint64_t { cc.phase() == Cubic::Phase::ConservativeSlowStart }, uint64_t { 1 } );
+  const uint64_t at_css = cc.cwnd();
+  test_should_be( uint64_t { at_css < 80 * MSS }, uint64_t { 1 } );
+
+  // After CSS_ROUNDS rounds of quarter-speed growth (1.25x each), leave slow start for good.
+  run_rounds( cc, now_ms, ackno, 113, 4 );
+  test_should_be( uint64_t { cc.phase() == Cubic::Phase::ConservativeSlowStart }, uint64_t { 1 } );
+  run_rounds( cc, now_ms, ackno, 113, 1 );
+  test_should_be( uint64_t { cc.phase() == Cubic::Phase::CongestionAvoidance }, uint64_t { 1 } );
+  test_should_be( uint64_t { cc.ssthresh() > 2 * at_css and cc.ssthresh() < 4 * at_css }, uint64_t { 1 } );
+
+  // An RTT increase that then goes away resumes ordinary slow start.
+  Cubic spurious { MSS };
+  now_ms = 0;
+  ackno = 0;
+  run_rounds( spurious, now_ms, ackno, 100, 2 );
+  run_rounds( spurious, now_ms, ackno, 113, 1 );
+  test_should_be( uint64_t { spurious.phase() == Cubic::Phase::ConservativeSlowStart }, uint64_t { 1 } );
+  run_rounds( spurious, now_ms, ackno, 100, 1 );
+  test_should_be( uint64_t { spurious.phase() == Cubic::Phase::SlowStart }, uint64_t { 1 } );
+}
+
+
+// Delivers `rate` bytes/s for one `rtt_ms` round trip per call, as a single ACK with its rate sample.
+struct BbrDriver
+{
+  Bbr cc { MSS };
+  uint64_t now_ms {};
+  uint64_t delivered {};
+
+  void ack( uint64_t rate, uint64_t rtt_ms, uint64_t bytes_in_flight )
+  {
+    const uint64_t bytes = rate * rtt_ms / 1000;
+    const uint64_t prior_delivered = delivered;
+    delivered += bytes;
+    now_ms += rtt_ms;
+    cc.on_ack( { .now_ms = now_ms,
+                 .ackno = delivered,
+                 .bytes_acked = bytes,
+                 .bytes_in_flight = bytes_in_flight,
+                 .rtt_ms = rtt_ms,
+                 .delivered = delivered,
+                 .rate = RateSample {
+                   .delivered = bytes, .interval_ms = rtt_ms, .prior_delivered = prior_delivered } } );
+  }
+
+  uint64_t mode() const { return static_cast<uint64_t>( cc.mode() ); }
+};
+
+void test_bbr_directly()
+{
+  BbrDriver bbr;
+  test_should_be( bbr.cc.cwnd(), 10 * MSS );
+  test_should_be( bbr.cc.pacing_rate().value_or( 0 ), uint64_t { 0 } );
+
+  // Startup: the estimate stops growing, and after three rounds of that the pipe is full.
+  // With in flight already at one BDP, Drain is over at once.
+  bbr.ack( 100'000, 100, 10'000 );
+  test_should_be( bbr.cc.bottleneck_bandwidth(), uint64_t { 100'000 } );
+  test_should_be( bbr.cc.min_rtt_ms().value_or( 0 ), uint64_t { 100 } );
+  test_should_be( bbr.cc.bdp(), uint64_t { 10'000 } );
+  test_should_be( bbr.mode(), static_cast<uint64_t>( Bbr::Mode::Startup ) );
+  test_should_be( uint64_t { bbr.cc.pacing_rate().value() > 250'000 }, uint64_t { 1 } );
+  for ( int i = 0; i < 3; ++i ) {
+    bbr.ack( 100'000, 100, 10'000 );
+  }
+  test_should_be( bbr.mode(), static_cast<uint64_t>( Bbr::Mode::ProbeBandwidth ) );
+  test_should_be( bbr.cc.cwnd(), 2 * bbr.cc.bdp() );
+  test_should_be( bbr.cc.pacing_rate().value_or( 0 ), uint64_t { 100'000 } );
+
+  // One min RTT later, probe for more bandwidth; a lower sample doesn't lower the estimate.
+  bbr.ack( 100'000, 100, 20'000 );
+  bbr.ack( 50'000, 100, 20'000 );
+  test_should_be( bbr.cc.pacing_rate().value_or( 0 ), uint64_t { 125'000 } );
+  test_should_be( bbr.cc.bottleneck_bandwidth(), uint64_t { 100'000 } );
+
+  // Ten seconds without a new min RTT: drop to four segments to measure it again.
+  const uint64_t last_min_rtt_ms = bbr.now_ms;
+  while ( bbr.mode() != static_cast<uint64_t>( Bbr::Mode::ProbeRtt ) and bbr.now_ms < 20'000 ) {
+    bbr.ack( 100'000, 120, 20'000 );
+  }
+  test_should_be( uint64_t { bbr.now_ms > last_min_rtt_ms + 10'000 }, uint64_t { 1 } );
+  test_should_be( bbr.cc.cwnd(), 4 * MSS );
+  test_should_be( bbr.cc.min_rtt_ms().value_or( 0 ), uint64_t { 120 } );
+
+  // Once in flight is down to that, hold it for 200 ms and a round, then carry on probing.
+  bbr.ack( 100'000, 120, 4 * MSS );
+  bbr.ack( 100'000, 120, 4 * MSS );
+  test_should_be( bbr.mode(), static_cast<uint64_t>( Bbr::Mode::ProbeRtt ) );
+  bbr.ack( 100'000, 120, 4 * MSS );
+  test_should_be( bbr.mode(), static_cast<uint64_t>( Bbr::Mode::ProbeBandwidth ) );
+  test_should_be( bbr.cc.cwnd(), 2 * bbr.cc.bdp() );
+
+  // A timeout drops to one segment until what was in flight is acknowledged.
+  const uint64_t cwnd = bbr.cc.cwnd();
+  bbr.cc.on_rto( bbr.now_ms, cwnd );
+  test_should_be( bbr.cc.cwnd(), MSS );
+  bbr.ack( 100'000, 120, cwnd );
+  test_should_be( uint64_t { bbr.cc.cwnd() < cwnd }, uint64_t { 1 } );
+  bbr.ack( 100'000, 120, 0 );
+  test_should_be( bbr.cc.cwnd(), cwnd );
+}
+
+// Keeps a copy of every ACK sample the sender reports, and never limits it.
+class RecordingControl : public NoCongestionControl
+{
+public:
+  explicit RecordingControl( shared_ptr<vector<AckSample>> samples ) : samples_( move( samples ) ) {}
+  void on_ack( const AckSample& ack ) override { samples_->push_back( ack ); }
+
+private:
+  shared_ptr<vector<AckSample>> samples_;
+};
+
+} // namespace
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    test_newreno_directly();
+    test_cubic_directly();
+    test_hystart();
+    test_bbr_directly();
+
+    for ( const auto& [name, algorithm] : { pair { "NewReno"s, CongestionControlAlgorithm::NewReno },
+                                            pair { "CUBIC"s, CongestionControlAlgorithm::Cubic } } ) {
+      {
+        TCPConfig cfg;
+        const Wrap32 isn( rd() );
+        cfg.isn = isn;
+        cfg.congestion_control = algorithm;
+
+        TCPSenderTestHarness test { name + " starts with a ten-segment window", cfg };
+        test.execute( Push {} );
+        test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+        test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( BIG_WINDOW ) );
+        test.execute( ExpectCongestionWindow { 10 * MSS + 1 } ); // the SYN's ACK counts too
+        test.execute( Push { string( 20 * MSS, 'x' ) } );
+        expect_full_segments( test, 10 );
+        test.execute( ExpectMessage {}.with_no_flags().with_payload_size( 1 ) );
+        test.execute( ExpectNoSegment {} );
+        test.execute( ExpectSeqnosInFlight { 10 * MSS + 1 } );
+      }
+
+      {
+        TCPConfig cfg;
+        const Wrap32 isn( rd() );
+        cfg.isn = isn;
+        cfg.congestion_control = algorithm;
+
+        TCPSenderTestHarness test { name + ": slow start sends two segments for each one acknowledged", cfg };
+        test.execute( Push {} );
+        test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+        test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( BIG_WINDOW ) );
+        test.execute( Push { string( 10 * MSS, 'x' ) } );
+        expect_full_segments( test, 10 );
+        test.execute( AckReceived { Wrap32 { isn + 1 + MSS } }.with_win( BIG_WINDOW ) );
+        test.execute( Push { string( 10 * MSS, 'y' ) } );
+        expect_full_segments( test, 2 );
+        test.execute( ExpectMessage {}.with_no_flags().with_payload_size( 1 ) );
+        test.execute( ExpectNoSegment {} );
+        test.execute( ExpectCongestionWindow { 11 * MSS + 1 } );
+      }
+
+      {
+        TCPConfig cfg;
+        const Wrap32 isn( rd() );
+        cfg.isn = isn;
+        cfg.congestion_control = algorithm;
+        const uint64_t rto = cfg.rt_timeout;
+
+        TCPSenderTestHarness test { name + ": a timeout collapses the window to one segment", cfg };
+        test.execute( Push {} );
+        test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+        test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( BIG_WINDOW ) );
+        test.execute( Push { string( 10 * MSS, 'x' ) } );
+        expect_full_segments( test, 10 );
+        test.execute( Tick { rto } );
+        test.execute( ExpectMessage {}.with_no_flags().with_payload_size( MSS ).with_seqno( isn + 1 ) );
+        test.execute( ExpectCongestionWindow { MSS } );
+        test.execute( Push { string( 10 * MSS, 'y' ) } );
+        test.execute( ExpectNoSegment {} );
+        test.execute( AckReceived { Wrap32 { isn + 1 + 10 * MSS } }.with_win( BIG_WINDOW ) );
+        test.execute( ExpectCongestionWindow { 2 * MSS } );
+        test.execute( Push {} );
+        expect_full_segments( test, 2 );
+        test.execute( ExpectNoSegment {} );
+      }
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      const auto samples = make_shared<vector<AckSample>>();
+
+      TCPSenderTestHarness test { "Each ACK carries an RTT and delivery-rate sample", cfg,
+                                  make_unique<RecordingControl>( samples ) };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( Tick { 100 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( BIG_WINDOW ) );
+      test.execute( Push { string( 10 * MSS, 'x' ) } );
+      expect_full_segments( test, 10 );
+      test.execute( Tick { 50 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 + 4 * MSS } }.with_win( BIG_WINDOW ) );
+      test.execute( Tick { 50 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 + 10 * MSS } }.with_win( BIG_WINDOW ) );
+
+      test_should_be( samples->size(), size_t { 3 } );
+      test_should_be( samples->at( 0 ).rtt_ms.value_or( 0 ), uint64_t { 100 } );
+      test_should_be( samples->at( 0 ).delivered, uint64_t { 1 } );
+
+      // Everything went out at t=100, so the later ACK measures over the longer interval.
+      const AckSample& last = samples->at( 2 );
+      test_should_be( last.now_ms, uint64_t { 200 } );
+      test_should_be( last.ackno, 1 + 10 * MSS );
+      test_should_be( last.bytes_acked, 6 * MSS );
+      test_should_be( last.bytes_in_flight, uint64_t { 0 } );
+      test_should_be( last.rtt_ms.value_or( 0 ), uint64_t { 100 } );
+      test_should_be( last.delivered, 1 + 10 * MSS );
+      test_should_be( uint64_t { last.rate.has_value() }, uint64_t { 1 } );
+      test_should_be( last.rate->delivered, 10 * MSS );
+      test_should_be( last.rate->interval_ms, uint64_t { 100 } );
+      test_should_be( last.rate->prior_delivered, uint64_t { 1 } );
+      test_should_be( last.rate->rate(), uint64_t { 100'000 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      const uint64_t rto = cfg.rt_timeout;
+      const auto samples = make_shared<vector<AckSample>>();
+
+      TCPSenderTestHarness test { "A retransmitted segment gives no RTT or rate sample", cfg,
+                                  make_unique<RecordingControl>( samples ) };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( Tick { rto } );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( BIG_WINDOW ) );
+      test_should_be( samples->size(), size_t { 1 } );
+      test_should_be( uint64_t { samples->at( 0 ).rtt_ms.has_value() }, uint64_t { 0 } );
+      test_should_be( uint64_t { samples->at( 0 ).rate.has_value() }, uint64_t { 0 } );
+      test_should_be( samples->at( 0 ).delivered, uint64_t { 1 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.congestion_control = CongestionControlAlgorithm::None;
+
+      TCPSenderTestHarness test { "Without congestion control, the receiver's window is the limit", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( BIG_WINDOW ) );
+      test.execute( Push { string( 20 * MSS, 'x' ) } );
+      expect_full_segments( test, 20 );
+      test.execute( ExpectNoSegment {} );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
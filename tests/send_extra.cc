@@ -158,6 +158,7 @@ int main()
       TCPConfig cfg;
       const Wrap32 isn( rd() );
       cfg.isn = isn;
+      cfg.congestion_control = CongestionControlAlgorithm::None; // the window here is the receiver's alone
 
       const string nicechars = "abcdefghijklmnopqrstuvwxyz";
       string bigstring;
@@ -490,6 +491,7 @@ int main()
       TCPConfig cfg;
       const Wrap32 isn( rd() );
       cfg.isn = isn;
+      cfg.congestion_control = CongestionControlAlgorithm::None; // the window here is the receiver's alone
       const string nicechars = "abcdefghijklmnopqrstuvwxyz";
       string bigstring;
       for ( unsigned int i = 0; i < TCPConfig::DEFAULT_CAPACITY; i++ ) {
@@ -667,6 +669,7 @@ int main()
       TCPConfig cfg;
       const Wrap32 isn( rd() );
       cfg.isn = isn;
+      cfg.congestion_control = CongestionControlAlgorithm::None; // the window here is the receiver's alone
       const string nicechars = "abcdefghijklmnopqrstuvwxyz";
       string bigstring;
       for ( unsigned int i = 0; i < TCPConfig::DEFAULT_CAPACITY; i++ ) {
@@ -0,0 +1,245 @@
+#include "fd_adapter.hh"
+#include "lossy_fd_adapter.hh"
+#include "random.hh"
+#include "sender_test_harness.hh"
+#include "tcp_peer.hh"
+#include "tcp_segment.hh"
+#include "tuntap_adapter.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+constexpr uint64_t JUMBO_MSS = 8960; // a 9000-byte MTU, less the IPv4 and TCP headers
+
+// An MSS option on a SYN leaves room for three SACK blocks, and survives serialize() and parse().
+void test_mss_option_roundtrip()
+{
+  TCPSegment seg;
+  seg.message.sender->SYN = true;
+  seg.message.receiver->ackno = Wrap32 { 4000 };
+  seg.message.receiver->mss = 1460;
+  seg.message.receiver->sack_blocks = { { { Wrap32 { 5000 }, Wrap32 { 6000 } },
+                                          { Wrap32 { 4100 }, Wrap32 { 4200 } },
+                                          { Wrap32 { 4300 }, Wrap32 { 4400 } },
+                                          { Wrap32 { 4500 }, Wrap32 { 4600 } } } };
+  seg.message.receiver->sack_block_count = 4;
+  seg.compute_checksum( 0 );
+
+  Serializer serializer;
+  seg.serialize( serializer );
+  auto wire = serializer.finish();
+  uint64_t length = 0;
+  for ( const auto& buf : wire ) {
+    length += buf->size();
+  }
+  test_should_be( length, uint64_t { TCPSegment::HEADER_LENGTH + 4 + 28 } );
+
+  TCPSegment parsed;
+  Parser parser { std::move( wire ) };
+  parsed.parse( parser, 0 );
+  test_should_be( uint64_t { parser.has_error() }, uint64_t { 0 } );
+  test_should_be( uint64_t { parsed.message.receiver->mss.value_or( 0 ) }, uint64_t { 1460 } );
+  test_should_be( uint64_t { parsed.message.receiver->sack_block_count }, uint64_t { 3 } );
+  test_should_be( uint64_t { parsed.message.sender->SYN }, uint64_t { 1 } );
+}
+
+// push_batch() and tick_batch() hand over everything they send in one call, or none at all.
+void test_batches( Wrap32 isn )
+{
+  TCPSender sender { ByteStream { 10 * JUMBO_MSS },
+                     isn,
+                     TCPConfig::TIMEOUT_DFLT,
+                     CongestionControlAlgorithm::None,
+                     nullopt,
+                     nullopt,
+                     JUMBO_MSS };
+  vector<size_t> train_lengths;
+  vector<uint64_t> payload_sizes;
+  const auto transmit = [&]( span<const TCPSenderMessage> train ) {
+    train_lengths.push_back( train.size() );
+    for ( const TCPSenderMessage& msg : train ) {
+      payload_sizes.push_back( msg.payload.size() );
+    }
+  };
+
+  sender.push_batch( transmit );
+  sender.receive( { .ackno = isn + 1, .window_size = BIG_WINDOW } );
+  sender.writer().push( string( 5 * JUMBO_MSS, 'x' ) );
+  sender.push_batch( transmit );
+  sender.push_batch( transmit ); // nothing more to send
+  test_should_be( uint64_t { train_lengths.size() }, uint64_t { 2 } );
+  test_should_be( uint64_t { train_lengths.at( 1 ) }, uint64_t { 5 } );
+  test_should_be( payload_sizes.back(), JUMBO_MSS );
+
+  sender.tick_batch( TCPConfig::TIMEOUT_DFLT - 1, transmit );
+  test_should_be( uint64_t { train_lengths.size() }, uint64_t { 2 } );
+  sender.tick_batch( 1, transmit );
+  test_should_be( uint64_t { train_lengths.size() }, uint64_t { 3 } );
+  test_should_be( uint64_t { train_lengths.back() }, uint64_t { 1 } );
+
+  // The batches' copies of the segments are gone, so acknowledged blocks go back into rotation.
+  sender.receive( { .ackno = isn + 1 + 5 * JUMBO_MSS, .window_size = BIG_WINDOW } );
+  test_should_be( uint64_t { sender.send_buffer().blocks_held() }, uint64_t { 0 } );
+}
+
+// A TCPPeer advertises its MSS on its SYN, and only there.
+void test_peer_advertises_mss()
+{
+  TCPConfig cfg;
+  cfg.mss = JUMBO_MSS;
+  TCPPeer peer { cfg };
+  vector<TCPMessage> sent;
+  const auto transmit
+    = [&sent]( span<const TCPMessage> train ) { sent.insert( sent.end(), train.begin(), train.end() ); };
+
+  peer.push_batch( transmit );
+  test_should_be( uint64_t { sent.size() }, uint64_t { 1 } );
+  test_should_be( uint64_t { sent.at( 0 ).sender->SYN }, uint64_t { 1 } );
+  test_should_be( uint64_t { sent.at( 0 ).receiver->mss.value_or( 0 ) }, JUMBO_MSS );
+
+  TCPMessage syn_ack;
+  syn_ack.sender->SYN = true;
+  syn_ack.sender->seqno = Wrap32 { 0 };
+  syn_ack.receiver->ackno = cfg.isn + 1;
+  syn_ack.receiver->window_size = BIG_WINDOW;
+  syn_ack.receiver->mss = 1460;
+  peer.receive_batch( std::move( syn_ack ), transmit );
+  test_should_be( peer.sender().mss(), uint64_t { 1460 } );
+  test_should_be( uint64_t { sent.size() }, uint64_t { 2 } );
+  test_should_be( uint64_t { sent.at( 1 ).sender->SYN or sent.at( 1 ).receiver->mss.has_value() }, uint64_t { 0 } );
+}
+
+// Records the trains it is handed, as (first index, length) into the caller's array of segments.
+class RecordingAdapter : public FdAdapterBase
+{
+  const TCPMessage* base_;
+  vector<pair<size_t, size_t>>* runs_;
+
+public:
+  RecordingAdapter( const TCPMessage* base, vector<pair<size_t, size_t>>* runs ) : base_( base ), runs_( runs ) {}
+
+  optional<TCPMessage> read() { return {}; }
+  void write( const TCPMessage& seg ) { runs_->emplace_back( &seg - base_, 1 ); }
+  void write_batch( span<const TCPMessage> segs ) { runs_->emplace_back( segs.data() - base_, segs.size() ); }
+};
+
+static_assert( TCPDatagramAdapter<LossyFdAdapter<RecordingAdapter>> );
+
+// LossyFdAdapter passes a train on in place, split only where it drops a segment.
+void test_lossy_write_batch()
+{
+  const vector<TCPMessage> train( 1000 );
+
+  vector<pair<size_t, size_t>> runs;
+  LossyFdAdapter lossless { RecordingAdapter { train.data(), &runs } };
+  lossless.write_batch( train );
+  test_should_be( uint64_t { runs.size() }, uint64_t { 1 } );
+  test_should_be( uint64_t { runs.front().first }, uint64_t { 0 } );
+  test_should_be( uint64_t { runs.front().second }, uint64_t { train.size() } );
+
+  runs.clear();
+  LossyFdAdapter lossy { RecordingAdapter { train.data(), &runs } };
+  lossy.config_mut().loss_rate_up = UINT16_MAX / 2;
+  lossy.write_batch( train );
+  size_t next = 0;
+  size_t written = 0;
+  for ( const auto& [first, length] : runs ) {
+    test_should_be( uint64_t { written == 0 or first > next }, uint64_t { 1 } ); // at least one drop between runs
+    test_should_be( uint64_t { length > 0 }, uint64_t { 1 } );
+    next = first + length;
+    written += length;
+  }
+  test_should_be( uint64_t { next <= train.size() }, uint64_t { 1 } );
+  test_should_be( uint64_t { written > 0 and written < train.size() }, uint64_t { 1 } );
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.congestion_control = CongestionControlAlgorithm::None;
+      cfg.mss = JUMBO_MSS;
+
+      TCPSenderTestHarness test { "A configured MSS sizes the segments", cfg };
+      connect_sender( test, isn );
+      test.execute( ExpectMss { JUMBO_MSS } );
+      test.execute( Push { string( 2 * JUMBO_MSS + 100, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( JUMBO_MSS ).with_seqno( isn + 1 ) );
+      test.execute( ExpectMessage {}.with_payload_size( JUMBO_MSS ).with_seqno( isn + 1 + JUMBO_MSS ) );
+      test.execute( ExpectMessage {}.with_payload_size( 100 ).with_seqno( isn + 1 + 2 * JUMBO_MSS ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.congestion_control = CongestionControlAlgorithm::NewReno;
+      cfg.mss = JUMBO_MSS;
+
+      TCPSenderTestHarness test { "The peer's MSS option lowers it, and the initial window with it", cfg };
+      test.execute( ExpectCongestionWindow { 2 * JUMBO_MSS } );
+      connect_sender( test, isn, 1460 );
+      test.execute( ExpectMss { 1460 } );
+      test.execute( ExpectCongestionWindow { 14600 + 1 } ); // RFC 6928 for 1460 bytes, plus the SYN
+      test.execute( Push { string( 3000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 1460 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1460 ).with_seqno( isn + 1 + 1460 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 80 ).with_seqno( isn + 1 + 2 * 1460 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "A larger MSS option doesn't raise it", cfg };
+      connect_sender( test, isn, 9000 );
+      test.execute( ExpectMss { TCPConfig::MAX_PAYLOAD_SIZE } );
+      test.execute( Push { string( 1500, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( TCPConfig::MAX_PAYLOAD_SIZE ) );
+      test.execute( ExpectMessage {}.with_payload_size( 500 ) );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "An MSS option once data is delivered is ignored", cfg };
+      connect_sender( test, isn );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( BIG_WINDOW ).with_mss( 500 ) );
+      test.execute( ExpectMss { TCPConfig::MAX_PAYLOAD_SIZE } );
+    }
+
+    test_mss_option_roundtrip();
+    test_batches( Wrap32( rd() ) );
+    test_peer_advertises_mss();
+    test_lossy_write_batch();
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
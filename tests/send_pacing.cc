@@ -0,0 +1,132 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+// No window limit, but a fixed pacing rate, as a model-based controller would supply.
+class FixedRateControl : public NoCongestionControl
+{
+public:
+  explicit FixedRateControl( uint64_t bytes_per_s ) : rate_( bytes_per_s ) {}
+  optional<uint64_t> pacing_rate() const override { return rate_; }
+
+private:
+  uint64_t rate_;
+};
+
+} // namespace
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.congestion_control = CongestionControlAlgorithm::None;
+      cfg.pacing = PacingConfig { .rate = 100'000, .burst_bytes = 2 * MSS };
+
+      TCPSenderTestHarness test { "A configured rate spaces segments out after a burst", cfg };
+      connect_sender( test, isn );
+      test.execute( Push { string( 5 * MSS, 'x' ) } );
+      expect_segment( test, isn, 0 );
+      expect_segment( test, isn, 1 ); // the SYN took a byte of the bucket, so this one overdraws it
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectMsUntilNextSend { 1 } );
+
+      test.execute( Tick { 1 } );
+      expect_segment( test, isn, 2 );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectMsUntilNextSend { 10 } ); // 100 bytes a millisecond
+
+      test.execute( Tick { 9 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectMsUntilNextSend { 1 } );
+      test.execute( Tick { 1 } );
+      expect_segment( test, isn, 3 );
+      test.execute( Tick { 10 } );
+      expect_segment( test, isn, 4 );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectMsUntilNextSend { nullopt } ); // nothing left to hold back
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.pacing = PacingConfig {};
+
+      TCPSenderTestHarness test { "The controller's pacing rate is used when none is configured",
+                                  cfg,
+                                  make_unique<FixedRateControl>( 200'000 ) };
+      connect_sender( test, isn );
+      test.execute( Push { string( 4 * MSS, 'x' ) } );
+      expect_segment( test, isn, 0 );
+      expect_segment( test, isn, 1 );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      expect_segment( test, isn, 2 );
+      test.execute( ExpectMsUntilNextSend { 5 } );
+      test.execute( Tick { 4 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      expect_segment( test, isn, 3 );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.pacing = PacingConfig {};
+
+      TCPSenderTestHarness test { "Without a rate from config or controller, nothing is held back", cfg };
+      connect_sender( test, isn );
+      test.execute( Push { string( 10 * MSS, 'x' ) } );
+      for ( uint64_t i = 0; i < 10; ++i ) {
+        expect_segment( test, isn, i );
+      }
+      test.execute( ExpectMsUntilNextSend { nullopt } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.fast_retransmit = true;
+      cfg.congestion_control = CongestionControlAlgorithm::None;
+      cfg.pacing = PacingConfig { .rate = 1'000, .burst_bytes = 3 * MSS };
+
+      TCPSenderTestHarness test { "A fast retransmit isn't held back by pacing", cfg };
+      connect_sender( test, isn );
+      test.execute( Push { string( 4 * MSS, 'x' ) } );
+      for ( uint64_t i = 0; i < 3; ++i ) {
+        expect_segment( test, isn, i );
+      }
+      test.execute( ExpectNoSegment {} );
+      for ( int i = 0; i < 3; ++i ) {
+        test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( BIG_WINDOW ) );
+      }
+      expect_segment( test, isn, 0 );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectMsUntilNextSend { 1002 } ); // but it does add to the debt
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,155 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.fast_retransmit = true;
+      cfg.congestion_control = CongestionControlAlgorithm::NewReno;
+
+      TCPSenderTestHarness test { "Three duplicate ACKs trigger a fast retransmit and fast recovery", cfg };
+      send_ten_segments( test, isn );
+      duplicate_acks( test, isn + 1, 2 );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectFastRecovery { false } );
+      duplicate_acks( test, isn + 1, 1 );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( MSS ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectFastRecovery { true } );
+      test.execute( ExpectCongestionWindow { 5 * MSS } ); // half of what was in flight
+      test.execute( ExpectSeqnosInFlight { 10 * MSS } );
+
+      // Each further duplicate says another segment has left the network; once that makes
+      // room beyond the ten outstanding, new data goes out.
+      test.execute( Push { string( 10 * MSS, 'y' ) } );
+      duplicate_acks( test, isn + 1, 2 );
+      test.execute( ExpectNoSegment {} );
+      duplicate_acks( test, isn + 1, 1 );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( MSS ).with_seqno( isn + 1 + 10 * MSS ) );
+      test.execute( ExpectNoSegment {} );
+
+      // A partial ACK: the third segment was lost as well. It is resent at once.
+      test.execute( AckReceived { Wrap32 { isn + 1 + 2 * MSS } }.with_win( BIG_WINDOW ) );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( MSS ).with_seqno( isn + 1 + 2 * MSS ) );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( MSS ).with_seqno( isn + 1 + 11 * MSS ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectFastRecovery { true } );
+      test.execute( ExpectCongestionWindow { 5 * MSS } );
+
+      // A full ACK, past everything sent before the loss, ends recovery at the reduced window.
+      test.execute( AckReceived { Wrap32 { isn + 1 + 11 * MSS } }.with_win( BIG_WINDOW ) );
+      test.execute( ExpectFastRecovery { false } );
+      test.execute( ExpectCongestionWindow { 5 * MSS } );
+      for ( uint64_t i = 12; i < 16; ++i ) {
+        test.execute( ExpectMessage {}.with_no_flags().with_payload_size( MSS ).with_seqno( isn + 1 + i * MSS ) );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 5 * MSS } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.fast_retransmit = true;
+      cfg.congestion_control = CongestionControlAlgorithm::NewReno;
+
+      TCPSenderTestHarness test { "Only ACKs with data outstanding and an unchanged window count as duplicates",
+                                  cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      duplicate_acks( test, isn + 1, 4 );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Push { string( 2 * MSS, 'x' ) } );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( MSS ).with_seqno( isn + 1 ) );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( MSS ).with_seqno( isn + 1 + MSS ) );
+      for ( const uint16_t window : { 50000, 50001, 50002, 50003 } ) {
+        test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( window ) );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectFastRecovery { false } );
+      test.execute( AckReceived { Wrap32 { isn } }.with_win( 50003 ) ); // old, not a duplicate
+      test.execute( AckReceived { Wrap32 { isn } }.with_win( 50003 ) );
+      test.execute( AckReceived { Wrap32 { isn } }.with_win( 50003 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectFastRecovery { false } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.fast_retransmit = true;
+      cfg.congestion_control = CongestionControlAlgorithm::NewReno;
+
+      TCPSenderTestHarness test { "A timeout ends fast recovery, and old duplicates don't restart it", cfg };
+      send_ten_segments( test, isn );
+      duplicate_acks( test, isn + 1, 3 );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( MSS ).with_seqno( isn + 1 ) );
+      test.execute( ExpectFastRecovery { true } );
+      test.execute( Tick { cfg.rt_timeout } );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( MSS ).with_seqno( isn + 1 ) );
+      test.execute( ExpectFastRecovery { false } );
+      test.execute( ExpectCongestionWindow { MSS } );
+
+      // These may be echoes of the segments sent before the timeout, which is already being
+      // handled: no second reduction, and no second retransmission.
+      duplicate_acks( test, isn + 1, 3 );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectFastRecovery { false } );
+      test.execute( ExpectCongestionWindow { MSS } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.fast_retransmit = true;
+      cfg.congestion_control = CongestionControlAlgorithm::None;
+
+      TCPSenderTestHarness test { "Fast retransmit works without a congestion controller", cfg };
+      send_ten_segments( test, isn );
+      test.execute( AckReceived { Wrap32 { isn + 1 + 4 * MSS } }.with_win( BIG_WINDOW ) );
+      duplicate_acks( test, isn + 1 + 4 * MSS, 3 );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( MSS ).with_seqno( isn + 1 + 4 * MSS ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 1 + 10 * MSS } }.with_win( BIG_WINDOW ) );
+      test.execute( ExpectFastRecovery { false } );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.congestion_control = CongestionControlAlgorithm::NewReno;
+
+      TCPSenderTestHarness test { "Without fast retransmit, duplicate ACKs wait for the timer", cfg };
+      send_ten_segments( test, isn );
+      duplicate_acks( test, isn + 1, 5 );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectFastRecovery { false } );
+      test.execute( Tick { TCPConfig::TIMEOUT_DFLT } );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( MSS ).with_seqno( isn + 1 ) );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
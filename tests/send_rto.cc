@@ -0,0 +1,137 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "RTTs are measured even when the RTO is fixed", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( Tick { 40 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      test.execute( ExpectRttSamples { 1 } );
+      test.execute( ExpectSmoothedRtt { 40 } );
+      test.execute( ExpectRto { TCPConfig::TIMEOUT_DFLT } );
+      test.execute( Push { "a" } );
+      test.execute( ExpectMessage {}.with_data( "a" ).with_seqno( isn + 1 ) );
+      test.execute( Tick { TCPConfig::TIMEOUT_DFLT - 1U } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_data( "a" ).with_seqno( isn + 1 ) );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.adaptive_rto = RtoLimits { .min_ms = 1, .max_ms = 60'000 };
+
+      TCPSenderTestHarness test { "The RTO follows SRTT + 4 * RTTVAR", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( ExpectRto { TCPConfig::TIMEOUT_DFLT } );
+      test.execute( Tick { 100 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      test.execute( ExpectSmoothedRtt { 100 } );
+      test.execute( ExpectRto { 300 } ); // first sample R: SRTT = R, RTTVAR = R/2
+
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_seqno( isn + 1 ) );
+      test.execute( Tick { 299 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_seqno( isn + 1 ) );
+
+      // The ACK may be for either transmission, so it isn't timed (Karn's algorithm),
+      // but it still clears the backoff.
+      test.execute( Tick { 50 } );
+      test.execute( AckReceived { Wrap32 { isn + 4 } } );
+      test.execute( ExpectRttSamples { 1 } );
+      test.execute( ExpectRto { 300 } );
+
+      test.execute( Push { "defg" } );
+      test.execute( ExpectMessage {}.with_data( "defg" ).with_seqno( isn + 4 ) );
+      test.execute( Tick { 200 } );
+      test.execute( AckReceived { Wrap32 { isn + 8 } } );
+      test.execute( ExpectRttSamples { 2 } );
+      test.execute( ExpectSmoothedRtt { 113 } ); // 7/8 * 100 + 1/8 * 200
+      test.execute( ExpectRto { 363 } );         // + 4 * (3/4 * 50 + 1/4 * 100)
+
+      test.execute( Push { "h" } );
+      test.execute( ExpectMessage {}.with_data( "h" ).with_seqno( isn + 8 ) );
+      test.execute( Tick { 362 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_data( "h" ).with_seqno( isn + 8 ) );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.adaptive_rto = RtoLimits {};
+
+      TCPSenderTestHarness test { "An ACK that covers a retransmission isn't timed", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( Tick { 100 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      test.execute( Push { "a" } );
+      test.execute( ExpectMessage {}.with_data( "a" ).with_seqno( isn + 1 ) );
+      test.execute( Tick { 10 } );
+      test.execute( Push { "b" } );
+      test.execute( ExpectMessage {}.with_data( "b" ).with_seqno( isn + 2 ) );
+      test.execute( Tick { 290 } );
+      test.execute( ExpectMessage {}.with_data( "a" ).with_seqno( isn + 1 ) );
+
+      // "b" was only sent once, but its ACK waited on the retransmitted "a".
+      test.execute( Tick { 100 } );
+      test.execute( AckReceived { Wrap32 { isn + 3 } } );
+      test.execute( ExpectRttSamples { 1 } );
+      test.execute( ExpectSmoothedRtt { 100 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.adaptive_rto = RtoLimits { .min_ms = 200, .max_ms = 1000 };
+
+      TCPSenderTestHarness test { "The adaptive RTO stays within its limits, backoff included", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( Tick { 10 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      test.execute( ExpectRto { 200 } );
+
+      test.execute( Push { "x" } );
+      test.execute( ExpectMessage {}.with_data( "x" ).with_seqno( isn + 1 ) );
+      for ( const uint64_t rto : { 200, 400, 800, 1000, 1000 } ) {
+        test.execute( Tick { rto - 1 } );
+        test.execute( ExpectNoSegment {} );
+        test.execute( Tick { 1 } );
+        test.execute( ExpectMessage {}.with_data( "x" ).with_seqno( isn + 1 ) );
+      }
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,163 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.fast_retransmit = true;
+      cfg.congestion_control = CongestionControlAlgorithm::NewReno;
+
+      TCPSenderTestHarness test { "SACK recovery resends every hole without waiting for partial ACKs", cfg };
+      send_ten_segments( test, isn );
+
+      // Segments 0, 2 and 4 are lost. The third duplicate ACK starts recovery as usual.
+      test.execute( AckReceived { segment( isn, 0 ) }
+                      .with_win( BIG_WINDOW )
+                      .with_sack( segment( isn, 1 ), segment( isn, 2 ) ) );
+      test.execute( AckReceived { segment( isn, 0 ) }
+                      .with_win( BIG_WINDOW )
+                      .with_sack( segment( isn, 3 ), segment( isn, 4 ) )
+                      .with_sack( segment( isn, 1 ), segment( isn, 2 ) ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { segment( isn, 0 ) }
+                      .with_win( BIG_WINDOW )
+                      .with_sack( segment( isn, 5 ), segment( isn, 6 ) )
+                      .with_sack( segment( isn, 3 ), segment( isn, 4 ) )
+                      .with_sack( segment( isn, 1 ), segment( isn, 2 ) ) );
+      expect_segment( test, isn, 0 );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectFastRecovery { true } );
+      test.execute( ExpectCongestionWindow { 5 * MSS } );
+      test.execute( ExpectSeqnosInPipe { 7 * MSS } ); // 10 sent - 3 SACKed - 1 lost + 1 resent
+      test.execute( Push { string( 10 * MSS, 'y' ) } );
+      test.execute( ExpectNoSegment {} );
+
+      // Each segment SACKed above a hole makes the hole count as lost: no longer in the pipe.
+      test.execute( AckReceived { segment( isn, 0 ) }
+                      .with_win( BIG_WINDOW )
+                      .with_sack( segment( isn, 5 ), segment( isn, 7 ) )
+                      .with_sack( segment( isn, 3 ), segment( isn, 4 ) )
+                      .with_sack( segment( isn, 1 ), segment( isn, 2 ) ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInPipe { 5 * MSS } );
+
+      // One ACK frees room for two segments, and both remaining holes go out at once.
+      test.execute( AckReceived { segment( isn, 0 ) }
+                      .with_win( BIG_WINDOW )
+                      .with_sack( segment( isn, 5 ), segment( isn, 8 ) )
+                      .with_sack( segment( isn, 3 ), segment( isn, 4 ) )
+                      .with_sack( segment( isn, 1 ), segment( isn, 2 ) ) );
+      expect_segment( test, isn, 2 );
+      expect_segment( test, isn, 4 );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInPipe { 5 * MSS } );
+
+      // With every hole resent, room in the pipe goes to new data; SACKed segments are never resent.
+      test.execute( AckReceived { segment( isn, 0 ) }
+                      .with_win( BIG_WINDOW )
+                      .with_sack( segment( isn, 5 ), segment( isn, 9 ) )
+                      .with_sack( segment( isn, 3 ), segment( isn, 4 ) )
+                      .with_sack( segment( isn, 1 ), segment( isn, 2 ) ) );
+      expect_segment( test, isn, 10 );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { segment( isn, 0 ) }
+                      .with_win( BIG_WINDOW )
+                      .with_sack( segment( isn, 5 ), segment( isn, 10 ) )
+                      .with_sack( segment( isn, 3 ), segment( isn, 4 ) )
+                      .with_sack( segment( isn, 1 ), segment( isn, 2 ) ) );
+      expect_segment( test, isn, 11 );
+      test.execute( ExpectNoSegment {} );
+
+      // A partial ACK needs no retransmission of its own: the next hole was resent already.
+      test.execute( AckReceived { segment( isn, 2 ) }
+                      .with_win( BIG_WINDOW )
+                      .with_sack( segment( isn, 5 ), segment( isn, 10 ) )
+                      .with_sack( segment( isn, 3 ), segment( isn, 4 ) ) );
+      expect_segment( test, isn, 12 );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectFastRecovery { true } );
+      test.execute( ExpectSeqnosInPipe { 5 * MSS } );
+
+      // A full ACK ends recovery at the reduced window.
+      test.execute( AckReceived { segment( isn, 10 ) }.with_win( BIG_WINDOW ) );
+      test.execute( ExpectFastRecovery { false } );
+      test.execute( ExpectCongestionWindow { 5 * MSS } );
+      expect_segment( test, isn, 13 );
+      expect_segment( test, isn, 14 );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.fast_retransmit = true;
+      cfg.congestion_control = CongestionControlAlgorithm::NewReno;
+
+      TCPSenderTestHarness test { "Enough SACKed data above a hole starts recovery before three duplicates", cfg };
+      send_ten_segments( test, isn );
+      test.execute( AckReceived { segment( isn, 0 ) }
+                      .with_win( BIG_WINDOW )
+                      .with_sack( segment( isn, 1 ), segment( isn, 3 ) ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectFastRecovery { false } );
+      test.execute( AckReceived { segment( isn, 0 ) }
+                      .with_win( BIG_WINDOW )
+                      .with_sack( segment( isn, 1 ), segment( isn, 4 ) ) );
+      expect_segment( test, isn, 0 );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectFastRecovery { true } );
+      test.execute( ExpectCongestionWindow { 5 * MSS } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.fast_retransmit = true;
+      cfg.congestion_control = CongestionControlAlgorithm::NewReno;
+
+      TCPSenderTestHarness test { "After a timeout, holes resent during recovery may be resent again", cfg };
+      send_ten_segments( test, isn );
+      test.execute( AckReceived { segment( isn, 0 ) }
+                      .with_win( BIG_WINDOW )
+                      .with_sack( segment( isn, 2 ), segment( isn, 10 ) ) );
+      expect_segment( test, isn, 0 );
+      expect_segment( test, isn, 1 );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInPipe { 2 * MSS } );
+
+      test.execute( Tick { cfg.rt_timeout } );
+      expect_segment( test, isn, 0 );
+      test.execute( ExpectFastRecovery { false } );
+      test.execute( ExpectSeqnosInPipe { MSS } ); // only the resend after the timeout counts
+
+      test.execute( AckReceived { segment( isn, 1 ) }
+                      .with_win( BIG_WINDOW )
+                      .with_sack( segment( isn, 2 ), segment( isn, 10 ) ) );
+      expect_segment( test, isn, 1 );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectFastRecovery { false } );
+      test.execute( ExpectSeqnosInPipe { MSS } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -7,6 +7,7 @@
 #include "tcp_sender.hh"
 #include "wrapping_integers.hh"
 
+#include <memory>
 #include <optional>
 #include <queue>
 #include <sstream>
@@ -55,7 +56,27 @@ public:
   TCPSenderTestHarness( std::string name, TCPConfig config )
     : TestHarness( move( name ),
                    "initial_RTO_ms=" + to_string( config.rt_timeout ) + " and ISN=" + to_string( config.isn ),
-                   { TCPSender { ByteStream { config.send_capacity }, config.isn, config.rt_timeout } } )
+                   { TCPSender { ByteStream { config.send_capacity },
+                                 config.isn,
+                                 config.rt_timeout,
+                                 config.congestion_control,
+                                 config.adaptive_rto,
+                                 config.pacing,
+                                 config.mss,
+                                 config.fast_retransmit } } )
+  {}
+
+  TCPSenderTestHarness( std::string name, TCPConfig config, std::unique_ptr<CongestionControl> congestion_control )
+    : TestHarness( move( name ),
+                   "initial_RTO_ms=" + to_string( config.rt_timeout ) + " and ISN=" + to_string( config.isn ),
+                   { TCPSender { ByteStream { config.send_capacity },
+                                 config.isn,
+                                 config.rt_timeout,
+                                 move( congestion_control ),
+                                 config.adaptive_rto,
+                                 config.pacing,
+                                 config.mss,
+                                 config.fast_retransmit } } )
   {}
 
   template<std::derived_from<TestStep<TCPSender>> T>
@@ -97,6 +118,27 @@ struct ExpectSeqnosInFlight : public ExpectNumber<TCPSender, uint64_t>
   uint64_t value( const TCPSender& sender ) const override { return sender.sequence_numbers_in_flight(); }
 };
 
+struct ExpectSeqnosInPipe : public ExpectNumber<TCPSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "sequence_numbers_in_pipe"; }
+  uint64_t value( const TCPSender& sender ) const override { return sender.sequence_numbers_in_pipe(); }
+};
+
+struct ExpectMss : public ExpectNumber<TCPSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "mss"; }
+  uint64_t value( const TCPSender& sender ) const override { return sender.mss(); }
+};
+
+struct ExpectMsUntilNextSend : public ExpectNumber<TCPSender, std::optional<uint64_t>>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "ms_until_next_send"; }
+  std::optional<uint64_t> value( const TCPSender& sender ) const override { return sender.ms_until_next_send(); }
+};
+
 struct ExpectConsecutiveRetransmissions : public ExpectNumber<TCPSender, uint64_t>
 {
   using ExpectNumber::ExpectNumber;
@@ -104,6 +146,41 @@ struct ExpectConsecutiveRetransmissions : public ExpectNumber<TCPSender, uint64_
   uint64_t value( const TCPSender& sender ) const override { return sender.consecutive_retransmissions(); }
 };
 
+struct ExpectCongestionWindow : public ExpectNumber<TCPSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "congestion_control().cwnd"; }
+  uint64_t value( const TCPSender& sender ) const override { return sender.congestion_control().cwnd(); }
+};
+
+struct ExpectFastRecovery : public ExpectBool<TCPSender>
+{
+  using ExpectBool::ExpectBool;
+  std::string name() const override { return "in_fast_recovery"; }
+  bool value( const TCPSender& sender ) const override { return sender.in_fast_recovery(); }
+};
+
+struct ExpectRto : public ExpectNumber<TCPSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "rtt_stats().rto_ms"; }
+  uint64_t value( const TCPSender& sender ) const override { return sender.rtt_stats().rto_ms; }
+};
+
+struct ExpectSmoothedRtt : public ExpectNumber<TCPSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "rtt_stats().smoothed_ms (0 if none)"; }
+  uint64_t value( const TCPSender& sender ) const override { return sender.rtt_stats().smoothed_ms.value_or( 0 ); }
+};
+
+struct ExpectRttSamples : public ExpectNumber<TCPSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "rtt_stats().samples"; }
+  uint64_t value( const TCPSender& sender ) const override { return sender.rtt_stats().samples; }
+};
+
 struct ExpectNoSegment : public Expectation<SenderAndOutput>
 {
   std::string description() const override { return "nothing to send"; }
@@ -222,7 +299,14 @@ struct Receive : public Action<SenderAndOutput>
   std::string description() const override
   {
     std::ostringstream desc;
-    desc << "receive(ack=" << to_string( msg_.ackno ) << ", win=" << msg_.window_size << ")";
+    desc << "receive(ack=" << to_string( msg_.ackno ) << ", win=" << msg_.window_size;
+    for ( const SackBlock& block : msg_.sack() ) {
+      desc << ", sack=" << block.left << "-" << block.right;
+    }
+    if ( msg_.mss.has_value() ) {
+      desc << ", mss=" << *msg_.mss;
+    }
+    desc << ")";
     if ( push_ ) {
       desc << ", then push";
     }
@@ -235,6 +319,18 @@ struct Receive : public Action<SenderAndOutput>
     return *this;
   }
 
+  Receive& with_sack( Wrap32 left, Wrap32 right )
+  {
+    msg_.sack_blocks.at( msg_.sack_block_count++ ) = { left, right };
+    return *this;
+  }
+
+  Receive& with_mss( uint16_t mss )
+  {
+    msg_.mss = mss;
+    return *this;
+  }
+
   void execute( SenderAndOutput& ss ) const override
   {
     ss.sender.receive( msg_ );
@@ -377,10 +473,10 @@ struct ExpectMessage : public Expectation<SenderAndOutput>
 
     const TCPSenderMessage seg = ss.expect_message();
 
-    if ( seg.payload.size() > TCPConfig::MAX_PAYLOAD_SIZE ) {
+    if ( seg.payload.size() > ss.sender.mss() ) {
       throw ExpectationViolation( "sent a message with a " + std::to_string( seg.payload.size() )
                                   + "-byte payload, which is longer than the maximum ("
-                                  + std::to_string( TCPConfig::MAX_PAYLOAD_SIZE ) + ")" );
+                                  + std::to_string( ss.sender.mss() ) + ")" );
     }
     if ( syn.has_value() and seg.SYN != syn.value() ) {
       throw MessageExpectationViolation( seg, "SYN flag", syn.value(), seg.SYN );
@@ -404,3 +500,53 @@ struct ExpectMessage : public Expectation<SenderAndOutput>
 
   constexpr std::string obj() const override { return "TCPSender"; }
 };
+
+// Helpers for the tests of what TCPSender does beyond the lab's: full-size segments, and a
+// receiver window big enough to leave the congestion window (or pacing) in charge.
+constexpr uint64_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+constexpr uint16_t BIG_WINDOW = 60000;
+
+// Start of the i-th full segment after the SYN.
+inline Wrap32 segment( Wrap32 isn, uint64_t i )
+{
+  return isn + 1 + i * MSS;
+}
+
+// Expect the i-th full segment after the SYN.
+inline void expect_segment( TCPSenderTestHarness& test, Wrap32 isn, uint64_t i )
+{
+  test.execute( ExpectMessage {}.with_no_flags().with_payload_size( MSS ).with_seqno( segment( isn, i ) ) );
+}
+
+// Send the SYN and have it acknowledged with a BIG_WINDOW, and with `peer_mss` as an MSS option if set.
+inline void connect_sender( TCPSenderTestHarness& test, Wrap32 isn, std::optional<uint16_t> peer_mss = {} )
+{
+  test.execute( Push {} );
+  test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+  AckReceived ack { isn + 1 };
+  ack.with_win( BIG_WINDOW );
+  if ( peer_mss.has_value() ) {
+    ack.with_mss( *peer_mss );
+  }
+  test.execute( ack );
+  test.execute( ExpectNoSegment {} );
+}
+
+// Connect, then send ten full segments (all the initial window of NewReno allows).
+inline void send_ten_segments( TCPSenderTestHarness& test, Wrap32 isn )
+{
+  connect_sender( test, isn );
+  test.execute( Push { std::string( 10 * MSS, 'x' ) } );
+  for ( uint64_t i = 0; i < 10; ++i ) {
+    expect_segment( test, isn, i );
+  }
+  test.execute( ExpectNoSegment {} );
+}
+
+// `count` ACKs of `ackno` with a BIG_WINDOW: duplicates, if data is outstanding.
+inline void duplicate_acks( TCPSenderTestHarness& test, Wrap32 ackno, int count )
+{
+  for ( int i = 0; i < count; ++i ) {
+    test.execute( AckReceived { ackno }.with_win( BIG_WINDOW ) );
+  }
+}
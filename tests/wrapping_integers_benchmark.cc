@@ -0,0 +1,166 @@
+#include "wrapping_integers.hh"
+
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+class RawWrap32 : public Wrap32
+{
+public:
+  explicit RawWrap32( Wrap32 w ) : Wrap32( w ) {}
+  uint32_t raw_value() const { return raw_value_; }
+};
+
+// The previous unwrap(): build the candidate sharing the checkpoint's upper 32 bits,
+// then check its +/-2^32 neighbours and keep whichever is nearest.
+uint64_t reference_unwrap( Wrap32 seqno, Wrap32 zero_point, uint64_t checkpoint )
+{
+  constexpr uint64_t round = 1ULL << 32;
+
+  const uint32_t offset = RawWrap32 { seqno }.raw_value() - RawWrap32 { zero_point }.raw_value();
+  const uint64_t candidate = ( checkpoint & ~static_cast<uint64_t>( UINT32_MAX ) ) | offset;
+
+  auto distance = [checkpoint]( uint64_t v ) { return v > checkpoint ? v - checkpoint : checkpoint - v; };
+
+  uint64_t best = candidate;
+  uint64_t best_dist = distance( candidate );
+  if ( candidate >= round ) {
+    const uint64_t prev = candidate - round;
+    if ( distance( prev ) < best_dist ) {
+      best = prev;
+      best_dist = distance( prev );
+    }
+  }
+  const uint64_t next = candidate + round;
+  if ( distance( next ) < best_dist ) {
+    best = next;
+  }
+  return best;
+}
+
+// Checkpoints that exercise the underflow and tie rules, plus ordinary ones.
+vector<uint64_t> checkpoints( default_random_engine& rd )
+{
+  vector<uint64_t> ret { 0, 1, ( 1UL << 31 ) - 1, 1UL << 31, 1UL << 32, ( 1UL << 32 ) + ( 1UL << 31 ), 3UL << 40 };
+  uniform_int_distribution<uint64_t> any { 0, 1UL << 48 };
+  for ( int i = 0; i < 16; ++i ) {
+    ret.push_back( any( rd ) );
+  }
+  return ret;
+}
+
+// Seqnos spread over the whole 32-bit space, including the ones exactly 2^31 away.
+vector<Wrap32> seqnos_near( uint64_t checkpoint, Wrap32 zero_point, size_t count, default_random_engine& rd )
+{
+  uniform_int_distribution<uint32_t> any;
+  vector<Wrap32> ret;
+  ret.reserve( count );
+  ret.push_back( Wrap32::wrap( checkpoint + ( 1UL << 31 ), zero_point ) );
+  ret.push_back( Wrap32::wrap( checkpoint, zero_point ) );
+  while ( ret.size() < count ) {
+    ret.push_back( Wrap32 { any( rd ) } );
+  }
+  return ret;
+}
+
+void check_agreement( default_random_engine& rd )
+{
+  for ( const uint32_t isn : { 0U, 1U, 1U << 31, UINT32_MAX } ) {
+    const Wrap32 zero_point { isn };
+    for ( const uint64_t checkpoint : checkpoints( rd ) ) {
+      const vector<Wrap32> seqnos = seqnos_near( checkpoint, zero_point, 4099, rd );
+      vector<uint64_t> batch( seqnos.size() );
+      Wrap32::unwrap_many( seqnos, zero_point, checkpoint, batch );
+      for ( size_t i = 0; i < seqnos.size(); ++i ) {
+        const uint64_t expected = reference_unwrap( seqnos[i], zero_point, checkpoint );
+        const uint64_t scalar = seqnos[i].unwrap( zero_point, checkpoint );
+        if ( scalar != expected or batch[i] != expected ) {
+          throw runtime_error( "unwrap of " + to_string( RawWrap32 { seqnos[i] }.raw_value() ) + " with isn "
+                               + to_string( isn ) + ", checkpoint " + to_string( checkpoint ) + " gave "
+                               + to_string( scalar ) + " (scalar) and " + to_string( batch[i] )
+                               + " (batch), expected " + to_string( expected ) );
+        }
+      }
+    }
+  }
+}
+
+template<class F>
+double ns_per_seqno( size_t count, size_t repeat, F&& body )
+{
+  const auto start = steady_clock::now();
+  for ( size_t r = 0; r < repeat; ++r ) {
+    body();
+  }
+  const auto elapsed = duration_cast<duration<double>>( steady_clock::now() - start );
+  return 1e9 * elapsed.count() / static_cast<double>( count * repeat );
+}
+
+void program_body()
+{
+  default_random_engine rd { 16 };
+  check_agreement( rd );
+
+  constexpr size_t count = 1 << 16;
+  constexpr size_t repeat = 200;
+  // Drawn at run time, so the per-seqno loops cannot specialize on a constant checkpoint.
+  const Wrap32 zero_point { uniform_int_distribution<uint32_t> {}( rd ) };
+  const uint64_t checkpoint = uniform_int_distribution<uint64_t> { 1UL << 32, 1UL << 40 }( rd );
+  const vector<Wrap32> seqnos = seqnos_near( checkpoint, zero_point, count, rd );
+  vector<uint64_t> out( count );
+
+  // Every variant writes into `out`, which is folded into a checksum so no loop can be dropped.
+  uint64_t checksum = 0;
+  const double reference = ns_per_seqno( count, repeat, [&] {
+    for ( size_t i = 0; i < count; ++i ) {
+      out[i] = reference_unwrap( seqnos[i], zero_point, checkpoint );
+    }
+    checksum += out[count / 2];
+  } );
+  const double scalar = ns_per_seqno( count, repeat, [&] {
+    for ( size_t i = 0; i < count; ++i ) {
+      out[i] = seqnos[i].unwrap( zero_point, checkpoint );
+    }
+    checksum += out[count / 2];
+  } );
+  const double batch = ns_per_seqno( count, repeat, [&] {
+    Wrap32::unwrap_many( seqnos, zero_point, checkpoint, out );
+    checksum += out[count / 2];
+  } );
+
+  cout << "Wrap32 unwrap over " << count << " seqnos (checksum " << checksum << "):\n"
+       << fixed << setprecision( 3 ) << "  reference (branching) " << reference << " ns/seqno\n"
+       << "  unwrap (branchless)   " << scalar << " ns/seqno\n"
+       << "  unwrap_many           " << batch << " ns/seqno\n";
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+  debug_output << "        Wrap32 unwrap: reference " << fixed << setprecision( 2 ) << reference << " ns, scalar "
+               << scalar << " ns, unwrap_many " << batch << " ns per seqno\n";
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,55 @@
+#include "cycle_counter.hh"
+#include "exception.hh"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+CycleCounter::CycleCounter()
+{
+#ifdef __linux__
+  perf_event_attr attr {};
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.size = sizeof( attr );
+  attr.config = PERF_COUNT_HW_CPU_CYCLES;
+  attr.disabled = 1;
+  attr.exclude_kernel = 1; // permitted at perf_event_paranoid <= 2
+  attr.exclude_hv = 1;
+
+  // this thread, any CPU, no group
+  const long fd = syscall( SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC );
+  if ( fd >= 0 ) {
+    fd_.emplace( static_cast<int>( fd ) );
+  }
+#endif
+}
+
+void CycleCounter::start()
+{
+#ifdef __linux__
+  if ( fd_ ) {
+    CheckSystemCall( "ioctl(PERF_EVENT_IOC_RESET)", ioctl( fd_->fd_num(), PERF_EVENT_IOC_RESET, 0 ) );
+    CheckSystemCall( "ioctl(PERF_EVENT_IOC_ENABLE)", ioctl( fd_->fd_num(), PERF_EVENT_IOC_ENABLE, 0 ) );
+  }
+#endif
+}
+
+optional<uint64_t> CycleCounter::stop()
+{
+#ifdef __linux__
+  if ( fd_ ) {
+    CheckSystemCall( "ioctl(PERF_EVENT_IOC_DISABLE)", ioctl( fd_->fd_num(), PERF_EVENT_IOC_DISABLE, 0 ) );
+    uint64_t cycles = 0;
+    if ( ::read( fd_->fd_num(), &cycles, sizeof( cycles ) ) != sizeof( cycles ) ) {
+      throw unix_error { "read(perf_event)" };
+    }
+    return cycles;
+  }
+#endif
+  return {};
+}
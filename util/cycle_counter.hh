@@ -0,0 +1,28 @@
+#pragma once
+
+#include "file_descriptor.hh"
+
+#include <cstdint>
+#include <optional>
+
+//! Counts CPU cycles spent by the calling thread, using a
+//! [perf_event_open(2)](\ref man2::perf_event_open) hardware counter where the kernel allows it.
+//!
+//! Construction never fails: if the counter cannot be opened (non-Linux, no PMU in a VM,
+//! or perf_event_paranoid forbids it), available() is false and stop() returns nothing.
+class CycleCounter
+{
+public:
+  CycleCounter();
+
+  bool available() const { return fd_.has_value(); }
+
+  //! Reset the count to zero and start counting
+  void start();
+
+  //! Stop counting and return the cycles since start(), if the counter is available
+  std::optional<uint64_t> stop();
+
+private:
+  std::optional<FileDescriptor> fd_ {};
+};
@@ -78,6 +78,20 @@ EpollEventLoop::RuleHandle EpollEventLoop::add_rule( size_t category_id,
   return RuleHandle { _fd_rules.back() };
 }
 
+EpollEventLoop::RuleHandle EpollEventLoop::add_armed_rule( size_t category_id,
+                                                          FileDescriptor& fd,
+                                                          Direction direction,
+                                                          const CallbackT& callback,
+                                                          bool armed,
+                                                          const CallbackT& cancel,
+                                                          const CallbackT& error )
+{
+  RuleHandle handle = add_rule( category_id, fd, direction, callback, {}, cancel, error );
+  _fd_rules.back()->armed_explicitly = true;
+  _fd_rules.back()->armed = armed;
+  return handle;
+}
+
 EpollEventLoop::RuleHandle EpollEventLoop::add_rule( const size_t category_id,
                                                     const CallbackT& callback,
                                                     const InterestT& interest )
@@ -97,20 +111,28 @@ void EpollEventLoop::RuleHandle::cancel()
   }
 }
 
-uint32_t EpollEventLoop::desired_events_for_fd( int fd_num ) const
+void EpollEventLoop::RuleHandle::set_armed( bool armed )
+{
+  const shared_ptr<BasicRule> rule_shared_ptr = rule_weak_ptr_.lock();
+  if ( rule_shared_ptr ) {
+    rule_shared_ptr->armed = armed;
+  }
+}
+
+void EpollEventLoop::compute_desired_events()
 {
-  uint32_t mask = 0;
+  for ( auto& [_, state] : _fd_states ) {
+    state.desired_events = 0;
+    state.has_rule = false;
+  }
   for ( const auto& rule_ptr : _fd_rules ) {
     const auto& rule = *rule_ptr;
-    if ( rule.cancel_requested || rule.fd.fd_num() != fd_num ) {
-      continue;
-    }
-    if ( !rule.interest() ) {
-      continue;
+    auto& state = _fd_states[rule.fd.fd_num()];
+    state.has_rule = true;
+    if ( !rule.cancel_requested && rule.interested() ) {
+      state.desired_events |= ( rule.direction == Direction::In ? EPOLLIN : EPOLLOUT );
     }
-    mask |= ( rule.direction == Direction::In ? EPOLLIN : EPOLLOUT );
   }
-  return mask;
 }
 
 void EpollEventLoop::sync_fd_registration( int fd_num, uint32_t desired )
@@ -202,17 +224,11 @@ EpollEventLoop::Result EpollEventLoop::wait_next_event( const int timeout_ms )
 
   // Recompute and push registrations. Also tear down state for fds that
   // no longer have any rule.
+  compute_desired_events();
   for ( auto state_it = _fd_states.begin(); state_it != _fd_states.end(); ) {
     const int fd_num = state_it->first;
-    bool any_rule = false;
-    for ( const auto& rule_ptr : _fd_rules ) {
-      if ( rule_ptr->fd.fd_num() == fd_num ) {
-        any_rule = true;
-        break;
-      }
-    }
 
-    if ( !any_rule ) {
+    if ( !state_it->second.has_rule ) {
       if ( state_it->second.in_epoll ) {
         // Best-effort DEL; the fd may already be closed (EBADF) which is fine.
         ::epoll_ctl( _epoll_fd.fd_num(), EPOLL_CTL_DEL, fd_num, nullptr );
@@ -221,7 +237,7 @@ EpollEventLoop::Result EpollEventLoop::wait_next_event( const int timeout_ms )
       continue;
     }
 
-    sync_fd_registration( fd_num, desired_events_for_fd( fd_num ) );
+    sync_fd_registration( fd_num, state_it->second.desired_events );
     ++state_it;
   }
 
@@ -257,11 +273,10 @@ EpollEventLoop::Result EpollEventLoop::wait_next_event( const int timeout_ms )
     return Result::Timeout;
   }
 
-  // 4. Dispatch. First pass: handle errors / hangups for ALL ready fds so
-  //    we drop dead rules even if an earlier rule's callback returns first.
-  //    Track which fd we'll dispatch a callback for.
-  int callback_fd = -1;
-  uint32_t callback_revents = 0;
+  // 4. Dispatch. First pass: handle errors for ALL ready fds so we drop dead
+  //    rules even if an earlier rule's callback returns first. Keep the
+  //    remaining events as candidates for a callback.
+  int num_candidates = 0;
 
   for ( int i = 0; i < n; ++i ) {
     const auto& ev = events[i];
@@ -312,53 +327,65 @@ EpollEventLoop::Result EpollEventLoop::wait_next_event( const int timeout_ms )
       continue;
     }
 
-    if ( callback_fd == -1 ) {
-      callback_fd = fd_num;
-      callback_revents = revents;
-    }
+    events[num_candidates++] = ev;
   }
 
-  if ( callback_fd == -1 ) {
-    return Result::Success;
-  }
+  // 5. Find the first live rule on the first returned fd whose direction matches a
+  //    bit in revents and which is still interested. EPOLLHUP arrives even for fds
+  //    registered with an empty mask, so an In rule that is not interested (or a
+  //    disarmed one) is not treated as defunct on a hangup. An fd used only by armed rules
+  //    that could not be served, or one that only hung up, passes the turn to the next
+  //    returned fd.
+  for ( int i = 0; i < num_candidates; ++i ) {
+    const int fd_num = events[i].data.fd;
+    const uint32_t revents = events[i].events;
+    const bool readable = ( revents & EPOLLIN ) != 0;
+    const bool writable = ( revents & EPOLLOUT ) != 0;
+    const bool hup = ( revents & EPOLLHUP ) != 0;
+    bool seen_armed = false;
+    bool seen_plain = false;
+
+    for ( auto it = _fd_rules.begin(); it != _fd_rules.end(); ) {
+      auto& this_rule = **it;
+      if ( this_rule.fd.fd_num() != fd_num ) {
+        ++it;
+        continue;
+      }
+      ( this_rule.armed_explicitly ? seen_armed : seen_plain ) = true;
+
+      const bool dir_in = this_rule.direction == Direction::In;
+      const bool ready = ( dir_in && readable ) || ( !dir_in && writable );
+
+      // Mirror EventLoop's defunct-fd treatment: pure HUP with nothing to read,
+      // or HUP on an Out direction, means the fd will never make progress. An In
+      // rule that did not ask for EPOLLIN may still have bytes left to read.
+      if ( hup && ( ( !ready && dir_in && this_rule.interested() ) || !dir_in ) ) {
+        this_rule.cancel();
+        it = _fd_rules.erase( it );
+        continue;
+      }
 
-  // 5. Find the first live rule on callback_fd whose direction matches a
-  //    bit in revents and which is still interested.
-  const bool readable = ( callback_revents & EPOLLIN ) != 0;
-  const bool writable = ( callback_revents & EPOLLOUT ) != 0;
-  const bool hup = ( callback_revents & EPOLLHUP ) != 0;
+      if ( ready && this_rule.interested() ) {
+        const auto count_before = this_rule.service_count();
+        this_rule.callback();
 
-  for ( auto it = _fd_rules.begin(); it != _fd_rules.end(); ) {
-    auto& this_rule = **it;
-    if ( this_rule.fd.fd_num() != callback_fd ) {
-      ++it;
-      continue;
-    }
-
-    const bool dir_in = this_rule.direction == Direction::In;
-    const bool ready = ( dir_in && readable ) || ( !dir_in && writable );
+        if ( count_before == this_rule.service_count() && !this_rule.fd.closed() && this_rule.interested() ) {
+          throw runtime_error( "EpollEventLoop: busy wait detected: rule \""
+                               + _rule_categories.at( this_rule.category_id ).name
+                               + "\" did not read/write fd and is still interested" );
+        }
+        return Result::Success;
+      }
 
-    // Mirror EventLoop's defunct-fd treatment: pure HUP with nothing to read,
-    // or HUP on an Out direction, means the fd will never make progress.
-    if ( hup && ( ( !ready && dir_in ) || !dir_in ) ) {
-      this_rule.cancel();
-      it = _fd_rules.erase( it );
-      continue;
+      ++it;
     }
 
-    if ( ready && this_rule.interest() ) {
-      const auto count_before = this_rule.service_count();
-      this_rule.callback();
-
-      if ( count_before == this_rule.service_count() && !this_rule.fd.closed() && this_rule.interest() ) {
-        throw runtime_error( "EpollEventLoop: busy wait detected: rule \""
-                             + _rule_categories.at( this_rule.category_id ).name
-                             + "\" did not read/write fd and is still interested" );
-      }
-      return Result::Success;
+    // A bare hangup that no rule could act on passes the turn too, as EventLoop moves on
+    // past a pollfd whose rule did not ask for anything.
+    const bool hangup_only = hup and not readable and not writable;
+    if ( ( seen_plain or not seen_armed ) and not hangup_only ) {
+      break;
     }
-
-    ++it;
   }
 
   return Result::Success;
@@ -39,8 +39,12 @@ private:
     InterestT interest;
     CallbackT callback;
     bool cancel_requested {};
+    bool armed_explicitly {}; //!< interest is `armed`, set through RuleHandle::set_armed(), not interest()
+    bool armed {};
 
     BasicRule( size_t s_category_id, InterestT s_interest, CallbackT s_callback );
+
+    bool interested() const { return armed_explicitly ? armed : interest(); }
   };
 
   struct FDRule : public BasicRule
@@ -62,6 +66,8 @@ private:
   {
     uint32_t registered_events { 0 }; //!< the mask currently installed in the kernel
     bool in_epoll { false };          //!< whether EPOLL_CTL_ADD has been issued
+    uint32_t desired_events { 0 };    //!< scratch: OR of interested rules, rebuilt each iteration
+    bool has_rule { false };          //!< scratch: whether any live rule still uses this fd
   };
 
   std::vector<RuleCategory> _rule_categories {};
@@ -71,8 +77,8 @@ private:
   FileDescriptor _epoll_fd;                    //!< owns the epoll instance
   std::unordered_map<int, FdState> _fd_states; //!< keyed by fd_num
 
-  // Compute the desired epoll event mask for fd_num across all live rules.
-  uint32_t desired_events_for_fd( int fd_num ) const;
+  // Rebuild every FdState's desired mask in one pass over the live rules.
+  void compute_desired_events();
 
   // Push the desired mask into the kernel via EPOLL_CTL_ADD/MOD/DEL.
   void sync_fd_registration( int fd_num, uint32_t desired );
@@ -99,6 +105,9 @@ public:
     {}
 
     void cancel();
+
+    //! For rules from add_armed_rule(): turn the rule's interest on or off
+    void set_armed( bool armed );
   };
 
   RuleHandle add_rule(
@@ -113,6 +122,18 @@ public:
   RuleHandle
   add_rule( size_t category_id, const CallbackT& callback, const InterestT& interest = [] { return true; } );
 
+  //! Like add_rule(), but with no interest() predicate to re-evaluate every iteration: the rule
+  //! is interested exactly while armed, and the caller flips that on edges through
+  //! RuleHandle::set_armed() (e.g. from ByteStream::on_readable_change()).
+  RuleHandle add_armed_rule(
+    size_t category_id,
+    FileDescriptor& fd,
+    Direction direction,
+    const CallbackT& callback,
+    bool armed,
+    const CallbackT& cancel = [] {},
+    const CallbackT& error = [] {} );
+
   Result wait_next_event( int timeout_ms );
 
   template<typename... Targs>
@@ -120,6 +141,12 @@ public:
   {
     return add_rule( add_category( name ), std::forward<Targs>( Fargs )... );
   }
+
+  template<typename... Targs>
+  auto add_armed_rule( const std::string& name, Targs&&... Fargs )
+  {
+    return add_armed_rule( add_category( name ), std::forward<Targs>( Fargs )... );
+  }
 };
 
 #endif // __linux__
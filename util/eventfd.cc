@@ -0,0 +1,34 @@
+#ifdef __linux__
+
+#include "eventfd.hh"
+#include "exception.hh"
+
+#include <cerrno>
+#include <cstdint>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+EventFD::EventFD() : FileDescriptor( ::CheckSystemCall( "eventfd", eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC ) ) ) {}
+
+void EventFD::notify()
+{
+  // Deliberately bypasses FileDescriptor::write(): the notifier usually runs on a
+  // different thread, and the read/write counters are not synchronized.
+  const uint64_t one = 1;
+  if ( ::write( fd_num(), &one, sizeof( one ) ) < 0 and errno != EAGAIN ) {
+    throw unix_error { "write(eventfd)" };
+  }
+}
+
+bool EventFD::clear()
+{
+  uint64_t count = 0;
+  const ssize_t bytes_read = ::read( fd_num(), &count, sizeof( count ) );
+  if ( bytes_read < 0 and errno != EAGAIN ) {
+    throw unix_error { "read(eventfd)" };
+  }
+  register_read();
+  return bytes_read > 0 and count > 0;
+}
+
+#endif // __linux__
@@ -0,0 +1,23 @@
+#pragma once
+
+#ifdef __linux__
+
+#include "file_descriptor.hh"
+
+//! A non-blocking [eventfd(2)](\ref man2::eventfd) counter, used to wake an event loop from another thread.
+//!
+//! notify() may be called from any thread; clear() belongs to the thread whose event loop
+//! watches the fd, and counts as a read for EventLoop/EpollEventLoop busy-wait detection.
+class EventFD : public FileDescriptor
+{
+public:
+  EventFD();
+
+  //! Make the fd readable (until the next clear())
+  void notify();
+
+  //! Consume any pending notifications; returns true if there were some
+  bool clear();
+};
+
+#endif // __linux__
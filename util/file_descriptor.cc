@@ -5,6 +5,7 @@
 #include <fcntl.h>
 #include <iostream>
 #include <stdexcept>
+#include <sys/socket.h>
 #include <sys/types.h>
 #include <sys/uio.h>
 #include <unistd.h>
@@ -106,6 +107,33 @@ void FileDescriptor::read( string& buffer )
   buffer.resize( bytes_read );
 }
 
+size_t FileDescriptor::read( span<char> buffer )
+{
+  if ( buffer.empty() ) {
+    return 0;
+  }
+
+  const ssize_t bytes_read = ::read( fd_num(), buffer.data(), buffer.size() );
+  if ( bytes_read < 0 ) {
+    if ( internal_fd_->non_blocking_ and ( errno == EAGAIN or errno == EINPROGRESS ) ) {
+      return 0;
+    }
+    throw unix_error { "read" };
+  }
+
+  register_read();
+
+  if ( bytes_read == 0 ) {
+    internal_fd_->eof_ = true;
+  }
+
+  if ( bytes_read > static_cast<ssize_t>( buffer.size() ) ) {
+    throw runtime_error( "read() read more than requested" );
+  }
+
+  return bytes_read;
+}
+
 void FileDescriptor::read( vector<string>& buffers )
 {
   if ( buffers.empty() ) {
@@ -189,6 +217,31 @@ size_t FileDescriptor::write( const vector<string_view>& buffers )
   return bytes_written;
 }
 
+size_t FileDescriptor::write_datagrams( const vector<vector<string_view>>& datagrams )
+{
+  vector<iovec> iovecs;
+  for ( const auto& buffers : datagrams ) {
+    for ( const auto x : buffers ) {
+      iovecs.push_back( { const_cast<char*>( x.data() ), x.size() } ); // NOLINT(*-const-cast)
+    }
+  }
+
+  // Each message's iovecs are a run of `iovecs`, which is complete by now and so won't move.
+  vector<mmsghdr> messages( datagrams.size() );
+  size_t next_iovec = 0;
+  for ( size_t i = 0; i < datagrams.size(); ++i ) {
+    messages[i].msg_hdr.msg_iov = iovecs.data() + next_iovec;
+    messages[i].msg_hdr.msg_iovlen = datagrams[i].size();
+    next_iovec += datagrams[i].size();
+  }
+
+  const int messages_written = CheckSystemCall(
+    "sendmmsg", ::sendmmsg( fd_num(), messages.data(), static_cast<unsigned int>( messages.size() ), 0 ) );
+  register_write();
+
+  return messages_written;
+}
+
 void FileDescriptor::set_blocking( bool blocking )
 {
   int flags = CheckSystemCall( "fcntl", fcntl( fd_num(), F_GETFL ) ); // NOLINT(*-vararg)
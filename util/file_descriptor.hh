@@ -3,6 +3,7 @@
 #include "ref.hh"
 #include <cstddef>
 #include <memory>
+#include <span>
 #include <vector>
 
 // A reference-counted handle to a file descriptor
@@ -69,12 +70,19 @@ public:
   void read( std::string& buffer );
   void read( std::vector<std::string>& buffers );
 
+  // Read into caller-owned memory; returns bytes read (0 at EOF or on EAGAIN)
+  size_t read( std::span<char> buffer );
+
   // Attempt to write a buffer
   // returns number of bytes written
   size_t write( std::string_view buffer );
   size_t write( const std::vector<std::string_view>& buffers );
   size_t write( const std::vector<Ref<std::string>>& buffers );
 
+  // Attempt to write each entry of `datagrams` as a message of its own, in one sendmmsg(2)
+  // (the fd must be a connected datagram socket); returns the number of messages written
+  size_t write_datagrams( const std::vector<std::vector<std::string_view>>& datagrams );
+
   // Close the underlying file descriptor
   void close() { internal_fd_->close(); }
 
@@ -7,6 +7,7 @@
 
 #include <optional>
 #include <random>
+#include <span>
 #include <utility>
 
 //! An adapter class that adds random dropping behavior to an FD adapter
@@ -59,6 +60,25 @@ public:
     return _adapter.write( seg );
   }
 
+  //! \brief Write a train of segments, dropping each one as write() would
+  //! \details The survivors go to the underlying AdapterT's write_batch() in runs, so a train with
+  //!          no losses is passed on whole
+  void write_batch( std::span<const TCPMessage> segs )
+  {
+    size_t run_start = 0;
+    for ( size_t i = 0; i < segs.size(); ++i ) {
+      if ( _should_drop( true ) ) {
+        if ( i > run_start ) {
+          _adapter.write_batch( segs.subspan( run_start, i - run_start ) );
+        }
+        run_start = i + 1;
+      }
+    }
+    if ( segs.size() > run_start ) {
+      _adapter.write_batch( segs.subspan( run_start ) );
+    }
+  }
+
   //! \name
   //! Passthrough functions to the underlying AdapterT instance
 
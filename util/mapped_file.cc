@@ -0,0 +1,39 @@
+#include "mapped_file.hh"
+
+#include "exception.hh"
+#include "file_descriptor.hh"
+
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+MappedFile::MappedFile( const string& path )
+{
+  const FileDescriptor file { CheckSystemCall( "open " + path, open( path.c_str(), O_RDONLY | O_CLOEXEC ) ) };
+
+  struct stat st
+  {};
+  CheckSystemCall( "fstat", fstat( file.fd_num(), &st ) );
+  if ( st.st_size == 0 ) {
+    return; // mmap(2) rejects zero-length mappings; an empty view is all we need
+  }
+
+  void* const addr = mmap( nullptr, st.st_size, PROT_READ, MAP_PRIVATE, file.fd_num(), 0 );
+  if ( addr == MAP_FAILED ) {
+    throw unix_error { "mmap " + path };
+  }
+  madvise( addr, st.st_size, MADV_SEQUENTIAL ); // advisory only; failure is harmless
+
+  data_ = static_cast<const char*>( addr );
+  size_ = st.st_size;
+}
+
+MappedFile::~MappedFile()
+{
+  if ( data_ and munmap( const_cast<char*>( data_ ), size_ ) < 0 ) { // NOLINT(*-const-cast)
+    cerr << "Exception destructing MappedFile: " << unix_error { "munmap" }.what() << "\n";
+  }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+//! A read-only, private [mmap(2)](\ref man2::mmap) of an entire file.
+//!
+//! Hand one out as a std::shared_ptr so that borrowed views (e.g. ByteStream's
+//! SharedSlice segments) keep the pages mapped for as long as they are in use.
+class MappedFile
+{
+public:
+  //! Map the whole of the file at `path`
+  explicit MappedFile( const std::string& path );
+
+  //! Unmap the file
+  ~MappedFile();
+
+  //! The file's contents
+  std::string_view view() const { return { data_, size_ }; }
+
+  //! A MappedFile cannot be copied or moved
+  MappedFile( const MappedFile& other ) = delete;
+  MappedFile& operator=( const MappedFile& other ) = delete;
+  MappedFile( MappedFile&& other ) = delete;
+  MappedFile& operator=( MappedFile&& other ) = delete;
+
+private:
+  const char* data_ {};
+  size_t size_ {};
+};
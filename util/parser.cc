@@ -74,7 +74,10 @@ void Parser::BufferList::dump_all( vector<Ref<std::string>>& out )
     return;
   }
   if ( skip_ ) {
-    out.emplace_back( buffer_.front()->substr( skip_ ) );
+    // Drop the consumed prefix in place, keeping the buffer's allocation for the caller.
+    std::string front = buffer_.front().release();
+    front.erase( 0, skip_ );
+    out.emplace_back( std::move( front ) );
   } else {
     out.push_back( move( buffer_.front() ) );
   }
@@ -161,8 +164,38 @@ void Serializer::buffer( const vector<Ref<string>>& bufs )
   }
 }
 
+void Serializer::buffer( SharedSlice slice )
+{
+  if ( not slice.bytes.empty() ) {
+    flush();
+    output_.emplace_back( move( slice ) );
+  }
+}
+
 vector<Ref<string>> Serializer::finish()
 {
   flush();
-  return move( output_ );
+  vector<Ref<string>> ret;
+  ret.reserve( output_.size() );
+  for ( auto& x : output_ ) {
+    if ( auto* buf = get_if<Ref<string>>( &x ) ) {
+      ret.push_back( move( *buf ) );
+    } else {
+      ret.emplace_back( string { get<SharedSlice>( x ).bytes } );
+    }
+  }
+  output_.clear();
+  return ret;
+}
+
+vector<string_view> Serializer::views()
+{
+  flush();
+  vector<string_view> ret;
+  ret.reserve( output_.size() );
+  for ( const auto& x : output_ ) {
+    const auto* buf = get_if<Ref<string>>( &x );
+    ret.push_back( buf ? string_view { buf->get() } : get<SharedSlice>( x ).bytes );
+  }
+  return ret;
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ref.hh"
+#include "shared_slice.hh"
 
 #include <concepts>
 #include <cstdint>
@@ -10,6 +11,7 @@
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <variant>
 #include <vector>
 
 class Parser
@@ -94,7 +96,7 @@ public:
 
 class Serializer
 {
-  std::vector<Ref<std::string>> output_ {};
+  std::vector<std::variant<Ref<std::string>, SharedSlice>> output_ {};
   std::string buffer_ {};
 
   void flush();
@@ -114,5 +116,13 @@ public:
   void buffer( std::string buf );
   void buffer( Ref<std::string> buf );
   void buffer( const std::vector<Ref<std::string>>& bufs );
+
+  // Append a slice's bytes without copying them; the Serializer holds the slice's owner. A slice
+  // with no owner borrows its bytes, which must outlive the Serializer's use of them.
+  void buffer( SharedSlice slice );
+
+  // Everything serialized so far. finish() copies any SharedSlice into a string of its own;
+  // views() copies nothing, and stays valid until the Serializer is modified or destroyed.
   std::vector<Ref<std::string>> finish();
+  std::vector<std::string_view> views();
 };
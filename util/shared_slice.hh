@@ -0,0 +1,12 @@
+#pragma once
+
+#include <memory>
+#include <string_view>
+
+// A read-only run of bytes that is borrowed instead of copied; `owner` keeps the
+// storage behind `bytes` alive (e.g. a std::shared_ptr<MappedFile>).
+struct SharedSlice
+{
+  std::shared_ptr<const void> owner {};
+  std::string_view bytes {};
+};
@@ -1,17 +1,20 @@
 #pragma once
 
 #include "address.hh"
+#include "reassembler.hh"
+#include "tcp_tuning.hh"
 #include "wrapping_integers.hh"
 
 #include <cstddef>
 #include <cstdint>
+#include <optional>
 
 //! Config for TCP sender and receiver
 class TCPConfig
 {
 public:
   static constexpr size_t DEFAULT_CAPACITY = 64000; //!< Default capacity
-  static constexpr size_t MAX_PAYLOAD_SIZE = 1000;  //!< Conservative max payload size for real Internet
+  static constexpr size_t MAX_PAYLOAD_SIZE = 1000;  //!< Default MSS, conservative for the real Internet
   static constexpr uint16_t TIMEOUT_DFLT = 1000;    //!< Default re-transmit timeout is 1 second
   static constexpr unsigned MAX_RETX_ATTEMPTS = 8;  //!< Maximum re-transmit attempts before giving up
 
@@ -19,6 +22,13 @@ public:
   size_t recv_capacity = DEFAULT_CAPACITY; //!< Receive capacity, in bytes
   size_t send_capacity = DEFAULT_CAPACITY; //!< Sender capacity, in bytes
   Wrap32 isn { 137 };                      //!< Default initial sequence number
+  CongestionControlAlgorithm congestion_control = CongestionControlAlgorithm::NewReno; //!< Sender's controller
+  std::optional<RtoLimits> adaptive_rto {}; //!< If set, the RTO follows measured RTTs; else it stays at rt_timeout
+  std::optional<PacingConfig> pacing {};    //!< If set, segments are released at a rate rather than in bursts
+  size_t mss = MAX_PAYLOAD_SIZE;            //!< Most payload per segment; the peer's MSS option may lower it
+  bool fast_retransmit = false;             //!< Resend on duplicate ACKs or SACKed holes, before the RTO
+  Reassembler::Tracking reassembler_tracking = Reassembler::Tracking::Bitmap; //!< Receiver's pending bytes
+  ByteStream::Storage send_storage = ByteStream::Storage::MirroredRing; //!< Segmented borrows pushed SharedSlices
 };
 
 //! Config for classes derived from FdAdapter
@@ -2,6 +2,7 @@
 
 #include "eventloop.hh"
 #include "file_descriptor.hh"
+#include "mapped_file.hh"
 #include "socket.hh"
 #include "tcp_config.hh"
 #include "tcp_peer.hh"
@@ -9,6 +10,7 @@
 
 #include <atomic>
 #include <cstdint>
+#include <memory>
 #include <optional>
 #include <thread>
 
@@ -38,6 +40,11 @@ public:
   //! Listen and accept using the specified configurations; blocks until accept succeeds or fails
   void listen_and_accept( const TCPConfig& c_tcp, const FdAdapterConfig& c_ad );
 
+  //! Make `file` the whole outbound stream, closed at its end, in place of bytes written to this socket.
+  //! The TCP thread lends slices of the mapping to TCPSender, so each payload byte is first copied when
+  //! its datagram is written out. Call before connect() or listen_and_accept().
+  void send_file( std::shared_ptr<const MappedFile> file );
+
   //! When a connected socket is destructed, it will send a RST
   ~TCPMinnowSocket();
 
@@ -74,6 +81,12 @@ private:
   //! Set up the TCPPeer and the event loop
   void _initialize_TCP( const TCPConfig& config );
 
+  //! Close the TCPPeer's outbound stream once its source is exhausted
+  void _close_outbound();
+
+  //! If set, the source of the outbound stream (see send_file())
+  std::shared_ptr<const MappedFile> _outbound_file {};
+
   //! TCP state machine
   std::optional<TCPPeer> _tcp {};
 
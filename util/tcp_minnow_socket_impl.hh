@@ -2,6 +2,7 @@
 
 #include "exception.hh"
 
+#include <algorithm>
 #include <cstddef>
 #include <exception>
 #include <iostream>
@@ -25,7 +26,12 @@ void TCPMinnowSocket<AdaptT>::_tcp_loop( const std::function<bool()>& condition
 {
   auto base_time = timestamp_ms();
   while ( condition() ) {
-    auto ret = _eventloop.wait_next_event( TCP_TICK_MS );
+    // Wake early if pacing is due to release a segment.
+    size_t timeout_ms = TCP_TICK_MS;
+    if ( _tcp.has_value() ) {
+      timeout_ms = std::min<size_t>( timeout_ms, _tcp->ms_until_next_send().value_or( TCP_TICK_MS ) );
+    }
+    auto ret = _eventloop.wait_next_event( static_cast<int>( timeout_ms ) );
     if ( ret == TCPEventLoop::Result::Exit or _abort ) {
       break;
     }
@@ -36,7 +42,7 @@ void TCPMinnowSocket<AdaptT>::_tcp_loop( const std::function<bool()>& condition
 
     if ( _tcp.value().active() ) {
       const auto next_time = timestamp_ms();
-      _tcp.value().tick( next_time - base_time, [&]( auto x ) { _datagram_adapter.write( x ); } );
+      _tcp.value().tick_batch( next_time - base_time, [&]( auto xs ) { _datagram_adapter.write_batch( xs ); } );
       _datagram_adapter.tick( next_time - base_time );
       base_time = next_time;
     }
@@ -59,7 +65,14 @@ TCPMinnowSocket<AdaptT>::TCPMinnowSocket( std::pair<FileDescriptor, FileDescript
 template<TCPDatagramAdapter AdaptT>
 void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
 {
-  _tcp.emplace( config );
+  if ( _outbound_file ) {
+    // A segmented stream borrows the mapping instead of copying it.
+    TCPConfig borrowing = config;
+    borrowing.send_storage = ByteStream::Storage::Segmented;
+    _tcp.emplace( borrowing );
+  } else {
+    _tcp.emplace( config );
+  }
 
   // Set up the event loop
 
@@ -69,7 +82,7 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
   //
   // 2) Outbound bytes received from local application via a write()
   //    call (needs to be read from the local stream socket and
-  //    given to TCPPeer)
+  //    given to TCPPeer), or the next slice of the file from send_file()
   //
   // 3) Incoming bytes reassembled by the Reassembler
   //    (needs to be read from the inbound_stream and written
@@ -82,11 +95,11 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
     TCPEventLoop::Direction::In,
     [&] {
       if ( auto seg = _datagram_adapter.read() ) {
-        _tcp->receive( std::move( seg.value() ), [&]( auto x ) { _datagram_adapter.write( x ); } );
+        _tcp->receive_batch( std::move( seg.value() ), [&]( auto xs ) { _datagram_adapter.write_batch( xs ); } );
       }
 
       // debugging output:
-      if ( _thread_data.eof() and _tcp.value().sender().sequence_numbers_in_flight() == 0 and not _fully_acked ) {
+      if ( _outbound_shutdown and _tcp.value().sender().sequence_numbers_in_flight() == 0 and not _fully_acked ) {
         std::cerr << "DEBUG: minnow outbound stream to " << _datagram_adapter.config().destination.to_string()
                   << " has been fully acknowledged.\n";
         _fully_acked = true;
@@ -94,42 +107,50 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
     },
     [&] { return _tcp->active(); } );
 
-  // rule 2: read from pipe into outbound buffer
-  _eventloop.add_rule(
-    "push bytes to TCPPeer",
-    _thread_data,
-    TCPEventLoop::Direction::In,
-    [&] {
-      std::string data;
-      data.resize( _tcp->outbound_writer().available_capacity() );
-      _thread_data.read( data );
-      _tcp->outbound_writer().push( move( data ) );
-
-      if ( _thread_data.eof() ) {
+  const auto outbound_interest = [&] {
+    return ( _tcp->active() ) and ( not _outbound_shutdown )
+           and ( _tcp->outbound_writer().available_capacity() > 0 );
+  };
+
+  // rule 2 (send_file): lend the next slice of the mapping to TCPPeer
+  if ( _outbound_file ) {
+    _eventloop.add_rule(
+      "push file to TCPPeer",
+      [&] {
+        Writer& writer = _tcp->outbound_writer();
+        writer.push( SharedSlice { _outbound_file, _outbound_file->view().substr( writer.bytes_pushed() ) } );
+        if ( writer.bytes_pushed() == _outbound_file->view().size() ) {
+          _close_outbound();
+        }
+
+        _tcp->push_batch( [&]( auto xs ) { _datagram_adapter.write_batch( xs ); } );
+      },
+      outbound_interest );
+  } else {
+    // rule 2: read from pipe into outbound buffer
+    _eventloop.add_rule(
+      "push bytes to TCPPeer",
+      _thread_data,
+      TCPEventLoop::Direction::In,
+      [&] {
+        read_into( _thread_data, _tcp->outbound_writer() );
+
+        if ( _thread_data.eof() ) {
+          _close_outbound();
+        }
+
+        _tcp->push_batch( [&]( auto xs ) { _datagram_adapter.write_batch( xs ); } );
+      },
+      outbound_interest,
+      [&] {
         _tcp->outbound_writer().close();
         _outbound_shutdown = true;
-
-        // debugging output:
-        std::cerr << "DEBUG: minnow outbound stream to " << _datagram_adapter.config().destination.to_string()
-                  << " finished (" << _tcp.value().sender().sequence_numbers_in_flight() << " seqno"
-                  << ( _tcp.value().sender().sequence_numbers_in_flight() == 1 ? "" : "s" )
-                  << " still in flight).\n";
-      }
-
-      _tcp->push( [&]( auto x ) { _datagram_adapter.write( x ); } );
-    },
-    [&] {
-      return ( _tcp->active() ) and ( not _outbound_shutdown )
-             and ( _tcp->outbound_writer().available_capacity() > 0 );
-    },
-    [&] {
-      _tcp->outbound_writer().close();
-      _outbound_shutdown = true;
-    },
-    [&] {
-      std::cerr << "DEBUG: minnow outbound stream had error.\n";
-      _tcp->outbound_writer().set_error();
-    } );
+      },
+      [&] {
+        std::cerr << "DEBUG: minnow outbound stream had error.\n";
+        _tcp->outbound_writer().set_error();
+      } );
+  }
 
   // rule 3: read from inbound buffer into pipe
   _eventloop.add_rule(
@@ -138,14 +159,9 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
     TCPEventLoop::Direction::Out,
     [&] {
       Reader& inbound = _tcp->inbound_reader();
-      // Write from the inbound_stream into
-      // the pipe, handling the possibility of a partial
-      // write (i.e., only pop what was actually written).
-      if ( inbound.bytes_buffered() ) {
-        const std::string_view buffer = inbound.peek();
-        const auto bytes_written = _thread_data.write( buffer );
-        inbound.pop( bytes_written );
-      }
+      // Write everything buffered in the inbound_stream into the pipe with a
+      // single writev, popping only what was actually written.
+      drain_to( inbound, _thread_data );
 
       if ( inbound.is_finished() or inbound.has_error() ) {
         _thread_data.shutdown( SHUT_WR );
@@ -168,6 +184,18 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
     } );
 }
 
+template<TCPDatagramAdapter AdaptT>
+void TCPMinnowSocket<AdaptT>::_close_outbound()
+{
+  _tcp->outbound_writer().close();
+  _outbound_shutdown = true;
+
+  // debugging output:
+  std::cerr << "DEBUG: minnow outbound stream to " << _datagram_adapter.config().destination.to_string()
+            << " finished (" << _tcp.value().sender().sequence_numbers_in_flight() << " seqno"
+            << ( _tcp.value().sender().sequence_numbers_in_flight() == 1 ? "" : "s" ) << " still in flight).\n";
+}
+
 //! \brief Call [socketpair](\ref man2::socketpair) and return connected Unix-domain sockets of specified type
 //! \param[in] type is the type of AF_UNIX sockets to create (e.g., SOCK_SEQPACKET)
 //! \returns a std::pair of connected sockets
@@ -212,6 +240,15 @@ void TCPMinnowSocket<AdaptT>::wait_until_closed()
   }
 }
 
+template<TCPDatagramAdapter AdaptT>
+void TCPMinnowSocket<AdaptT>::send_file( std::shared_ptr<const MappedFile> file )
+{
+  if ( _tcp ) {
+    throw std::runtime_error( "send_file() with TCPConnection already initialized" );
+  }
+  _outbound_file = std::move( file );
+}
+
 //! \param[in] c_tcp is the TCPConfig for the TCPConnection
 //! \param[in] c_ad is the FdAdapterConfig for the FdAdapter
 template<TCPDatagramAdapter AdaptT>
@@ -231,7 +268,7 @@ void TCPMinnowSocket<AdaptT>::connect( const TCPConfig& c_tcp, const FdAdapterCo
     throw std::runtime_error( "TCPPeer not successfully initialized" );
   }
 
-  _tcp->push( [&]( auto x ) { _datagram_adapter.write( x ); } );
+  _tcp->push_batch( [&]( auto xs ) { _datagram_adapter.write_batch( xs ); } );
 
   if ( _tcp->sender().sequence_numbers_in_flight() != 1 ) {
     throw std::runtime_error( "After TCPConnection::connect(), expected sequence_numbers_in_flight() == 1" );
@@ -75,22 +75,35 @@ optional<TCPMessage> TCPOverIPv4Adapter::unwrap_tcp_in_ip( InternetDatagram ip_d
 //! \param[in] seg is the TCP segment to convert
 InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip( const TCPMessage& msg )
 {
-  const size_t payload_size = msg.sender->payload.size();
+  InternetDatagram ip_dgram;
+  const TCPSegment seg = make_segment( msg, ip_dgram.header );
+  ip_dgram.payload = serialize( seg );
+  return ip_dgram;
+}
+
+void TCPOverIPv4Adapter::serialize_tcp_in_ip( const TCPMessage& msg, Serializer& serializer )
+{
+  IPv4Header header;
+  const TCPSegment seg = make_segment( msg, header );
+  header.serialize( serializer );
+  seg.serialize( serializer );
+}
+
+//! Builds the TCP segment for `msg` and fills in the IPv4 header that carries it
+TCPSegment TCPOverIPv4Adapter::make_segment( const TCPMessage& msg, IPv4Header& header )
+{
   TCPSegment seg { .message = { msg.sender.borrow(), msg.receiver.borrow() } };
   // set the port numbers in the TCP segment
   seg.udinfo.src_port = config().source.port();
   seg.udinfo.dst_port = config().destination.port();
 
-  // create an Internet Datagram and set its addresses and length
-  InternetDatagram ip_dgram;
-  ip_dgram.header.src = config().source.ipv4_numeric();
-  ip_dgram.header.dst = config().destination.ipv4_numeric();
-  ip_dgram.header.len = ip_dgram.header.hlen * 4 + 20 /* tcp header len */ + payload_size;
-
-  // set payload, calculating TCP checksum using information from IP header
-  seg.compute_checksum( ip_dgram.header.pseudo_checksum() );
-  ip_dgram.header.compute_checksum();
-  ip_dgram.payload = serialize( seg );
+  // set the addresses and length of the Internet Datagram
+  header.src = config().source.ipv4_numeric();
+  header.dst = config().destination.ipv4_numeric();
+  header.len = header.hlen * 4 + seg.header_length() + msg.sender->payload.size();
 
-  return ip_dgram;
+  // calculate TCP checksum using information from IP header
+  seg.compute_checksum( header.pseudo_checksum() );
+  header.compute_checksum();
+  return seg;
 }
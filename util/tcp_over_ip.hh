@@ -13,4 +13,10 @@ public:
   std::optional<TCPMessage> unwrap_tcp_in_ip( InternetDatagram ip_dgram );
 
   InternetDatagram wrap_tcp_in_ip( const TCPMessage& msg );
+
+  //! Serializes the datagram wrap_tcp_in_ip() would return, without copying a shared payload
+  void serialize_tcp_in_ip( const TCPMessage& msg, Serializer& serializer );
+
+private:
+  TCPSegment make_segment( const TCPMessage& msg, IPv4Header& header );
 };
@@ -7,8 +7,12 @@
 #include "tcp_sender.hh"
 #include "tcp_sender_message.hh"
 
+#include <algorithm>
+#include <cstdint>
 #include <functional>
 #include <optional>
+#include <span>
+#include <vector>
 
 class TCPPeer
 {
@@ -17,6 +21,11 @@ class TCPPeer
     return [&]( const TCPSenderMessage& x ) { send( x, transmit ); };
   }
 
+  auto make_send_batch( const auto& transmit )
+  {
+    return [&]( std::span<const TCPSenderMessage> xs ) { send_batch( xs, transmit ); };
+  }
+
 public:
   explicit TCPPeer( const TCPConfig& cfg ) : cfg_( cfg ) {}
 
@@ -26,6 +35,9 @@ public:
   /* Type of the `transmit` function that the push and tick methods can use to send messages */
   using TransmitFunction = std::function<void( TCPMessage )>;
 
+  /* As above, for an adapter that takes a train of messages at once */
+  using BatchTransmitFunction = std::function<void( std::span<const TCPMessage> )>;
+
   /* Passthrough methods */
   void push( const TransmitFunction& transmit ) { sender_.push( make_send( transmit ) ); }
   void tick( uint64_t t, const TransmitFunction& transmit )
@@ -33,7 +45,14 @@ public:
     cumulative_time_ += t;
     sender_.tick( t, make_send( transmit ) );
   }
+  void push_batch( const BatchTransmitFunction& transmit ) { sender_.push_batch( make_send_batch( transmit ) ); }
+  void tick_batch( uint64_t t, const BatchTransmitFunction& transmit )
+  {
+    cumulative_time_ += t;
+    sender_.tick_batch( t, make_send_batch( transmit ) );
+  }
   bool has_ackno() const { return receiver_.send().ackno.has_value(); }
+  std::optional<uint64_t> ms_until_next_send() const { return sender_.ms_until_next_send(); }
 
   /* Is the peer still active? */
   bool active() const
@@ -49,10 +68,59 @@ public:
 
   void receive( TCPMessage msg, const TransmitFunction& transmit )
   {
-    if ( not active() ) {
+    if ( not deliver( std::move( msg ) ) ) {
+      return;
+    }
+
+    // Send reply if needed.
+    push( transmit );
+    if ( need_send_ ) {
+      send( sender_.make_empty_message(), transmit );
+    }
+    check_linger();
+  }
+
+  void receive_batch( TCPMessage msg, const BatchTransmitFunction& transmit )
+  {
+    if ( not deliver( std::move( msg ) ) ) {
       return;
     }
 
+    push_batch( transmit );
+    if ( need_send_ ) {
+      const TCPSenderMessage empty = sender_.make_empty_message();
+      send_batch( { &empty, 1 }, transmit );
+    }
+    check_linger();
+  }
+
+  // Testing interface
+  const TCPReceiver& receiver() const { return receiver_; }
+  const TCPSender& sender() const { return sender_; }
+
+private:
+  TCPConfig cfg_;
+  // A ring by default, so read_into() from the application's socket lands in the stream without staging.
+  TCPSender sender_ { ByteStream { cfg_.send_capacity, cfg_.send_storage },
+                      cfg_.isn,
+                      cfg_.rt_timeout,
+                      cfg_.congestion_control,
+                      cfg_.adaptive_rto,
+                      cfg_.pacing,
+                      cfg_.mss,
+                      cfg_.fast_retransmit };
+  TCPReceiver receiver_ { Reassembler { ByteStream { cfg_.recv_capacity }, cfg_.reassembler_tracking } };
+
+  bool need_send_ {};
+  std::vector<TCPMessage> batch_ {};
+
+  // Give an incoming message to the receiver and sender; false if the peer is no longer active.
+  bool deliver( TCPMessage msg )
+  {
+    if ( not active() ) {
+      return false;
+    }
+
     // Record time in case this peer has to linger after streams finish.
     time_of_last_receipt_ = cumulative_time_;
 
@@ -69,33 +137,41 @@ public:
 
     // Give incoming TCPReceiverMessage to sender.
     sender_.receive( msg.receiver );
+    return true;
+  }
 
-    // Send reply if needed.
-    push( transmit );
-    if ( need_send_ ) {
-      send( sender_.make_empty_message(), transmit );
-    }
-
-    // Did the inbound stream finish before the outbound stream? If so, no need to linger after streams finish.
+  // Did the inbound stream finish before the outbound stream? If so, no need to linger after streams finish.
+  void check_linger()
+  {
     if ( receiver_.writer().is_closed() and not std::as_const( sender_ ).reader().is_finished() ) {
       linger_after_streams_finish_ = false;
     }
   }
 
-  // Testing interface
-  const TCPReceiver& receiver() const { return receiver_; }
-  const TCPSender& sender() const { return sender_; }
-
-private:
-  TCPConfig cfg_;
-  TCPSender sender_ { ByteStream { cfg_.send_capacity }, cfg_.isn, cfg_.rt_timeout };
-  TCPReceiver receiver_ { Reassembler { ByteStream { cfg_.recv_capacity } } };
-
-  bool need_send_ {};
+  // Our SYN advertises the largest segment we take, as the MSS option.
+  TCPMessage make_message( const TCPSenderMessage& sender_message ) const
+  {
+    TCPMessage msg { borrow( sender_message ), receiver_.send() };
+    if ( sender_message.SYN ) {
+      msg.receiver.get_mut().mss = static_cast<uint16_t>( std::min<size_t>( cfg_.mss, UINT16_MAX ) );
+    }
+    return msg;
+  }
 
   void send( const TCPSenderMessage& sender_message, const TransmitFunction& transmit )
   {
-    transmit( { borrow( sender_message ), receiver_.send() } );
+    transmit( make_message( sender_message ) );
+    need_send_ = false;
+  }
+
+  void send_batch( std::span<const TCPSenderMessage> sender_messages, const BatchTransmitFunction& transmit )
+  {
+    batch_.clear();
+    for ( const TCPSenderMessage& sender_message : sender_messages ) {
+      batch_.push_back( make_message( sender_message ) );
+    }
+    transmit( batch_ );
+    batch_.clear();
     need_send_ = false;
   }
 
@@ -2,12 +2,16 @@
 
 #include "wrapping_integers.hh"
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <optional>
+#include <span>
 
 /*
  * The TCPReceiverMessage structure contains the information sent from a TCP receiver to its sender.
  *
- * It contains three fields:
+ * It contains these fields:
  *
  * 1) The acknowledgment number (ackno): the *next* sequence number needed by the TCP Receiver.
  *    This is an optional field that is empty if the TCPReceiver hasn't yet received the Initial Sequence Number.
@@ -17,11 +21,33 @@
  *    the <cstdint> header).
  *
  * 3) The RST (reset) flag. If set, the stream has suffered an error and the connection should be aborted.
+ *
+ * 4) Up to four SACK blocks (RFC 2018): ranges beyond the ackno that have already arrived, the one
+ *    holding the most recently received segment first. A sender may skip retransmitting them.
+ *
+ * 5) The MSS (RFC 9293 section 3.7.1): the largest payload this end accepts in one segment. It is
+ *    only advertised on a segment carrying a SYN, and the sender never sends more in one.
  */
 
+// A SACK block covers the sequence numbers [left, right).
+struct SackBlock
+{
+  Wrap32 left { 0 };
+  Wrap32 right { 0 };
+};
+
 struct TCPReceiverMessage
 {
+  static constexpr size_t MAX_SACK_BLOCKS = 4; // as many as fit in the TCP option space
+
   std::optional<Wrap32> ackno {};
   uint16_t window_size {};
   bool RST {};
+
+  std::array<SackBlock, MAX_SACK_BLOCKS> sack_blocks {};
+  uint8_t sack_block_count {};
+
+  std::optional<uint16_t> mss {};
+
+  std::span<const SackBlock> sack() const { return { sack_blocks.data(), sack_block_count }; }
 };
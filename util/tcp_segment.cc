@@ -9,6 +9,83 @@ using namespace std;
 
 static_assert( !( TCPSegment::HEADER_LENGTH & 0x03 ) ); // header length must be divisible by 4
 
+namespace {
+
+// TCP option kinds (RFC 9293 section 3.2, RFC 2018)
+constexpr uint8_t OPTION_END = 0;
+constexpr uint8_t OPTION_NOP = 1;
+constexpr uint8_t OPTION_MSS = 2;
+constexpr uint8_t OPTION_SACK = 5;
+
+constexpr uint8_t MSS_OPTION_LENGTH = 4;
+constexpr uint8_t SACK_BLOCK_LENGTH = 8;
+
+// Bytes of option space used to send `count` SACK blocks: two NOPs to align the blocks
+// on 32-bit boundaries, then kind, length, and the blocks themselves.
+constexpr uint8_t sack_option_space( size_t count )
+{
+  return count ? 4 + SACK_BLOCK_LENGTH * count : 0;
+}
+static_assert( TCPSegment::HEADER_LENGTH + sack_option_space( TCPReceiverMessage::MAX_SACK_BLOCKS ) <= 60 );
+
+// With an MSS option (only ever on a SYN, so in practice with no SACK blocks), one block fewer fits.
+constexpr size_t MAX_SACK_BLOCKS_WITH_MSS = TCPReceiverMessage::MAX_SACK_BLOCKS - 1;
+static_assert( TCPSegment::HEADER_LENGTH + MSS_OPTION_LENGTH + sack_option_space( MAX_SACK_BLOCKS_WITH_MSS )
+               <= 60 );
+
+// How many of the receiver's SACK blocks fit alongside its other options.
+size_t sack_blocks_sent( const TCPReceiverMessage& receiver )
+{
+  return min<size_t>( receiver.sack_block_count, receiver.mss.has_value() ? MAX_SACK_BLOCKS_WITH_MSS : SIZE_MAX );
+}
+
+uint32_t read_uint32( string_view bytes )
+{
+  uint32_t ret = 0;
+  for ( const char c : bytes.substr( 0, 4 ) ) {
+    ret = ( ret << 8 ) | static_cast<uint8_t>( c );
+  }
+  return ret;
+}
+
+// Pick out the options we understand (MSS and SACK) and skip the rest.
+// A malformed option ends the walk, but the segment itself is still accepted.
+void parse_options( string_view options, TCPReceiverMessage& receiver )
+{
+  while ( not options.empty() ) {
+    const uint8_t kind = options[0];
+    if ( kind == OPTION_END ) {
+      return;
+    }
+    if ( kind == OPTION_NOP ) {
+      options.remove_prefix( 1 );
+      continue;
+    }
+    if ( options.size() < 2 ) {
+      return;
+    }
+    const uint8_t length = options[1];
+    if ( length < 2 or length > options.size() ) {
+      return;
+    }
+
+    if ( kind == OPTION_MSS and length == MSS_OPTION_LENGTH ) {
+      receiver.mss = static_cast<uint16_t>( read_uint32( options.substr( 2, 2 ) ) );
+    }
+    if ( kind == OPTION_SACK and ( length - 2 ) % SACK_BLOCK_LENGTH == 0 ) {
+      const size_t count = min<size_t>( ( length - 2 ) / SACK_BLOCK_LENGTH, TCPReceiverMessage::MAX_SACK_BLOCKS );
+      for ( size_t i = 0; i < count; ++i ) {
+        const string_view block = options.substr( 2 + i * SACK_BLOCK_LENGTH, SACK_BLOCK_LENGTH );
+        receiver.sack_blocks[i] = { Wrap32 { read_uint32( block ) }, Wrap32 { read_uint32( block.substr( 4 ) ) } };
+      }
+      receiver.sack_block_count = static_cast<uint8_t>( count );
+    }
+    options.remove_prefix( length );
+  }
+}
+
+} // namespace
+
 void TCPSegment::parse( Parser& parser, uint32_t datagram_layer_pseudo_checksum )
 {
   /* verify checksum */
@@ -48,14 +125,22 @@ void TCPSegment::parse( Parser& parser, uint32_t datagram_layer_pseudo_checksum
   parser.integer( udinfo.cksum );
   parser.integer( raw16 ); // urgent pointer
 
-  // skip any options or anything extra in the header
   if ( data_offset < ( HEADER_LENGTH >> 2 ) ) {
     parser.set_error();
     return;
   }
-  parser.remove_prefix( data_offset * 4 - HEADER_LENGTH );
+  if ( data_offset > ( HEADER_LENGTH >> 2 ) ) {
+    string options( data_offset * 4 - HEADER_LENGTH, '\0' );
+    parser.string( options );
+    if ( parser.has_error() ) {
+      return;
+    }
+    parse_options( options, message.receiver.get_mut() );
+  }
 
-  parser.concatenate_all_remaining( message.sender->payload );
+  string payload;
+  parser.concatenate_all_remaining( payload );
+  message.sender->payload = move( payload );
 }
 
 class Wrap32Serializable : public Wrap32
@@ -64,13 +149,21 @@ public:
   uint32_t raw_value() const { return raw_value_; }
 };
 
+uint8_t TCPSegment::header_length() const
+{
+  const uint8_t mss_space = message.receiver->mss.has_value() ? MSS_OPTION_LENGTH : 0;
+  return HEADER_LENGTH + mss_space + sack_option_space( sack_blocks_sent( message.receiver.get() ) );
+}
+
 void TCPSegment::serialize( Serializer& serializer ) const
 {
   serializer.integer( udinfo.src_port );
   serializer.integer( udinfo.dst_port );
   serializer.integer( Wrap32Serializable { message.sender->seqno }.raw_value() );
   serializer.integer( Wrap32Serializable { message.receiver->ackno.value_or( Wrap32 { 0 } ) }.raw_value() );
-  serializer.integer( uint8_t { ( HEADER_LENGTH >> 2 ) << 4 } ); // data offset
+  const bool has_mss = message.receiver->mss.has_value();
+  const size_t sack_count = sack_blocks_sent( message.receiver.get() );
+  serializer.integer( static_cast<uint8_t>( ( header_length() >> 2 ) << 4 ) ); // data offset
   const bool reset = message.sender->RST or message.receiver->RST;
   const uint8_t flags = ( message.receiver->ackno.has_value() ? 0b0001'0000U : 0 ) | ( reset ? 0b0000'0100U : 0 )
                         | ( message.sender->SYN ? 0b0000'0010U : 0 ) | ( message.sender->FIN ? 0b0000'0001U : 0 );
@@ -78,7 +171,27 @@ void TCPSegment::serialize( Serializer& serializer ) const
   serializer.integer( message.receiver->window_size );
   serializer.integer( udinfo.cksum );
   serializer.integer( uint16_t { 0 } ); // urgent pointer
-  serializer.buffer( message.sender->payload );
+
+  if ( has_mss ) {
+    serializer.integer( OPTION_MSS );
+    serializer.integer( MSS_OPTION_LENGTH );
+    serializer.integer( *message.receiver->mss );
+  }
+  if ( sack_count ) {
+    serializer.integer( OPTION_NOP );
+    serializer.integer( OPTION_NOP );
+    serializer.integer( OPTION_SACK );
+    serializer.integer( static_cast<uint8_t>( 2 + SACK_BLOCK_LENGTH * sack_count ) );
+    for ( const SackBlock& block : message.receiver->sack().first( sack_count ) ) {
+      serializer.integer( Wrap32Serializable { block.left }.raw_value() );
+      serializer.integer( Wrap32Serializable { block.right }.raw_value() );
+    }
+  }
+
+  // The payload goes in by reference, as a slice without an owner if the segment owns it: views() reads it in
+  // place, and only finish() copies it.
+  const SharedSlice* slice = message.sender->payload.shared();
+  serializer.buffer( slice ? *slice : SharedSlice { {}, message.sender->payload.view() } );
 }
 
 void TCPSegment::compute_checksum( uint32_t datagram_layer_pseudo_checksum )
@@ -88,7 +201,7 @@ void TCPSegment::compute_checksum( uint32_t datagram_layer_pseudo_checksum )
   serialize( s );
 
   InternetChecksum check { datagram_layer_pseudo_checksum };
-  check.add( s.finish() );
+  check.add( s.views() );
   udinfo.cksum = check.value();
 }
 
@@ -113,6 +226,13 @@ string TCPSegment::to_string() const
   if ( ackno.has_value() ) {
     ss << " ACK<" << Wrap32Serializable { *ackno }.raw_value() << ">";
   }
+  for ( const SackBlock& block : message.receiver->sack() ) {
+    ss << " SACK<" << Wrap32Serializable { block.left }.raw_value() << "-"
+       << Wrap32Serializable { block.right }.raw_value() << ">";
+  }
+  if ( message.receiver->mss.has_value() ) {
+    ss << " MSS<" << *message.receiver->mss << ">";
+  }
   ss << " winsize=" << message.receiver->window_size;
   ss << " src=" << udinfo.src_port << " dst=" << udinfo.dst_port;
   return ss.str();
@@ -23,11 +23,12 @@ struct TCPSegment
   UserDatagramInfo udinfo {};
 
   void parse( Parser& parser, uint32_t datagram_layer_pseudo_checksum );
-  void serialize( Serializer& serializer ) const;
+  void serialize( Serializer& serializer ) const; // borrows the payload until the Serializer is done
 
   void compute_checksum( uint32_t datagram_layer_pseudo_checksum );
 
   static constexpr uint8_t HEADER_LENGTH = 20; // TCP header length, not including options
+  uint8_t header_length() const;               // as serialize() writes it, options included
 
   // Return a string containing a summary in human-readable format
   std::string to_string() const;
@@ -1,9 +1,14 @@
 #pragma once
 
+#include "shared_slice.hh"
 #include "wrapping_integers.hh"
 
+#include <cstddef>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
 /*
  * The TCPSenderMessage structure contains the information sent from a TCP sender to its receiver.
  *
@@ -15,19 +20,55 @@
  * 2) The SYN flag. If set, this segment is the beginning of the byte stream, and the seqno field
  *    contains the Initial Sequence Number (ISN) -- the zero point.
  *
- * 3) The payload: a substring (possibly empty) of the byte stream.
+ * 3) The payload: a substring (possibly empty) of the byte stream. The message either owns it, or holds
+ *    a SharedSlice of storage kept elsewhere (the TCPSender's send buffer), so that a segment can be
+ *    sent, kept for retransmission and sent again without its bytes being copied.
  *
  * 4) The FIN flag. If set, the payload represents the ending of the byte stream.
  *
  * 5) The RST (reset) flag. If set, the stream has suffered an error and the connection should be aborted.
  */
 
+// The bytes of a segment: an owned string, or a refcounted view of someone else's storage.
+class Payload
+{
+public:
+  Payload() = default;
+  Payload( std::string data ) : data_( std::move( data ) ) {}    // NOLINT(*-explicit-*)
+  Payload( const char* data ) : data_( std::string { data } ) {} // NOLINT(*-explicit-*)
+  Payload( SharedSlice slice ) : data_( std::move( slice ) ) {}  // NOLINT(*-explicit-*)
+
+  std::string_view view() const
+  {
+    const auto* owned = std::get_if<std::string>( &data_ );
+    return owned ? std::string_view { *owned } : std::get<SharedSlice>( data_ ).bytes;
+  }
+  operator std::string_view() const { return view(); } // NOLINT(*-explicit-*)
+
+  size_t size() const { return view().size(); }
+  bool empty() const { return view().empty(); }
+  bool is_shared() const { return std::holds_alternative<SharedSlice>( data_ ); }
+  const SharedSlice* shared() const { return std::get_if<SharedSlice>( &data_ ); } // null if owned
+
+  // The bytes as a string of their own: moved out if owned, else copied.
+  std::string release()
+  {
+    auto* owned = std::get_if<std::string>( &data_ );
+    return owned ? std::move( *owned ) : std::string { view() };
+  }
+
+  friend bool operator==( const Payload& a, std::string_view b ) { return a.view() == b; }
+
+private:
+  std::variant<std::string, SharedSlice> data_ {};
+};
+
 struct TCPSenderMessage
 {
   Wrap32 seqno { 0 };
 
   bool SYN {};
-  std::string payload {};
+  Payload payload {};
   bool FIN {};
 
   bool RST {};
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+//! Congestion controller used by TCPSender
+enum class CongestionControlAlgorithm : uint8_t
+{
+  NewReno, //!< Slow start, congestion avoidance and multiplicative decrease (RFC 5681)
+  Cubic,   //!< Cubic window growth with HyStart++ slow-start exit (RFC 9438, RFC 9406)
+  Bbr,     //!< Model-based: paces at the estimated bottleneck bandwidth, caps in flight at 2 BDP
+  None,    //!< Flow control only: send as much as the receiver's window allows
+};
+
+//! Bounds on a retransmission timeout that adapts to measured round-trip times (RFC 6298)
+struct RtoLimits
+{
+  uint64_t min_ms = 200;    //!< Floor, as in Linux (RFC 6298 (2.4) suggests a full second)
+  uint64_t max_ms = 60'000; //!< Ceiling, backoff included (RFC 6298 (2.5))
+};
+
+//! Token-bucket pacing of the sender's segments, instead of sending whatever the window allows at once
+struct PacingConfig
+{
+  std::optional<uint64_t> rate {}; //!< Bytes per second; if unset, the congestion controller's pacing rate
+  uint64_t burst_bytes = 2'000;    //!< Bucket depth: two default-size segments may leave back to back
+};
@@ -19,7 +19,16 @@ optional<TCPMessage> TCPOverIPv4OverTunFdAdapter::read()
 
 void TCPOverIPv4OverTunFdAdapter::write( const TCPMessage& seg )
 {
-  _tun.write( serialize( wrap_tcp_in_ip( seg ) ) );
+  Serializer serializer;
+  serialize_tcp_in_ip( seg, serializer );
+  _tun.write( serializer.views() );
+}
+
+void TCPOverIPv4OverTunFdAdapter::write_batch( span<const TCPMessage> segs )
+{
+  for ( const TCPMessage& seg : segs ) {
+    write( seg );
+  }
 }
 
 //! Specialize LossyFdAdapter to TCPOverIPv4OverTunFdAdapter
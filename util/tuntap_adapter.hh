@@ -6,12 +6,15 @@
 #include "tun.hh"
 
 #include <optional>
+#include <span>
 #include <utility>
 
 template<class T>
-concept TCPDatagramAdapter = requires( T a, TCPMessage seg ) {
+concept TCPDatagramAdapter = requires( T a, TCPMessage seg, std::span<const TCPMessage> segs ) {
   { a.write( seg ) } -> std::same_as<void>;
 
+  { a.write_batch( segs ) } -> std::same_as<void>;
+
   { a.read() } -> std::same_as<std::optional<TCPMessage>>;
 };
 
@@ -31,6 +34,9 @@ public:
   //! Creates an IPv4 datagram from a TCP segment and writes it to the TUN device
   void write( const TCPMessage& seg );
 
+  //! Writes a train of segments, one datagram per write(2) since that is all a TUN device takes
+  void write_batch( std::span<const TCPMessage> segs );
+
   //! Access the underlying TUN device
   explicit operator TunFD&() { return _tun; }
 